@@ -0,0 +1,723 @@
+/*
+ * 多线程分配器基准：Larson / threadtest / cache-scratch / cache-thrash / 生产者-消费者
+ *
+ * stress.c 只有一个线程，看不出 HEAP_LOCK 真正起作用后分配器的表现。这里移植几个经典的
+ * 多线程分配器基准，每个测试依次以 1, 2, 4, ... 直到 N 个线程运行，报告吞吐量、相对单线程的
+ * 加速比，以及运行期间的常驻内存（RSS）与峰值。
+ *
+ * - larson:       服务器模拟。每个线程持有一组随机大小的块，反复随机释放一个、再分配一个；
+ *                 每跑完一代就把整组块交给新创建的线程继续，块因此总是由别的线程释放。
+ * - threadtest:   每个线程反复分配一批同样大小的对象再全部释放，总工作量在线程间平分。
+ * - cache-scratch: 被动伪共享。主线程连续分配 N 个小对象分给各线程，线程释放后反复
+ *                 分配、写入、释放同样大小的对象；分配器若把释放的位置交给别的线程，就会共享缓存行。
+ * - cache-thrash: 主动伪共享。各线程同时分配小对象并反复写入，看分配器是否把不同线程的对象放进同一缓存行。
+ * - prodcons:     生产者分配、通过单生产者单消费者环形队列交给消费者，由消费者释放（跨线程释放）。
+ *                 线程成对运行，只取偶数线程数：从 2 开始，加速比相对 2 个线程计算。
+ * - fragscan:     首次适配的扫描开销。每个线程先把堆切成数百个放不下请求的小空洞，再反复分配、释放
+ *                 一个只有堆尾放得下的块，每次分配都要越过全部空洞。用于比较空闲块索引的 SIMD 扫描
+ *                 （configHEAP_FREE_INDEX_SIMD=1）、逐个比较（=0）与不带索引时沿空闲链表查找的差别。
+ *
+ * 分配器与锁的配置在编译 heap.c 时选定，每种配置构建一个可执行文件，例如：
+ *   gcc -O2 -DconfigHEAP_HOSTED=1 bench_mt.c heap.c -o bench_heap -lpthread
+ *   gcc -O2 -DconfigHEAP_HOSTED=1 -DconfigHEAP_FREE_INDEX=1 -DBENCH_LABEL='"heap+index"' bench_mt.c heap.c -o bench_index -lpthread
+ *   gcc -O2 -DconfigHEAP_HOSTED=1 -DconfigHEAP_LARGE_OBJECT_THRESHOLD=65536 -DBENCH_LABEL='"heap+mmap"' bench_mt.c heap.c -o bench_mmap -lpthread
+ *   gcc -O2 -DBENCH_USE_SYSTEM_MALLOC bench_mt.c -o bench_libc -lpthread       （对照组）
+ * fragscan 的三组对照：
+ *   gcc -O2 -march=native -DconfigHEAP_HOSTED=1 -DBENCH_LABEL='"list"' bench_mt.c heap.c -o bench_list -lpthread
+ *   gcc -O2 -march=native -DconfigHEAP_HOSTED=1 -DconfigHEAP_FREE_INDEX=1 -DconfigHEAP_FREE_INDEX_SIMD=0 -DBENCH_LABEL='"scalar"' bench_mt.c heap.c -o bench_scalar -lpthread
+ *   gcc -O2 -march=native -DconfigHEAP_HOSTED=1 -DconfigHEAP_FREE_INDEX=1 -DBENCH_LABEL='"simd"' bench_mt.c heap.c -o bench_simd -lpthread
+ * 以 -DconfigHEAP_LOCK_STATS=1 构建时，每次运行后还会按调用路径输出堆锁的竞争比例、
+ * 等锁与持锁时间的总和和 p50 / p99（周期计数）。
+ * 再逐个运行：
+ *   for b in ./bench_*; do $b all 8; done
+ *
+ * 用法：bench_mt [测试名|all] [最大线程数] [定时测试的秒数]
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef BENCH_USE_SYSTEM_MALLOC
+    #define BENCH_MALLOC( x )    malloc( x )
+    #define BENCH_FREE( p )      free( p )
+    #ifndef BENCH_LABEL
+        #define BENCH_LABEL      "libc"
+    #endif
+#else
+    #include "heap.h"
+    #define BENCH_MALLOC( x )    pvPortMalloc( x )
+    #define BENCH_FREE( p )      vPortFree( p )
+    #ifndef BENCH_LABEL
+        #define BENCH_LABEL      "heap.c"
+    #endif
+#endif
+
+#define MAX_THREADS              256
+
+#if !defined( BENCH_USE_SYSTEM_MALLOC ) && defined( configHEAP_LOCK_STATS ) && ( configHEAP_LOCK_STATS == 1 )
+    #define BENCH_LOCK_STATS         1
+#else
+    #define BENCH_LOCK_STATS         0
+#endif
+
+/* larson 参数：每线程的块数、块大小范围、每一代的操作数 */
+#define LARSON_SLOTS             1000
+#define LARSON_MIN_SIZE          8
+#define LARSON_MAX_SIZE          1000
+#define LARSON_OPS_PER_ROUND     10000
+
+/* threadtest 参数：总轮数、每轮对象总数（在线程间平分）、对象大小 */
+#define THREADTEST_ROUNDS        50
+#define THREADTEST_OBJECTS       100000
+#define THREADTEST_SIZE          64
+
+/* cache-scratch / cache-thrash 参数：总迭代数（在线程间平分）、每个对象的写入次数、对象大小 */
+#define CACHE_ITERATIONS         20000
+#define CACHE_REPETITIONS        2000
+#define CACHE_OBJECT_SIZE        8
+
+/* fragscan 参数：每线程留下的小空洞数、空洞大小、每次要找的块大小（只有堆尾放得下） */
+#define FRAGSCAN_HOLES           400
+#define FRAGSCAN_HOLE_SIZE       32
+#define FRAGSCAN_WANTED_SIZE     256
+
+/* prodcons 参数：环形队列长度（2 的幂）、消息大小范围 */
+#define PRODCONS_QUEUE_SIZE      1024
+#define PRODCONS_MIN_SIZE        16
+#define PRODCONS_MAX_SIZE        512
+
+typedef struct
+{
+    const char * name;
+    uint64_t ( *run )( int threads ); /* 返回完成的操作数（一次分配加一次释放算一次） */
+    int min_threads;                   /* 最少线程数，线程数也按它的倍数取整 */
+} bench_t;
+
+static double run_seconds = 1.0;
+static int stop_flag = 0; /* 定时测试的停止标记，只用 relaxed 原子操作读写 */
+
+#define STOP_REQUESTED()         ( __atomic_load_n( &stop_flag, __ATOMIC_RELAXED ) != 0 )
+#define SET_STOP( x )            __atomic_store_n( &stop_flag, ( x ), __ATOMIC_RELAXED )
+
+static double now_seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+static uint32_t next_random( uint32_t * state )
+{
+    /* xorshift32：每个线程各用一份状态，不共享 */
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static size_t random_size( uint32_t * state, size_t min, size_t max )
+{
+    return min + ( next_random( state ) % ( max - min + 1 ) );
+}
+
+/* 从 /proc/self/status 读取 VmRSS 或 VmHWM（KiB），读不到返回 0 */
+static size_t read_status_kib( const char * key )
+{
+    FILE * f = fopen( "/proc/self/status", "r" );
+    char line[ 256 ];
+    size_t value = 0;
+    size_t key_len = strlen( key );
+
+    if( f == NULL )
+    {
+        return 0;
+    }
+
+    while( fgets( line, sizeof( line ), f ) != NULL )
+    {
+        if( ( strncmp( line, key, key_len ) == 0 ) && ( line[ key_len ] == ':' ) )
+        {
+            value = ( size_t ) strtoull( line + key_len + 1, NULL, 10 );
+            break;
+        }
+    }
+
+    fclose( f );
+    return value;
+}
+
+/* 把 VmHWM 重置为当前 RSS（Linux 4.0 起支持），每次运行分别统计峰值 */
+static void reset_peak_rss( void )
+{
+    FILE * f = fopen( "/proc/self/clear_refs", "w" );
+
+    if( f != NULL )
+    {
+        fputs( "5", f );
+        fclose( f );
+    }
+}
+
+static void start_threads( pthread_t * tids, int threads, void * ( *fn )( void * ), void * args, size_t arg_size )
+{
+    int i;
+
+    for( i = 0; i < threads; i++ )
+    {
+        if( pthread_create( &tids[ i ], NULL, fn, ( char * ) args + ( size_t ) i * arg_size ) != 0 )
+        {
+            fprintf( stderr, "pthread_create failed\n" );
+            exit( 1 );
+        }
+    }
+}
+
+static void join_threads( pthread_t * tids, int threads )
+{
+    int i;
+
+    for( i = 0; i < threads; i++ )
+    {
+        pthread_join( tids[ i ], NULL );
+    }
+}
+
+/* ---------------------------------------------------------------- larson */
+
+typedef struct
+{
+    void * slots[ LARSON_SLOTS ];
+    uint32_t seed;
+    uint64_t ops;
+    volatile int done;
+} larson_lane_t;
+
+static void * larson_worker( void * arg )
+{
+    larson_lane_t * lane = arg;
+    pthread_t successor;
+    int i;
+
+    for( ; ; )
+    {
+        for( i = 0; ( i < LARSON_OPS_PER_ROUND ) && !STOP_REQUESTED(); i++ )
+        {
+            uint32_t slot = next_random( &lane->seed ) % LARSON_SLOTS;
+            size_t size = random_size( &lane->seed, LARSON_MIN_SIZE, LARSON_MAX_SIZE );
+
+            BENCH_FREE( lane->slots[ slot ] );
+            lane->slots[ slot ] = BENCH_MALLOC( size );
+
+            if( lane->slots[ slot ] != NULL )
+            {
+                ( ( char * ) lane->slots[ slot ] )[ 0 ] = ( char ) slot;
+            }
+        }
+
+        lane->ops += ( uint64_t ) i;
+
+        if( STOP_REQUESTED() )
+        {
+            __atomic_store_n( &lane->done, 1, __ATOMIC_RELEASE );
+            return NULL;
+        }
+
+        /* 一代结束：由新线程接手这组块，之后的释放都发生在另一个线程上；创建失败就在本线程继续 */
+        if( pthread_create( &successor, NULL, larson_worker, lane ) == 0 )
+        {
+            pthread_detach( successor );
+            return NULL;
+        }
+    }
+}
+
+static uint64_t run_larson( int threads )
+{
+    larson_lane_t * lanes = calloc( ( size_t ) threads, sizeof( larson_lane_t ) );
+    pthread_t tids[ MAX_THREADS ];
+    uint64_t ops = 0;
+    int i, j;
+
+    for( i = 0; i < threads; i++ )
+    {
+        lanes[ i ].seed = 0x9E3779B9u * ( uint32_t ) ( i + 1 );
+
+        for( j = 0; j < LARSON_SLOTS; j++ )
+        {
+            lanes[ i ].slots[ j ] = BENCH_MALLOC( random_size( &lanes[ i ].seed, LARSON_MIN_SIZE, LARSON_MAX_SIZE ) );
+        }
+    }
+
+    /* 初始线程创建后就分离，由 done 标记判断每条链是否结束 */
+    start_threads( tids, threads, larson_worker, lanes, sizeof( larson_lane_t ) );
+
+    for( i = 0; i < threads; i++ )
+    {
+        pthread_detach( tids[ i ] );
+    }
+
+    usleep( ( useconds_t ) ( run_seconds * 1e6 ) );
+    SET_STOP( 1 );
+
+    for( i = 0; i < threads; i++ )
+    {
+        while( __atomic_load_n( &lanes[ i ].done, __ATOMIC_ACQUIRE ) == 0 )
+        {
+            sched_yield();
+        }
+
+        for( j = 0; j < LARSON_SLOTS; j++ )
+        {
+            BENCH_FREE( lanes[ i ].slots[ j ] );
+        }
+
+        ops += lanes[ i ].ops;
+    }
+
+    free( lanes );
+    return ops;
+}
+
+/* ------------------------------------------------------------ threadtest */
+
+typedef struct
+{
+    int objects;
+} threadtest_arg_t;
+
+static void * threadtest_worker( void * arg )
+{
+    int objects = ( ( threadtest_arg_t * ) arg )->objects;
+    void ** batch = malloc( ( size_t ) objects * sizeof( void * ) );
+    int round, i;
+
+    for( round = 0; round < THREADTEST_ROUNDS; round++ )
+    {
+        for( i = 0; i < objects; i++ )
+        {
+            batch[ i ] = BENCH_MALLOC( THREADTEST_SIZE );
+
+            if( batch[ i ] != NULL )
+            {
+                ( ( volatile char * ) batch[ i ] )[ 0 ] = ( char ) i;
+            }
+        }
+
+        for( i = 0; i < objects; i++ )
+        {
+            BENCH_FREE( batch[ i ] );
+        }
+    }
+
+    free( batch );
+    return NULL;
+}
+
+static uint64_t run_threadtest( int threads )
+{
+    threadtest_arg_t args[ MAX_THREADS ];
+    pthread_t tids[ MAX_THREADS ];
+    int i;
+
+    for( i = 0; i < threads; i++ )
+    {
+        args[ i ].objects = THREADTEST_OBJECTS / threads;
+    }
+
+    start_threads( tids, threads, threadtest_worker, args, sizeof( threadtest_arg_t ) );
+    join_threads( tids, threads );
+
+    return ( uint64_t ) THREADTEST_ROUNDS * ( uint64_t ) ( THREADTEST_OBJECTS / threads ) * ( uint64_t ) threads;
+}
+
+/* ------------------------------------------------- cache-scratch / thrash */
+
+typedef struct
+{
+    void * handoff; /* cache-scratch：主线程分配、由本线程释放的对象；cache-thrash 为 NULL */
+    int iterations;
+} cache_arg_t;
+
+static void * cache_worker( void * arg )
+{
+    cache_arg_t * cache = arg;
+    int i, j;
+
+    BENCH_FREE( cache->handoff );
+
+    for( i = 0; i < cache->iterations; i++ )
+    {
+        volatile char * obj = BENCH_MALLOC( CACHE_OBJECT_SIZE );
+
+        if( obj == NULL )
+        {
+            continue;
+        }
+
+        for( j = 0; j < CACHE_REPETITIONS; j++ )
+        {
+            obj[ j % CACHE_OBJECT_SIZE ]++;
+        }
+
+        BENCH_FREE( ( void * ) obj );
+    }
+
+    return NULL;
+}
+
+static uint64_t run_cache( int threads, int scratch )
+{
+    cache_arg_t args[ MAX_THREADS ];
+    pthread_t tids[ MAX_THREADS ];
+    int i;
+
+    /* 连续分配，使相邻线程拿到的初始对象尽可能落在同一缓存行 */
+    for( i = 0; i < threads; i++ )
+    {
+        args[ i ].handoff = ( scratch != 0 ) ? BENCH_MALLOC( CACHE_OBJECT_SIZE ) : NULL;
+        args[ i ].iterations = CACHE_ITERATIONS / threads;
+    }
+
+    start_threads( tids, threads, cache_worker, args, sizeof( cache_arg_t ) );
+    join_threads( tids, threads );
+
+    return ( uint64_t ) ( CACHE_ITERATIONS / threads ) * ( uint64_t ) threads;
+}
+
+static uint64_t run_cache_scratch( int threads )
+{
+    return run_cache( threads, 1 );
+}
+
+static uint64_t run_cache_thrash( int threads )
+{
+    return run_cache( threads, 0 );
+}
+
+/* -------------------------------------------------------------- prodcons */
+
+typedef struct
+{
+    void * ring[ PRODCONS_QUEUE_SIZE ];
+    uint64_t head __attribute__( ( aligned( 64 ) ) ); /* 消费者写 */
+    uint64_t tail __attribute__( ( aligned( 64 ) ) ); /* 生产者写 */
+    uint64_t ops __attribute__( ( aligned( 64 ) ) );
+} prodcons_pair_t;
+
+static void * producer_worker( void * arg )
+{
+    prodcons_pair_t * pair = arg;
+    uint32_t seed = ( uint32_t ) ( uintptr_t ) arg | 1u;
+    uint64_t tail = 0;
+    void * msg;
+
+    for( ; ; )
+    {
+        /* 停止时发送 NULL 作为结束标记 */
+        msg = NULL;
+
+        if( !STOP_REQUESTED() )
+        {
+            size_t size = random_size( &seed, PRODCONS_MIN_SIZE, PRODCONS_MAX_SIZE );
+
+            msg = BENCH_MALLOC( size );
+
+            if( msg == NULL )
+            {
+                continue;
+            }
+
+            ( ( char * ) msg )[ size - 1 ] = 1;
+        }
+
+        while( ( tail - __atomic_load_n( &pair->head, __ATOMIC_ACQUIRE ) ) == PRODCONS_QUEUE_SIZE )
+        {
+            sched_yield();
+        }
+
+        pair->ring[ tail & ( PRODCONS_QUEUE_SIZE - 1 ) ] = msg;
+        __atomic_store_n( &pair->tail, ++tail, __ATOMIC_RELEASE );
+
+        if( msg == NULL )
+        {
+            return NULL;
+        }
+    }
+}
+
+static void * consumer_worker( void * arg )
+{
+    prodcons_pair_t * pair = arg;
+    uint64_t head = 0;
+    void * msg;
+
+    for( ; ; )
+    {
+        while( __atomic_load_n( &pair->tail, __ATOMIC_ACQUIRE ) == head )
+        {
+            sched_yield();
+        }
+
+        msg = pair->ring[ head & ( PRODCONS_QUEUE_SIZE - 1 ) ];
+        __atomic_store_n( &pair->head, ++head, __ATOMIC_RELEASE );
+
+        if( msg == NULL )
+        {
+            return NULL;
+        }
+
+        BENCH_FREE( msg );
+        pair->ops++;
+    }
+}
+
+static uint64_t run_prodcons( int threads )
+{
+    /* 线程成对运行，run_bench 只传入偶数 */
+    int pairs = threads / 2;
+    prodcons_pair_t * pair_array = aligned_alloc( 64, ( size_t ) pairs * sizeof( prodcons_pair_t ) );
+    pthread_t producers[ MAX_THREADS ];
+    pthread_t consumers[ MAX_THREADS ];
+    uint64_t ops = 0;
+    int i;
+
+    memset( pair_array, 0, ( size_t ) pairs * sizeof( prodcons_pair_t ) );
+
+    start_threads( consumers, pairs, consumer_worker, pair_array, sizeof( prodcons_pair_t ) );
+    start_threads( producers, pairs, producer_worker, pair_array, sizeof( prodcons_pair_t ) );
+
+    usleep( ( useconds_t ) ( run_seconds * 1e6 ) );
+    SET_STOP( 1 );
+
+    join_threads( producers, pairs );
+    join_threads( consumers, pairs );
+
+    for( i = 0; i < pairs; i++ )
+    {
+        ops += pair_array[ i ].ops;
+    }
+
+    free( pair_array );
+    return ops;
+}
+
+/* -------------------------------------------------------------- fragscan */
+
+typedef struct
+{
+    uint64_t ops;
+} fragscan_arg_t;
+
+static void * fragscan_worker( void * arg )
+{
+    fragscan_arg_t * fragscan = arg;
+    void * blocks[ FRAGSCAN_HOLES * 2 ];
+    uint64_t ops = 0;
+    int i;
+
+    /* 交替释放，留下 FRAGSCAN_HOLES 个互不相邻、放不下请求的空洞 */
+    for( i = 0; i < FRAGSCAN_HOLES * 2; i++ )
+    {
+        blocks[ i ] = BENCH_MALLOC( FRAGSCAN_HOLE_SIZE );
+    }
+
+    for( i = 0; i < FRAGSCAN_HOLES * 2; i += 2 )
+    {
+        BENCH_FREE( blocks[ i ] );
+    }
+
+    while( !STOP_REQUESTED() )
+    {
+        for( i = 0; i < 1000; i++ )
+        {
+            void * p = BENCH_MALLOC( FRAGSCAN_WANTED_SIZE );
+
+            if( p != NULL )
+            {
+                ( ( volatile char * ) p )[ 0 ] = ( char ) i;
+            }
+
+            BENCH_FREE( p );
+        }
+
+        ops += 1000;
+    }
+
+    for( i = 1; i < FRAGSCAN_HOLES * 2; i += 2 )
+    {
+        BENCH_FREE( blocks[ i ] );
+    }
+
+    fragscan->ops = ops;
+    return NULL;
+}
+
+static uint64_t run_fragscan( int threads )
+{
+    fragscan_arg_t args[ MAX_THREADS ];
+    pthread_t tids[ MAX_THREADS ];
+    uint64_t ops = 0;
+    int i;
+
+    start_threads( tids, threads, fragscan_worker, args, sizeof( fragscan_arg_t ) );
+
+    usleep( ( useconds_t ) ( run_seconds * 1e6 ) );
+    SET_STOP( 1 );
+
+    join_threads( tids, threads );
+
+    for( i = 0; i < threads; i++ )
+    {
+        ops += args[ i ].ops;
+    }
+
+    return ops;
+}
+
+/* ------------------------------------------------------------------ main */
+
+#if ( BENCH_LOCK_STATS == 1 )
+static void print_lock_stats( void )
+{
+    static const char * const path_names[ eHeapLockPathCount ] = { "malloc", "free", "stats", "other" };
+    static HeapLockStats_t stats; /* 直方图较大，不放在栈上 */
+    int i;
+
+    vPortGetHeapLockStats( &stats );
+
+    for( i = 0; i < eHeapLockPathCount; i++ )
+    {
+        const HeapLockPathStats_t * path = &stats.xPaths[ i ];
+
+        if( path->xAcquisitions == 0 )
+        {
+            continue;
+        }
+
+        printf( "    lock %-6s acq %10zu  contended %6.2f%%  wait %12llu (p50 %llu p99 %llu)  hold %12llu (p50 %llu p99 %llu)\n",
+                path_names[ i ], path->xAcquisitions, 100.0 * ( double ) path->xContended / ( double ) path->xAcquisitions,
+                ( unsigned long long ) path->uxWaitCycles,
+                ( unsigned long long ) uxPortHeapLatencyPercentile( path->xWaitHistogram, 500 ),
+                ( unsigned long long ) uxPortHeapLatencyPercentile( path->xWaitHistogram, 990 ),
+                ( unsigned long long ) path->uxHoldCycles,
+                ( unsigned long long ) uxPortHeapLatencyPercentile( path->xHoldHistogram, 500 ),
+                ( unsigned long long ) uxPortHeapLatencyPercentile( path->xHoldHistogram, 990 ) );
+    }
+}
+#endif
+
+static const bench_t benches[] =
+{
+    { "larson",        run_larson,        1 },
+    { "threadtest",    run_threadtest,    1 },
+    { "cache-scratch", run_cache_scratch, 1 },
+    { "cache-thrash",  run_cache_thrash,  1 },
+    { "prodcons",      run_prodcons,      2 },
+    { "fragscan",      run_fragscan,      1 },
+};
+
+static void run_bench( const bench_t * bench, int max_threads )
+{
+    double base_rate = 0.0;
+    int threads = bench->min_threads;
+
+    /* 上限向下取整到 min_threads 的倍数，但至少运行一次 */
+    max_threads -= max_threads % bench->min_threads;
+
+    if( max_threads < bench->min_threads )
+    {
+        max_threads = bench->min_threads;
+    }
+
+    for( ; ; )
+    {
+        double start, elapsed, rate;
+        uint64_t ops;
+
+        SET_STOP( 0 );
+        reset_peak_rss();
+
+        #if ( BENCH_LOCK_STATS == 1 )
+            vPortResetHeapLockStats();
+        #endif
+
+        start = now_seconds();
+        ops = bench->run( threads );
+        elapsed = now_seconds() - start;
+        rate = ( double ) ops / elapsed;
+
+        if( threads == bench->min_threads )
+        {
+            base_rate = rate;
+        }
+
+        printf( "%-8s %-14s %7d %12.3f %9.2fx %10.1f %10.1f\n",
+                BENCH_LABEL, bench->name, threads, rate / 1e6, rate / base_rate,
+                ( double ) read_status_kib( "VmRSS" ) / 1024.0,
+                ( double ) read_status_kib( "VmHWM" ) / 1024.0 );
+
+        #if ( BENCH_LOCK_STATS == 1 )
+            print_lock_stats();
+        #endif
+
+        fflush( stdout );
+
+        if( threads >= max_threads )
+        {
+            break;
+        }
+
+        /* 1, 2, 4, ...（成对运行时 2, 4, 8, ...）最后一次恰好是 max_threads */
+        threads = ( threads * 2 > max_threads ) ? max_threads : threads * 2;
+    }
+}
+
+int main( int argc, char ** argv )
+{
+    const char * which = ( argc > 1 ) ? argv[ 1 ] : "all";
+    int max_threads = ( argc > 2 ) ? atoi( argv[ 2 ] ) : ( int ) sysconf( _SC_NPROCESSORS_ONLN );
+    size_t i;
+    int found = 0;
+
+    if( argc > 3 )
+    {
+        run_seconds = atof( argv[ 3 ] );
+    }
+
+    if( max_threads < 1 )
+    {
+        max_threads = 1;
+    }
+
+    if( max_threads > MAX_THREADS )
+    {
+        max_threads = MAX_THREADS;
+    }
+
+    printf( "%-8s %-14s %7s %12s %10s %10s %10s\n", "alloc", "test", "threads", "Mops/s", "speedup", "rss(MiB)", "peak(MiB)" );
+
+    for( i = 0; i < sizeof( benches ) / sizeof( benches[ 0 ] ); i++ )
+    {
+        if( ( strcmp( which, "all" ) == 0 ) || ( strcmp( which, benches[ i ].name ) == 0 ) )
+        {
+            run_bench( &benches[ i ], max_threads );
+            found = 1;
+        }
+    }
+
+    if( found == 0 )
+    {
+        fprintf( stderr, "usage: %s [larson|threadtest|cache-scratch|cache-thrash|prodcons|all] [max_threads] [seconds]\n", argv[ 0 ] );
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,289 +1,5289 @@
-/*
- * 基于 FreeRTOS 内存管理模块修改
- * Original: FreeRTOS Kernel V11.1.0
- * Copyright (C) 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
- * 
- * SPDX-License-Identifier: MIT
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * 本文件基于 FreeRTOS 的内存管理模块进行修改和优化，适用于嵌入式系统。
- * 修改内容包括：去除了 FreeRTOS 特定依赖、简化了配置选项、增加了中文注释等。
- */
-
-#include <stdlib.h>
-#include <string.h>
-#include "heap.h"
-
-/**
- * @brief 堆内存的总大小（字节）。
- * 用户应根据 MCU 的 RAM 资源和应用需求调整此值。
- */
-#define configTOTAL_HEAP_SIZE               ( ( size_t ) 40960 )
-
-/**
- * @brief 内存对齐字节数。
- * 必须是 2 的幂。通常 32 位系统设为 4 或 8（Cortex-M 建议 8 字节以支持浮点运算）。
- */
-#define portBYTE_ALIGNMENT                  8
-
-/**
- * @brief 堆空间分配方式。
- * 0: 由本模块静态定义一个大的 uint8_t 数组作为堆池。
- * 1: 用户在外部定义名为 ucHeap 的数组（方便通过链接脚本定位到特定的 RAM 段）。
- */
-#define configAPPLICATION_ALLOCATED_HEAP    0
-
-/**
- * @brief 释放内存时是否自动清零。
- * 1: vPortFree 时将用户区清零，增加安全性，防止敏感数据残留，也方便调试。
- */
-#define configHEAP_CLEAR_MEMORY_ON_FREE     1
-
-/**
- * @brief 断言宏。
- * 用于捕捉致命错误（如释放了已被释放的内存）。生产环境下可改为复位指令。
- */
-#define configASSERT( x )                   if( ( x ) == 0 ) { for( ;; ); }
-
-
-/* 线程安全锁定机制：在多线程/抢占式环境下，需在此填入关中断或获取互斥锁的代码 */
-#define HEAP_LOCK()     
-#define HEAP_UNLOCK()   
-
-/* 字节对齐遮罩：用于计算对齐后的地址 */
-#define portBYTE_ALIGNMENT_MASK             ( portBYTE_ALIGNMENT - 1 )
-
-/* 最小空闲块大小：防止链表中出现过小的内存碎片。若分裂后的块小于此值，则不分裂 */
-#define heapMINIMUM_BLOCK_SIZE              ( ( size_t ) ( xHeapStructSize << 1 ) )
-
-/* 状态位：利用 size_t 的最高位标记该块是否已被分配（1:已分配，0:空闲） */
-#define heapBLOCK_ALLOCATED_BITMASK         ( ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * 8 ) - 1 ) )
-
-/* 检查块是否已分配 */
-#define heapBLOCK_IS_ALLOCATED( pxBlock )   ( ( ( pxBlock->xBlockSize ) & heapBLOCK_ALLOCATED_BITMASK ) != 0 )
-
-/* 标记块为已分配状态 */
-#define heapALLOCATE_BLOCK( pxBlock )       ( ( pxBlock->xBlockSize ) |= heapBLOCK_ALLOCATED_BITMASK )
-
-/* 标记块为空闲状态 */
-#define heapFREE_BLOCK( pxBlock )           ( ( pxBlock->xBlockSize ) &= ~heapBLOCK_ALLOCATED_BITMASK )
-
-
-/* --- 数据结构 --- */
-typedef struct A_BLOCK_LINK
-{
-    struct A_BLOCK_LINK * pxNextFreeBlock; /**< 指向链表中下一个空闲块 */
-    size_t xBlockSize;                     /**< 当前块的大小（包含 Header 本身） */
-} BlockLink_t;
-
-/* --- 全局变量 --- */
-#if ( configAPPLICATION_ALLOCATED_HEAP == 1 )
-    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
-#else
-    static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
-#endif
-
-/* 结构体 Header 实际占用的对齐后大小 */
-static const size_t xHeapStructSize = ( sizeof( BlockLink_t ) + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
-
-static BlockLink_t xStart;           /* 链表头指针（地址最低端） */
-static BlockLink_t * pxEnd = NULL;   /* 链表尾指针（地址最高端） */
-
-static size_t xFreeBytesRemaining = 0U;             /* 当前可用总字节数 */
-static size_t xMinimumEverFreeBytesRemaining = 0U;  /* 历史最低可用字节数（水位线） */
-static size_t xNumberOfSuccessfulAllocations = 0U;  /* 成功分配次数计数 */
-static size_t xNumberOfSuccessfulFrees = 0U;        /* 成功释放次数计数 */
-
-
-/**
- * @brief 将一个空闲块插入空闲链表。
- * 链表按内存地址从小到大排序，插入后会自动检查并合并前后相邻的空闲空间。
- */
-static void prvInsertBlockIntoFreeList( BlockLink_t * pxBlockToInsert )
-{
-    BlockLink_t * pxIterator;
-    uint8_t * puc;
-
-    /* 寻找插入位置 */
-    for( pxIterator = &xStart; pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock ) {}
-
-    /* 检查是否能与前面的块合并 */
-    puc = ( uint8_t * ) pxIterator;
-    if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
-    {
-        pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
-        pxBlockToInsert = pxIterator;
-    }
-
-    /* 检查是否能与后面的块合并 */
-    puc = ( uint8_t * ) pxBlockToInsert;
-    if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
-    {
-        if( pxIterator->pxNextFreeBlock != pxEnd )
-        {
-            pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
-            pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
-        }
-        else
-        {
-            pxBlockToInsert->pxNextFreeBlock = pxEnd;
-        }
-    }
-    else
-    {
-        pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
-    }
-
-    if( pxIterator != pxBlockToInsert )
-    {
-        pxIterator->pxNextFreeBlock = pxBlockToInsert;
-    }
-}
-
-/**
- * @brief 初始化堆池。
- * 整理 ucHeap 数组，设置链表头尾指针。
- */
-static void prvHeapInit( void )
-{
-    BlockLink_t * pxFirstFreeBlock;
-    uintptr_t uxStartAddress, uxEndAddress;
-    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
-
-    uxStartAddress = ( uintptr_t ) ucHeap;
-
-    /* 确保堆池起始地址对齐 */
-    if( ( uxStartAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
-    {
-        uxStartAddress += ( portBYTE_ALIGNMENT - 1 );
-        uxStartAddress &= ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK );
-        xTotalHeapSize -= ( size_t ) ( uxStartAddress - ( uintptr_t ) ucHeap );
-    }
-
-    xStart.pxNextFreeBlock = ( void * ) uxStartAddress;
-    xStart.xBlockSize = ( size_t ) 0;
-
-    uxEndAddress = uxStartAddress + ( uintptr_t ) xTotalHeapSize;
-    uxEndAddress -= ( uintptr_t ) xHeapStructSize;
-    uxEndAddress &= ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK );
-    pxEnd = ( BlockLink_t * ) uxEndAddress;
-    pxEnd->xBlockSize = 0;
-    pxEnd->pxNextFreeBlock = NULL;
-
-    pxFirstFreeBlock = ( BlockLink_t * ) uxStartAddress;
-    pxFirstFreeBlock->xBlockSize = ( size_t ) ( uxEndAddress - uxStartAddress );
-    pxFirstFreeBlock->pxNextFreeBlock = pxEnd;
-
-    xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
-    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
-}
-
-/* --- 公共接口实现 --- */
-
-void * pvPortMalloc( size_t xWantedSize )
-{
-    BlockLink_t * pxBlock, * pxPreviousBlock, * pxNewBlockLink;
-    void * pvReturn = NULL;
-
-    if( xWantedSize > 0 )
-    {
-        /* 加上 Header 的开销并进行对齐 */
-        xWantedSize += xHeapStructSize;
-        if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
-        {
-            xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
-        }
-    }
-
-    HEAP_LOCK();
-    {
-        if( pxEnd == NULL ) { prvHeapInit(); }
-
-        if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
-        {
-            pxPreviousBlock = &xStart;
-            pxBlock = xStart.pxNextFreeBlock;
-
-            /* 寻找第一个足够大的空闲块（First Fit） */
-            while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
-            {
-                pxPreviousBlock = pxBlock;
-                pxBlock = pxBlock->pxNextFreeBlock;
-            }
-
-            if( pxBlock != pxEnd )
-            {
-                pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
-                pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
-
-                /* 如果剩余空间足够大，则分裂该块 */
-                if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
-                {
-                    pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
-                    pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
-                    pxBlock->xBlockSize = xWantedSize;
-                    prvInsertBlockIntoFreeList( pxNewBlockLink );
-                }
-
-                xFreeBytesRemaining -= pxBlock->xBlockSize;
-                if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
-                {
-                    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
-                }
-
-                heapALLOCATE_BLOCK( pxBlock ); /* 标记为已分配 */
-                pxBlock->pxNextFreeBlock = NULL;
-                xNumberOfSuccessfulAllocations++;
-            }
-        }
-    }
-    HEAP_UNLOCK();
-
-    return pvReturn;
-}
-
-void vPortFree( void * pv )
-{
-    uint8_t * puc = ( uint8_t * ) pv;
-    BlockLink_t * pxLink;
-
-    if( pv != NULL )
-    {
-        puc -= xHeapStructSize;
-        pxLink = ( void * ) puc;
-
-        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
-        configASSERT( pxLink->pxNextFreeBlock == NULL );
-
-        if( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 )
-        {
-            heapFREE_BLOCK( pxLink );
-
-            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
-            {
-                memset( pv, 0, pxLink->xBlockSize - xHeapStructSize );
-            }
-            #endif
-
-            HEAP_LOCK();
-            {
-                xFreeBytesRemaining += pxLink->xBlockSize;
-                prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
-                xNumberOfSuccessfulFrees++;
-            }
-            HEAP_UNLOCK();
-        }
-    }
-}
-
-size_t xPortGetFreeHeapSize( void ) { return xFreeBytesRemaining; }
-size_t xPortGetMinimumEverFreeHeapSize( void ) { return xMinimumEverFreeBytesRemaining; }
\ No newline at end of file
+/*
+ * 基于 FreeRTOS 内存管理模块修改
+ * Original: FreeRTOS Kernel V11.1.0
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * 
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * 本文件基于 FreeRTOS 的内存管理模块进行修改和优化，适用于嵌入式系统。
+ * 修改内容包括：去除了 FreeRTOS 特定依赖、简化了配置选项、增加了中文注释等。
+ */
+
+/* mremap 是 Linux 扩展，需在包含任何系统头文件之前声明 */
+#if defined( __linux__ ) && !defined( _GNU_SOURCE )
+    #define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "heap.h"
+
+/**
+ * @brief 堆内存的总大小（字节）。
+ * 用户应根据 MCU 的 RAM 资源和应用需求调整此值。
+ */
+#define configTOTAL_HEAP_SIZE               ( ( size_t ) 40960 )
+
+/**
+ * @brief 宿主机（Linux 等带 mmap 的系统）模式。
+ * 0: 使用静态数组 ucHeap 作为堆池（嵌入式默认）。
+ * 1: 用 mmap 预留一大段虚拟地址作为堆池，先提交 configTOTAL_HEAP_SIZE 字节，
+ *    空间不足时按 configHEAP_HOSTED_GROW_SIZE 向高地址扩展；HEAP_LOCK 使用 pthread 互斥锁。
+ */
+#ifndef configHEAP_HOSTED
+    #define configHEAP_HOSTED               0
+#endif
+
+#if ( configHEAP_HOSTED == 1 )
+    /* 预留的虚拟地址空间上限（只占地址空间，不占物理内存） */
+    #ifndef configHEAP_HOSTED_RESERVE_SIZE
+        #if ( SIZE_MAX > 0xFFFFFFFFU )
+            #define configHEAP_HOSTED_RESERVE_SIZE  ( ( size_t ) 64 * 1024 * 1024 * 1024 )
+        #else
+            #define configHEAP_HOSTED_RESERVE_SIZE  ( ( size_t ) 1024 * 1024 * 1024 )
+        #endif
+    #endif
+
+    /* 每次扩展的最小字节数 */
+    #ifndef configHEAP_HOSTED_GROW_SIZE
+        #define configHEAP_HOSTED_GROW_SIZE     ( ( size_t ) 4 * 1024 * 1024 )
+    #endif
+
+    /* 预留区间的固定起始地址，0 表示由内核选择；固定地址便于快照在下次启动时原址恢复 */
+    #ifndef configHEAP_HOSTED_BASE_ADDRESS
+        #define configHEAP_HOSTED_BASE_ADDRESS  0
+    #endif
+
+    /**
+     * 堆池的大页支持。
+     * 0: 普通页
+     * 1: 透明大页：对预留区间 madvise( MADV_HUGEPAGE )，由内核在可能时换成大页
+     * 2: hugetlbfs 大页：每次提交都用 MAP_HUGETLB 映射（需预先配置 /proc/sys/vm/nr_hugepages），
+     *    大页不足时该次提交退回普通页，仍按 1 处理
+     * 非 0 时预留区间对齐到 configHEAP_HOSTED_HUGE_PAGE_SIZE；取 2 时提交大小也按它取整。
+     */
+    #ifndef configHEAP_HOSTED_HUGE_PAGES
+        #define configHEAP_HOSTED_HUGE_PAGES    0
+    #endif
+
+    #ifndef configHEAP_HOSTED_HUGE_PAGE_SIZE
+        #define configHEAP_HOSTED_HUGE_PAGE_SIZE    ( ( size_t ) 2 * 1024 * 1024 )
+    #endif
+
+    /* 1: 每次提交后立即写入每一页，缺页发生在初始化或扩展时，而不是之后访问新分配的内存时 */
+    #ifndef configHEAP_HOSTED_PREFAULT
+        #define configHEAP_HOSTED_PREFAULT      0
+    #endif
+
+    /* vPortHeapInitialise 预取初始堆池时使用的线程数；堆池很大时并行缺页可以缩短启动时间 */
+    #ifndef configHEAP_HOSTED_PREFAULT_THREADS
+        #define configHEAP_HOSTED_PREFAULT_THREADS  1
+    #endif
+
+    /* 1: 用 mlock 锁定每次提交的页面，保证常驻且不会被换出；失败（如超出 RLIMIT_MEMLOCK）时计数，并按预取处理 */
+    #ifndef configHEAP_HOSTED_MLOCK
+        #define configHEAP_HOSTED_MLOCK         0
+    #endif
+#endif
+
+/**
+ * @brief 内存对齐字节数。
+ * 必须是 2 的幂。通常 32 位系统设为 4 或 8（Cortex-M 建议 8 字节以支持浮点运算）。
+ * 宿主机模式下默认 16 字节，与 glibc malloc 的对齐保证一致。
+ */
+#ifndef portBYTE_ALIGNMENT
+    #if ( configHEAP_HOSTED == 1 )
+        #define portBYTE_ALIGNMENT          16
+    #else
+        #define portBYTE_ALIGNMENT          8
+    #endif
+#endif
+
+/**
+ * @brief 堆空间分配方式。
+ * 0: 由本模块静态定义一个大的 uint8_t 数组作为堆池。
+ * 1: 用户在外部定义名为 ucHeap 的数组（方便通过链接脚本定位到特定的 RAM 段）。
+ */
+#define configAPPLICATION_ALLOCATED_HEAP    0
+
+/**
+ * @brief 已释放内存的清零策略，防止敏感数据残留并泄露给之后的分配，也方便调试。
+ * 0: 不清零。
+ * 1: vPortFree 时用 memset 将用户区清零。
+ * 2: 同 1，但不小于 configHEAP_CLEAR_NON_TEMPORAL_THRESHOLD 的块用 SSE2 非临时存储清零，
+ *    不经过缓存，避免清零大块内存时挤掉热数据（非 SSE2 平台退化为 memset）。
+ * 3: 释放时不清零，改为分配时清零：只有真正被复用的内存才付出清零开销，pvPortCalloc 也不必再清零。
+ *    已释放的数据在被复用前仍留在空闲内存中（也会进入堆快照文件）。
+ * 4: 延迟清零：vPortFree 只把块挂入待清零队列（块头带 heapBLOCK_PENDING_CLEAR_BITMASK），
+ *    由空闲钩子调用 xPortHeapClearPending 清零后再并入空闲链表；空闲链表不够用时先同步清空队列。
+ *    待清零的块在清零之前不可能被分配出去，也不计入 xPortGetFreeHeapSize。
+ */
+#ifndef configHEAP_CLEAR_MEMORY_ON_FREE
+    #define configHEAP_CLEAR_MEMORY_ON_FREE     1
+#endif
+
+/* 策略 2、4 中改用非临时存储的块大小下限（字节） */
+#ifndef configHEAP_CLEAR_NON_TEMPORAL_THRESHOLD
+    #define configHEAP_CLEAR_NON_TEMPORAL_THRESHOLD ( ( size_t ) 128 * 1024 )
+#endif
+
+/**
+ * @brief vPortFreeSized 是否用块头校验调用者给出的大小。
+ * 1: 校验不一致时触发 configASSERT（调试版默认）。
+ * 0: 完全信任调用者给出的大小（定义了 NDEBUG 的发布版默认）。
+ */
+#ifndef configHEAP_CHECK_SIZED_FREE
+    #ifdef NDEBUG
+        #define configHEAP_CHECK_SIZED_FREE     0
+    #else
+        #define configHEAP_CHECK_SIZED_FREE     1
+    #endif
+#endif
+
+/**
+ * @brief 是否增量维护碎片化指标（空闲块大小直方图、最大空闲块、查找长度）。
+ * 1: 每次空闲链表变化时更新计数，可通过 vPortGetHeapFragmentationStats 读取。
+ */
+#ifndef configHEAP_FRAGMENTATION_METRICS
+    #define configHEAP_FRAGMENTATION_METRICS    0
+#endif
+
+/**
+ * @brief 是否启用可重定位句柄与堆整理。
+ * 1: 通过 xPortHandleAlloc 分配的对象只能经句柄访问，未被钉住（pin）时可被
+ *    xPortHeapCompactStep 移向低地址，把零散的空闲空间重新拼成大块。
+ */
+#ifndef configHEAP_RELOCATABLE_HANDLES
+    #define configHEAP_RELOCATABLE_HANDLES      0
+#endif
+
+/* 句柄表容量（可同时存在的可重定位对象个数） */
+#ifndef configHEAP_HANDLE_COUNT
+    #define configHEAP_HANDLE_COUNT             64
+#endif
+
+/**
+ * @brief 是否启用堆快照（需要标准 I/O）。
+ * 1: xPortHeapSnapshotSave 把整个堆镜像写入文件，pvPortHeapSnapshotRestore 在下次启动时
+ *    原址恢复，跳过重建应用状态所需的大量分配。
+ */
+#ifndef configHEAP_SNAPSHOT
+    #define configHEAP_SNAPSHOT                 0
+#endif
+
+/**
+ * @brief 是否启用采样式分配剖析（仅宿主机模式，依赖 glibc 的 backtrace）。
+ * 1: 按泊松过程平均每分配 configHEAP_PROFILER_SAMPLE_INTERVAL 字节抽取一次，记录调用栈并标记该块，
+ *    按调用点统计存活与峰值字节数，xPortHeapProfileDump 输出 pprof 可读的 heap profile。
+ *    未被抽中的分配只多一次线程局部计数的减法，释放只多检查一个状态位。
+ * 0: 完全不编译。
+ */
+#ifndef configHEAP_SAMPLING_PROFILER
+    #define configHEAP_SAMPLING_PROFILER        0
+#endif
+
+#if ( configHEAP_SAMPLING_PROFILER == 1 )
+    #if ( configHEAP_HOSTED != 1 )
+        #error "configHEAP_SAMPLING_PROFILER requires configHEAP_HOSTED == 1"
+    #endif
+
+    /* 平均采样间隔（字节），运行时可用 vPortHeapProfilerSetInterval 修改 */
+    #ifndef configHEAP_PROFILER_SAMPLE_INTERVAL
+        #define configHEAP_PROFILER_SAMPLE_INTERVAL ( ( size_t ) 512 * 1024 )
+    #endif
+
+    /* 每个样本记录的最大调用栈深度 */
+    #ifndef configHEAP_PROFILER_STACK_DEPTH
+        #define configHEAP_PROFILER_STACK_DEPTH     32
+    #endif
+
+    /* 调用点表与存活样本表的容量，必须是 2 的幂 */
+    #ifndef configHEAP_PROFILER_MAX_SITES
+        #define configHEAP_PROFILER_MAX_SITES       1024
+    #endif
+
+    #ifndef configHEAP_PROFILER_MAX_LIVE
+        #define configHEAP_PROFILER_MAX_LIVE        8192
+    #endif
+#endif
+
+/**
+ * @brief 是否按线程统计 pvPortMalloc / vPortFree 的耗时与遍历节点数（仅宿主机模式）。
+ * 1: 每个线程维护自己的对数线性直方图，只由本线程写入；vPortGetHeapLatencyStats
+ *    用 relaxed 原子读取合并所有线程的直方图，不取任何锁，也不会阻塞分配器。
+ */
+#ifndef configHEAP_LATENCY_HISTOGRAMS
+    #define configHEAP_LATENCY_HISTOGRAMS       0
+#endif
+
+#if ( configHEAP_LATENCY_HISTOGRAMS == 1 ) && ( configHEAP_HOSTED != 1 )
+    #error "configHEAP_LATENCY_HISTOGRAMS requires configHEAP_HOSTED == 1"
+#endif
+
+/**
+ * @brief 是否统计堆锁的竞争情况（仅宿主机模式）。
+ * 1: 加锁时先 trylock，失败才计为一次竞争并计时等待；按调用路径（分配 / 释放 / 统计查询 / 其他）
+ *    记录获取次数、竞争次数，以及等锁时间和持锁时间的直方图。统计数据只在持有堆锁时写入，
+ *    由堆锁本身保护，无竞争时每次加解锁只多一次 trylock 和两次周期计数器读取。
+ */
+#ifndef configHEAP_LOCK_STATS
+    #define configHEAP_LOCK_STATS               0
+#endif
+
+#if ( configHEAP_LOCK_STATS == 1 ) && ( configHEAP_HOSTED != 1 )
+    #error "configHEAP_LOCK_STATS requires configHEAP_HOSTED == 1"
+#endif
+
+/**
+ * @brief 是否启用堆完整性检查。
+ * 1: xPortHeapCheck 按物理顺序遍历所有块，核对块大小、已分配位与空闲链表成员关系、
+ *    链表地址顺序以及相邻空闲块是否都已合并；xPortHeapCheckStep 每次只检查若干个块，
+ *    适合在生产环境中以固定开销持续运行。
+ */
+#ifndef configHEAP_INTEGRITY_CHECK
+    #define configHEAP_INTEGRITY_CHECK          0
+#endif
+
+/**
+ * @brief 是否启用抽样守护页检测（仅宿主机模式）。
+ * 1: 大约每 configHEAP_GUARDED_SAMPLE_RATE 次分配抽取一次，改由独立的 mmap 池提供：
+ *    每个对象独占一页并紧贴其后的 PROT_NONE 守护页，越界访问立即触发 SIGSEGV；
+ *    释放后该页也改为不可访问，并且最久未用的槽优先复用，释放后访问同样能被捕获。
+ *    其余分配仍走普通路径，只多一次线程局部计数的减法。
+ *    守护池不在堆镜像中，不能与快照同时启用。
+ */
+#ifndef configHEAP_GUARDED_SAMPLING
+    #define configHEAP_GUARDED_SAMPLING         0
+#endif
+
+#if ( configHEAP_GUARDED_SAMPLING == 1 )
+    #if ( configHEAP_HOSTED != 1 )
+        #error "configHEAP_GUARDED_SAMPLING requires configHEAP_HOSTED == 1"
+    #endif
+
+    #if ( configHEAP_SNAPSHOT == 1 )
+        #error "configHEAP_GUARDED_SAMPLING cannot be combined with configHEAP_SNAPSHOT"
+    #endif
+
+    /* 平均每多少次分配抽取一次 */
+    #ifndef configHEAP_GUARDED_SAMPLE_RATE
+        #define configHEAP_GUARDED_SAMPLE_RATE      1000
+    #endif
+
+    /* 池中的槽数：同时存活的受守护对象个数上限，也决定了释放后隔离的时长 */
+    #ifndef configHEAP_GUARDED_SLOTS
+        #define configHEAP_GUARDED_SLOTS            64
+    #endif
+#endif
+
+/**
+ * @brief 是否启用按所有者的内存配额。
+ * 1: 每个已分配块在块头大小字段的空闲高位中记录所有者编号（块头不变大），
+ *    每个所有者维护存活字节数，分配时以 O(1) 代价检查软、硬上限：
+ *    超过软上限时调用 configHEAP_OWNER_SOFT_LIMIT_HOOK，超过硬上限时分配失败。
+ *    统计的是块大小（含块头），守护池中的对象不计入。硬上限按换算后的请求大小检查，
+ *    块因剩余空间过小未分裂时多出的尾部会使存活字节数超出硬上限，但最多超出 heapMINIMUM_BLOCK_SIZE。
+ */
+#ifndef configHEAP_OWNER_QUOTAS
+    #define configHEAP_OWNER_QUOTAS             0
+#endif
+
+#if ( configHEAP_OWNER_QUOTAS == 1 )
+    /* 所有者编号占用的位数，所有者个数为 2 的这么多次方；块大小上限随之减小 */
+    #ifndef configHEAP_OWNER_BITS
+        #define configHEAP_OWNER_BITS               4
+    #endif
+
+    /* 当前分配者的编号，例如映射为任务标签；默认取 vPortHeapSetCurrentOwner 设置的值（宿主机模式下按线程） */
+    #ifndef configHEAP_CURRENT_OWNER
+        #define configHEAP_CURRENT_OWNER()          uxHeapCurrentOwner
+    #endif
+
+    /* 所有者的存活字节数刚越过软上限时调用，持有堆锁，不可在其中分配或释放 */
+    #ifndef configHEAP_OWNER_SOFT_LIMIT_HOOK
+        #define configHEAP_OWNER_SOFT_LIMIT_HOOK( uxOwner, xLiveBytes )
+    #endif
+#endif
+
+/**
+ * @brief 是否启用低内存回收回调。
+ * 1: 应用通过 xPortHeapRegisterReclaim 注册回收回调（例如清理缓存），堆在以下两种情况下
+ *    按优先级依次调用它们，直到释放出足够的空间：
+ *    - 分配后剩余空间低于某个回调的水位线（每次跌破只触发一次，回升到水位线以上后重新生效）；
+ *    - pvPortMalloc / pvPortMallocAligned 分配失败，此时回调之后重试一次分配。
+ *    回调在堆锁之外调用，可以释放内存；回调中的分配失败不会再次触发回收。
+ */
+#ifndef configHEAP_RECLAIM_CALLBACKS
+    #define configHEAP_RECLAIM_CALLBACKS        0
+#endif
+
+#if ( configHEAP_RECLAIM_CALLBACKS == 1 )
+    /* 可同时注册的回调个数上限 */
+    #ifndef configHEAP_RECLAIM_MAX_CALLBACKS
+        #define configHEAP_RECLAIM_MAX_CALLBACKS    8
+    #endif
+#endif
+
+/**
+ * @brief 紧急储备区大小（字节），0 表示不启用。
+ * 储备区是独立于主堆池的一块内存，只有 pvPortMallocCritical 在主堆分配失败后才能使用，
+ * 保证故障处理、遥测等关键路径在堆被耗尽时仍能分配。储备区不计入 xPortGetFreeHeapSize，
+ * 也不参与快照、整理、完整性检查与所有者配额；普通分配路径不受任何影响。
+ */
+#ifndef configHEAP_EMERGENCY_RESERVE_SIZE
+    #define configHEAP_EMERGENCY_RESERVE_SIZE   0
+#endif
+
+/**
+ * @brief 是否启用空闲块的带外索引。
+ * 1: 另用两个紧凑的 uint32_t 数组，按地址顺序镜像所有空闲块的大小与位置（以 portBYTE_ALIGNMENT 为单位）。
+ *    首次适配改为顺序扫描大小数组，选中之后才访问堆内的块头；释放时用二分查找定位前驱，
+ *    不再沿 pxNextFreeBlock 逐个追指针。空闲块多于 configHEAP_FREE_INDEX_CAPACITY 个时索引暂停使用，
+ *    退回遍历链表，空闲块减少到容量的一半以下时再重建。
+ */
+#ifndef configHEAP_FREE_INDEX
+    #define configHEAP_FREE_INDEX               0
+#endif
+
+#if ( configHEAP_FREE_INDEX == 1 )
+    /* 索引最多容纳的空闲块个数，两个数组共占 8 * configHEAP_FREE_INDEX_CAPACITY 字节 */
+    #ifndef configHEAP_FREE_INDEX_CAPACITY
+        #define configHEAP_FREE_INDEX_CAPACITY      1024
+    #endif
+
+    /**
+     * 扫描大小数组的方式。
+     * 0: 逐个比较
+     * 1: x86 上用 SIMD 一次比较多个条目，运行时检测 CPU 选择 AVX2（每次 8 个）或 SSE2（每次 4 个），
+     *    其他平台与 0 相同
+     */
+    #ifndef configHEAP_FREE_INDEX_SIMD
+        #define configHEAP_FREE_INDEX_SIMD          1
+    #endif
+#endif
+
+/**
+ * @brief 大对象直接映射的阈值（字节，含块头），仅宿主机模式可用。
+ * 0: 关闭，所有分配都来自堆池。
+ * 非 0: 不小于该值的分配绕过空闲链表，各自用 mmap 单独映射，块头带 heapBLOCK_LARGE_BITMASK；
+ *       vPortFree 时直接 munmap 归还给系统，pvPortRealloc 在 Linux 上用 mremap 调整大小而不复制数据。
+ *       映射失败时退回堆池。这些块不计入 xPortGetFreeHeapSize，也无法保存到快照中。
+ */
+#ifndef configHEAP_LARGE_OBJECT_THRESHOLD
+    #define configHEAP_LARGE_OBJECT_THRESHOLD   0
+#endif
+
+#if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+    #if ( configHEAP_HOSTED != 1 )
+        #error "configHEAP_LARGE_OBJECT_THRESHOLD requires configHEAP_HOSTED == 1"
+    #endif
+
+    #if ( configHEAP_SNAPSHOT == 1 )
+        #error "configHEAP_LARGE_OBJECT_THRESHOLD cannot be combined with configHEAP_SNAPSHOT"
+    #endif
+#endif
+
+/* 发现损坏时调用，参数为损坏块的块头地址与原因描述；默认什么也不做，只通过返回值报告 */
+#ifndef configHEAP_CORRUPTION_HOOK
+    #define configHEAP_CORRUPTION_HOOK( pvBlock, pcReason )
+#endif
+
+/**
+ * @brief 断言宏。
+ * 用于捕捉致命错误（如释放了已被释放的内存）。生产环境下可改为复位指令。
+ */
+#if ( configHEAP_HOSTED == 1 )
+    #define configASSERT( x )               if( ( x ) == 0 ) { abort(); }
+#else
+    #define configASSERT( x )               if( ( x ) == 0 ) { for( ;; ); }
+#endif
+
+
+/* 线程安全锁定机制：在多线程/抢占式环境下，需在此填入关中断或获取互斥锁的代码 */
+#if ( configHEAP_HOSTED == 1 )
+    #include <pthread.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+
+    static pthread_mutex_t xHeapMutex = PTHREAD_MUTEX_INITIALIZER;
+
+    #if ( configHEAP_LOCK_STATS == 1 )
+        static void prvHeapLock( HeapLockPath_t ePath );
+        static void prvHeapUnlock( void );
+
+        #define HEAP_LOCK_FOR( ePath )  prvHeapLock( ePath )
+        #define HEAP_UNLOCK()           prvHeapUnlock()
+    #else
+        #define HEAP_LOCK_FOR( ePath )  pthread_mutex_lock( &xHeapMutex )
+        #define HEAP_UNLOCK()           pthread_mutex_unlock( &xHeapMutex )
+    #endif
+#else
+    #define HEAP_LOCK_FOR( ePath )
+    #define HEAP_UNLOCK()   
+#endif
+
+/* 分配、释放与统计查询路径用 HEAP_LOCK_FOR 注明路径，其余（整理、检查、快照、回调注册等）计入"其他" */
+#define HEAP_LOCK()         HEAP_LOCK_FOR( eHeapLockPathOther )
+
+/* 字节对齐遮罩：用于计算对齐后的地址 */
+#define portBYTE_ALIGNMENT_MASK             ( portBYTE_ALIGNMENT - 1 )
+
+/* 最小空闲块大小：防止链表中出现过小的内存碎片。若分裂后的块小于此值，则不分裂 */
+#define heapMINIMUM_BLOCK_SIZE              ( ( size_t ) ( xHeapStructSize << 1 ) )
+
+/* 状态位：利用 size_t 的最高位标记该块是否已被分配（1:已分配，0:空闲） */
+#define heapBLOCK_ALLOCATED_BITMASK         ( ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * 8 ) - 1 ) )
+
+/* 可重定位标记：次高位，仅用于已分配块，表示该块只通过句柄访问，整理器可以移动它 */
+#define heapBLOCK_RELOCATABLE_BITMASK       ( heapBLOCK_ALLOCATED_BITMASK >> 1 )
+
+/* 采样标记：第三高位，仅用于已分配块，表示剖析器为该块记录了调用栈，释放时需要注销 */
+#define heapBLOCK_SAMPLED_BITMASK           ( heapBLOCK_ALLOCATED_BITMASK >> 2 )
+
+/* 待清零标记：第四高位，块已被释放但还在延迟清零队列中（pxNextFreeBlock 链接队列），仍按已分配处理 */
+#define heapBLOCK_PENDING_CLEAR_BITMASK     ( heapBLOCK_ALLOCATED_BITMASK >> 3 )
+
+/* 大对象标记：第五高位，块不在堆池中，而是单独的 mmap 映射，大小字段是整个映射的长度 */
+#define heapBLOCK_LARGE_BITMASK             ( heapBLOCK_ALLOCATED_BITMASK >> 4 )
+
+/* 所有者编号：紧接在上面五个标记位之下的 configHEAP_OWNER_BITS 位，仅用于已分配块 */
+#if ( configHEAP_OWNER_QUOTAS == 1 )
+    #define heapOWNER_COUNT                 ( ( size_t ) 1 << configHEAP_OWNER_BITS )
+    #define heapOWNER_SHIFT                 ( ( sizeof( size_t ) * 8 ) - 5 - configHEAP_OWNER_BITS )
+    #define heapBLOCK_OWNER_BITMASK         ( ( heapOWNER_COUNT - 1 ) << heapOWNER_SHIFT )
+    #define heapBLOCK_OWNER( pxBlock )      ( ( ( pxBlock )->xBlockSize & heapBLOCK_OWNER_BITMASK ) >> heapOWNER_SHIFT )
+#else
+    #define heapBLOCK_OWNER_BITMASK         ( ( size_t ) 0 )
+#endif
+
+/* 已分配块的大小字段中所有状态位；空闲块的大小字段不带任何状态位 */
+#define heapBLOCK_FLAGS_MASK                ( heapBLOCK_ALLOCATED_BITMASK | heapBLOCK_RELOCATABLE_BITMASK | heapBLOCK_SAMPLED_BITMASK | heapBLOCK_PENDING_CLEAR_BITMASK | heapBLOCK_LARGE_BITMASK | heapBLOCK_OWNER_BITMASK )
+
+/* 块大小能表示的上限（不与状态位重叠） */
+#define heapBLOCK_SIZE_LIMIT                ( ~heapBLOCK_FLAGS_MASK )
+
+/* 读取已分配块去掉状态位后的大小 */
+#define heapBLOCK_SIZE( pxBlock )           ( ( pxBlock->xBlockSize ) & ~heapBLOCK_FLAGS_MASK )
+
+/* 检查块是否已分配 */
+#define heapBLOCK_IS_ALLOCATED( pxBlock )   ( ( ( pxBlock->xBlockSize ) & heapBLOCK_ALLOCATED_BITMASK ) != 0 )
+
+/* 标记块为已分配状态 */
+#define heapALLOCATE_BLOCK( pxBlock )       ( ( pxBlock->xBlockSize ) |= heapBLOCK_ALLOCATED_BITMASK )
+
+/* 标记块为空闲状态（同时清除其他状态位） */
+#define heapFREE_BLOCK( pxBlock )           ( ( pxBlock->xBlockSize ) &= ~heapBLOCK_FLAGS_MASK )
+
+
+/* --- 数据结构 --- */
+typedef struct A_BLOCK_LINK
+{
+    struct A_BLOCK_LINK * pxNextFreeBlock; /**< 指向链表中下一个空闲块 */
+    size_t xBlockSize;                     /**< 当前块的大小（包含 Header 本身） */
+} BlockLink_t;
+
+/* --- 全局变量 --- */
+#if ( configHEAP_HOSTED == 1 )
+    static uint8_t * ucHeap = NULL;      /* mmap 预留区间的起始地址 */
+    static size_t xHeapCommittedSize = 0U; /* 已提交（可读写）的字节数 */
+    static size_t xHeapHugePageBytes = 0U; /* 以 MAP_HUGETLB 大页提交的字节数 */
+    static size_t xHeapLockedBytes = 0U;   /* 已被 mlock 锁定的字节数 */
+    static size_t xHeapLockFailures = 0U;  /* mlock 失败的次数 */
+    static int xHeapPrefaultDeferred = 0;  /* 非 0 时提交不预取，由 vPortHeapInitialise 在锁外并行预取 */
+#elif ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+    static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif
+
+/* 结构体 Header 实际占用的对齐后大小 */
+static const size_t xHeapStructSize = ( sizeof( BlockLink_t ) + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+
+static BlockLink_t xStart;           /* 链表头指针（地址最低端） */
+static BlockLink_t * pxEnd = NULL;   /* 链表尾指针（地址最高端） */
+
+static size_t xFreeBytesRemaining = 0U;             /* 当前可用总字节数 */
+static size_t xMinimumEverFreeBytesRemaining = 0U;  /* 历史最低可用字节数（水位线） */
+static size_t xNumberOfSuccessfulAllocations = 0U;  /* 成功分配次数计数 */
+static size_t xNumberOfSuccessfulFrees = 0U;        /* 成功释放次数计数 */
+
+#if ( configHEAP_RELOCATABLE_HANDLES == 1 )
+    /* 句柄表项：句柄值为下标加 1，0 表示无效句柄 */
+    typedef struct xHEAP_HANDLE_ENTRY
+    {
+        BlockLink_t * pxBlock; /**< 对象当前所在的块，NULL 表示该表项空闲 */
+        size_t xPinCount;      /**< 钉住计数，大于 0 时整理器不会移动该块 */
+    } HeapHandleEntry_t;
+
+    static HeapHandleEntry_t xHandleTable[ configHEAP_HANDLE_COUNT ];
+    static size_t xFreeListGeneration = 0U;      /* 空闲链表每变化一次加 1，用来判断整理游标是否失效 */
+    static size_t xCompactGeneration = 0U;       /* 游标对应的 xFreeListGeneration */
+    static BlockLink_t * pxCompactCursor = NULL; /* 整理器下一次从这个空闲节点的后继开始 */
+
+    #define heapCOMPACT_INVALIDATE()                xFreeListGeneration++
+#else
+    #define heapCOMPACT_INVALIDATE()
+#endif
+
+#if ( configHEAP_INTEGRITY_CHECK == 1 )
+    static BlockLink_t * pxCheckCursor = NULL;        /* 增量检查下一个要检查的块，NULL 表示从头开始 */
+    static BlockLink_t * pxCheckLastFree = NULL;      /* 游标之前最后一个空闲块（没有时为 &xStart） */
+    static int xCheckPreviousFree = 0;                /* 游标之前紧邻的块是否空闲 */
+    static size_t xCheckFreeBytes = 0U;               /* 游标之前所有空闲块的字节数之和 */
+    static size_t xCheckPasses = 0U;                  /* 已完成的完整遍历次数 */
+    static uintptr_t uxCheckLowestChange = UINTPTR_MAX; /* 上次检查以来块结构变化过的最低地址 */
+
+    /* 游标之前的块结构只要没变，已检查过的结论就仍然成立，下次可以接着往后查 */
+    #define heapCHECK_INVALIDATE( pxBlock )         if( ( uintptr_t ) ( pxBlock ) < uxCheckLowestChange ) { uxCheckLowestChange = ( uintptr_t ) ( pxBlock ); }
+#else
+    #define heapCHECK_INVALIDATE( pxBlock )
+#endif
+
+#if ( configHEAP_OWNER_QUOTAS == 1 )
+    static HeapOwnerStats_t xOwnerStats[ heapOWNER_COUNT ];
+
+    #if ( configHEAP_HOSTED == 1 )
+        static __thread size_t uxHeapCurrentOwner __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+    #else
+        static size_t uxHeapCurrentOwner = 0;
+    #endif
+
+    /**
+     * @brief 取当前分配者的编号；超出范围的编号计入 0 号所有者。
+     */
+    static inline size_t prvCurrentOwner( void )
+    {
+        size_t uxOwner = ( size_t ) configHEAP_CURRENT_OWNER();
+
+        configASSERT( uxOwner < heapOWNER_COUNT );
+
+        return ( uxOwner < heapOWNER_COUNT ) ? uxOwner : 0U;
+    }
+
+    /**
+     * @brief 硬上限检查：再分配 xBlockSize 字节后是否仍不超过硬上限。调用者必须持有 HEAP_LOCK。
+     */
+    static inline int prvOwnerAdmit( size_t uxOwner, size_t xBlockSize )
+    {
+        HeapOwnerStats_t * pxStats = &xOwnerStats[ uxOwner ];
+
+        if( ( pxStats->xHardLimit != 0U ) &&
+            ( ( pxStats->xLiveBytes > pxStats->xHardLimit ) || ( xBlockSize > ( pxStats->xHardLimit - pxStats->xLiveBytes ) ) ) )
+        {
+            pxStats->xHardLimitFailures++;
+            return 0;
+        }
+
+        return 1;
+    }
+
+    /**
+     * @brief 把 xBlockSize 字节记到 uxOwner 名下，并检查软上限。调用者必须持有 HEAP_LOCK。
+     */
+    static void prvOwnerAdd( size_t uxOwner, size_t xBlockSize )
+    {
+        HeapOwnerStats_t * pxStats = &xOwnerStats[ uxOwner ];
+        size_t xBefore = pxStats->xLiveBytes;
+
+        pxStats->xLiveBytes += xBlockSize;
+
+        if( pxStats->xLiveBytes > pxStats->xPeakBytes )
+        {
+            pxStats->xPeakBytes = pxStats->xLiveBytes;
+        }
+
+        if( ( pxStats->xSoftLimit != 0U ) && ( xBefore <= pxStats->xSoftLimit ) && ( pxStats->xLiveBytes > pxStats->xSoftLimit ) )
+        {
+            pxStats->xSoftLimitCrossings++;
+            configHEAP_OWNER_SOFT_LIMIT_HOOK( uxOwner, pxStats->xLiveBytes );
+        }
+    }
+
+    /**
+     * @brief 给刚分配的块打上所有者编号并记账。调用者必须持有 HEAP_LOCK。
+     */
+    static void prvOwnerCharge( void * pv, size_t uxOwner )
+    {
+        BlockLink_t * pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+        pxBlock->xBlockSize = ( pxBlock->xBlockSize & ~heapBLOCK_OWNER_BITMASK ) | ( uxOwner << heapOWNER_SHIFT );
+        prvOwnerAdd( uxOwner, heapBLOCK_SIZE( pxBlock ) );
+    }
+
+    /**
+     * @brief 已分配块原地改变大小后调整其所有者的记账。调用者必须持有 HEAP_LOCK。
+     */
+    static void prvOwnerResize( BlockLink_t * pxBlock, size_t xOldSize, size_t xNewSize )
+    {
+        if( xNewSize > xOldSize )
+        {
+            prvOwnerAdd( heapBLOCK_OWNER( pxBlock ), xNewSize - xOldSize );
+        }
+        else
+        {
+            xOwnerStats[ heapBLOCK_OWNER( pxBlock ) ].xLiveBytes -= xOldSize - xNewSize;
+        }
+    }
+
+    #if ( configHEAP_SNAPSHOT == 1 )
+
+    /**
+     * @brief 按块头中的所有者编号重新统计存活字节数（快照恢复后调用）。调用者必须持有 HEAP_LOCK。
+     */
+    static void prvOwnerRecount( void )
+    {
+        BlockLink_t * pxBlock;
+        size_t uxOwner;
+
+        for( uxOwner = 0; uxOwner < heapOWNER_COUNT; uxOwner++ )
+        {
+            xOwnerStats[ uxOwner ].xLiveBytes = 0U;
+        }
+
+        pxBlock = ( BlockLink_t * ) ( ( ( uintptr_t ) ucHeap + portBYTE_ALIGNMENT_MASK ) & ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK ) );
+
+        for( ; pxBlock < pxEnd; pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + heapBLOCK_SIZE( pxBlock ) ) )
+        {
+            if( heapBLOCK_IS_ALLOCATED( pxBlock ) != 0 )
+            {
+                xOwnerStats[ heapBLOCK_OWNER( pxBlock ) ].xLiveBytes += heapBLOCK_SIZE( pxBlock );
+            }
+        }
+    }
+
+    #endif /* configHEAP_SNAPSHOT */
+
+    #define heapCURRENT_OWNER()                     prvCurrentOwner()
+    #define heapOWNER_ADMIT( uxOwner, xSize )       prvOwnerAdmit( ( uxOwner ), ( xSize ) )
+    #define heapOWNER_ADMIT_GROWTH( pxBlock, xSize ) prvOwnerAdmit( heapBLOCK_OWNER( pxBlock ), ( xSize ) )
+    #define heapOWNER_CHARGE( pv, uxOwner )         prvOwnerCharge( ( pv ), ( uxOwner ) )
+    #define heapOWNER_RESIZE( pxBlock, xOld, xNew ) prvOwnerResize( ( pxBlock ), ( xOld ), ( xNew ) )
+    #define heapOWNER_RELEASE( pxBlock )            ( xOwnerStats[ heapBLOCK_OWNER( pxBlock ) ].xLiveBytes -= heapBLOCK_SIZE( pxBlock ) )
+#else
+    #define heapCURRENT_OWNER()                     ( ( size_t ) 0 )
+    #define heapOWNER_ADMIT( uxOwner, xSize )       ( ( void ) ( uxOwner ), 1 )
+    #define heapOWNER_ADMIT_GROWTH( pxBlock, xSize ) ( 1 )
+    #define heapOWNER_CHARGE( pv, uxOwner )         ( ( void ) ( uxOwner ) )
+    #define heapOWNER_RESIZE( pxBlock, xOld, xNew )
+    #define heapOWNER_RELEASE( pxBlock )
+#endif
+
+#if ( configHEAP_RECLAIM_CALLBACKS == 1 )
+    /* 回调表项，按 uxPriority 升序排列 */
+    typedef struct xHEAP_RECLAIM_ENTRY
+    {
+        HeapReclaimCallback_t pxCallback; /**< 回调函数 */
+        void * pvContext;                 /**< 原样传给回调的参数 */
+        size_t uxPriority;                /**< 越小越先调用 */
+        size_t xWatermark;                /**< 剩余空间低于它时触发，0 表示只在分配失败时调用 */
+        int xArmed;                       /**< 水位线触发是否有效，触发后清零，空间回升后恢复 */
+    } HeapReclaimEntry_t;
+
+    static HeapReclaimEntry_t xReclaimEntries[ configHEAP_RECLAIM_MAX_CALLBACKS ];
+    static size_t xReclaimEntryCount = 0U;
+    /*
+     * 快速路径的两个阈值，持锁更新、无锁读取：剩余空间低于仍有效的最高水位线时有回调要触发，
+     * 不低于已触发的最低水位线时有回调要恢复；两者都不满足时分配后不必加锁。
+     */
+    static size_t xReclaimArmedHighest = 0U;
+    static size_t xReclaimDisarmedLowest = ( size_t ) -1;
+
+    #if ( configHEAP_HOSTED == 1 )
+        static __thread int xReclaimActive __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+    #else
+        static int xReclaimActive = 0;
+    #endif
+
+    /**
+     * @brief 在锁外按优先级调用 pxEntries 中的回调，直到累计释放不少于 xBytesNeeded 字节。
+     * @return size_t 回调报告的释放字节数之和
+     */
+    static size_t prvReclaimRun( const HeapReclaimEntry_t * pxEntries, size_t xCount, size_t xBytesNeeded )
+    {
+        size_t xIndex, xReleased = 0U;
+
+        /* 回调中的分配与释放不会再次进入回收 */
+        xReclaimActive = 1;
+
+        for( xIndex = 0; ( xIndex < xCount ) && ( xReleased < xBytesNeeded ); xIndex++ )
+        {
+            xReleased += pxEntries[ xIndex ].pxCallback( xBytesNeeded - xReleased, pxEntries[ xIndex ].pvContext );
+        }
+
+        xReclaimActive = 0;
+
+        return xReleased;
+    }
+
+    /**
+     * @brief 分配失败后调用全部回调。
+     * @return int 有回调报告释放了内存、值得重试时返回 1
+     */
+    static int prvReclaimOnFailure( size_t xBytesNeeded )
+    {
+        HeapReclaimEntry_t xEntries[ configHEAP_RECLAIM_MAX_CALLBACKS ];
+        size_t xCount;
+
+        if( xReclaimActive != 0 )
+        {
+            return 0;
+        }
+
+        HEAP_LOCK();
+        {
+            xCount = xReclaimEntryCount;
+            memcpy( xEntries, xReclaimEntries, xCount * sizeof( HeapReclaimEntry_t ) );
+        }
+        HEAP_UNLOCK();
+
+        return ( prvReclaimRun( xEntries, xCount, xBytesNeeded ) != 0U ) ? 1 : 0;
+    }
+
+    /**
+     * @brief 按各回调当前的有效状态重新计算快速路径的两个阈值。调用者必须持有 HEAP_LOCK。
+     */
+    static void prvReclaimUpdateThresholds( void )
+    {
+        size_t xIndex, xArmedHighest = 0U, xDisarmedLowest = ( size_t ) -1;
+
+        for( xIndex = 0; xIndex < xReclaimEntryCount; xIndex++ )
+        {
+            if( xReclaimEntries[ xIndex ].xArmed != 0 )
+            {
+                if( xReclaimEntries[ xIndex ].xWatermark > xArmedHighest )
+                {
+                    xArmedHighest = xReclaimEntries[ xIndex ].xWatermark;
+                }
+            }
+            else if( xReclaimEntries[ xIndex ].xWatermark < xDisarmedLowest )
+            {
+                xDisarmedLowest = xReclaimEntries[ xIndex ].xWatermark;
+            }
+        }
+
+        __atomic_store_n( &xReclaimArmedHighest, xArmedHighest, __ATOMIC_RELAXED );
+        __atomic_store_n( &xReclaimDisarmedLowest, xDisarmedLowest, __ATOMIC_RELAXED );
+    }
+
+    /**
+     * @brief 分配成功后检查水位线：触发跌破水位线且仍有效的回调，恢复空间已回升的回调。
+     * @param xFree 分配者在持锁期间读到的剩余空间
+     */
+    static void prvReclaimCheckWatermarks( size_t xFree )
+    {
+        HeapReclaimEntry_t xEntries[ configHEAP_RECLAIM_MAX_CALLBACKS ];
+        size_t xIndex, xCount = 0U;
+
+        /* 快速路径：没有越过任何仍有效的水位线，也没有回升到任何已触发的水位线之上 */
+        if( ( xFree >= __atomic_load_n( &xReclaimArmedHighest, __ATOMIC_RELAXED ) ) &&
+            ( xFree < __atomic_load_n( &xReclaimDisarmedLowest, __ATOMIC_RELAXED ) ) )
+        {
+            return;
+        }
+
+        if( xReclaimActive != 0 )
+        {
+            return;
+        }
+
+        HEAP_LOCK();
+        {
+            xFree = xFreeBytesRemaining;
+
+            for( xIndex = 0; xIndex < xReclaimEntryCount; xIndex++ )
+            {
+                if( xFree >= xReclaimEntries[ xIndex ].xWatermark )
+                {
+                    xReclaimEntries[ xIndex ].xArmed = 1;
+                }
+                else if( xReclaimEntries[ xIndex ].xArmed != 0 )
+                {
+                    xReclaimEntries[ xIndex ].xArmed = 0;
+                    xEntries[ xCount++ ] = xReclaimEntries[ xIndex ];
+                }
+            }
+
+            prvReclaimUpdateThresholds();
+        }
+        HEAP_UNLOCK();
+
+        /* 每个回调的目标是让剩余空间回到它自己的水位线之上，前面的回调已经做到时跳过 */
+        for( xIndex = 0; xIndex < xCount; xIndex++ )
+        {
+            HEAP_LOCK();
+            {
+                xFree = xFreeBytesRemaining;
+            }
+            HEAP_UNLOCK();
+
+            if( xFree < xEntries[ xIndex ].xWatermark )
+            {
+                ( void ) prvReclaimRun( &xEntries[ xIndex ], 1, xEntries[ xIndex ].xWatermark - xFree );
+            }
+        }
+    }
+
+    /* 分配路径在持锁期间用 heapRECLAIM_NOTE_FREE 记下剩余空间，解锁后据此走快速路径，不再无锁读取计数 */
+    #define heapRECLAIM_DECLARE()                   int xReclaimRetried = 0; size_t xReclaimFree = 0U
+    #define heapRECLAIM_NOTE_FREE()                 xReclaimFree = xFreeBytesRemaining
+    #define heapRECLAIM_RETRY( pv, xSize )          ( ( ( pv ) == NULL ) && ( ( xSize ) > 0 ) && ( xReclaimRetried++ == 0 ) && ( prvReclaimOnFailure( xSize ) != 0 ) )
+    #define heapRECLAIM_AFTER_ALLOCATE( pv )        if( ( pv ) != NULL ) { prvReclaimCheckWatermarks( xReclaimFree ); }
+#else
+    #define heapRECLAIM_DECLARE()
+    #define heapRECLAIM_NOTE_FREE()
+    #define heapRECLAIM_RETRY( pv, xSize )          ( 0 )
+    #define heapRECLAIM_AFTER_ALLOCATE( pv )
+#endif
+
+#if ( configHEAP_GUARDED_SAMPLING == 1 )
+    #include <signal.h>
+
+    /* 守护池中的一个槽：占一页，两侧都是守护页 */
+    typedef struct xHEAP_GUARDED_SLOT
+    {
+        void * pv;        /**< 对象的用户区指针，NULL 表示从未使用过 */
+        size_t xSize;     /**< 请求字节数 */
+        size_t xFreedAt;  /**< 释放时的序号，挑选复用的槽时取最小者；0 表示从未释放 */
+        int xAllocated;   /**< 是否正被使用 */
+    } HeapGuardedSlot_t;
+
+    /* 池布局：守护页、槽、守护页、槽……守护页，共 2 * configHEAP_GUARDED_SLOTS + 1 页 */
+    static uint8_t * pucGuardedPool = NULL;
+    static size_t xGuardedPageSize = 0U;
+    static HeapGuardedSlot_t xGuardedSlots[ configHEAP_GUARDED_SLOTS ];
+    static size_t xGuardedFreeSequence = 0U;
+    static pthread_mutex_t xGuardedMutex = PTHREAD_MUTEX_INITIALIZER;
+    static struct sigaction xPreviousSegvAction;
+
+    static __thread size_t xAllocationsUntilGuarded __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+    static __thread uint32_t ulGuardedRandom __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+
+    #define heapGUARDED_POOL_SIZE               ( ( ( 2 * ( size_t ) configHEAP_GUARDED_SLOTS ) + 1 ) * xGuardedPageSize )
+    #define heapGUARDED_SLOT_PAGE( xIndex )     ( pucGuardedPool + ( ( ( 2 * ( xIndex ) ) + 1 ) * xGuardedPageSize ) )
+
+    /**
+     * @brief pv 是否位于守护池中。池只建立一次，之后地址不变，因此无需加锁。
+     */
+    static inline int prvGuardedOwns( const void * pv )
+    {
+        uint8_t * pucPool = __atomic_load_n( &pucGuardedPool, __ATOMIC_ACQUIRE );
+
+        return ( pucPool != NULL ) && ( ( uintptr_t ) pv - ( uintptr_t ) pucPool < heapGUARDED_POOL_SIZE );
+    }
+
+    /**
+     * @brief 把字符串追加到 pcMessage[ *pxLength ] 处，超出 xCapacity 的部分丢弃。
+     */
+    static void prvGuardedAppend( char * pcMessage, size_t * pxLength, size_t xCapacity, const char * pcText )
+    {
+        while( ( *pcText != '\0' ) && ( *pxLength < xCapacity ) )
+        {
+            pcMessage[ ( *pxLength )++ ] = *pcText++;
+        }
+    }
+
+    /**
+     * @brief 把 uxValue 按 uxBase（10 或 16）格式化后追加，十六进制带 0x 前缀。
+     */
+    static void prvGuardedAppendNumber( char * pcMessage, size_t * pxLength, size_t xCapacity, uintptr_t uxValue, uintptr_t uxBase )
+    {
+        char cDigits[ sizeof( uintptr_t ) * 3 + 3 ];
+        size_t xPosition = sizeof( cDigits ) - 1U;
+
+        cDigits[ xPosition ] = '\0';
+
+        do
+        {
+            cDigits[ --xPosition ] = "0123456789abcdef"[ uxValue % uxBase ];
+            uxValue /= uxBase;
+        } while( uxValue != 0U );
+
+        if( uxBase == 16U )
+        {
+            cDigits[ --xPosition ] = 'x';
+            cDigits[ --xPosition ] = '0';
+        }
+
+        prvGuardedAppend( pcMessage, pxLength, xCapacity, &cDigits[ xPosition ] );
+    }
+
+    /**
+     * @brief 向 stderr 输出一条错误报告。手工格式化后只调用 write，可在信号处理函数中调用。
+     */
+    static void prvGuardedReport( const char * pcKind, const void * pvAddress, size_t xIndex )
+    {
+        char cMessage[ 200 ];
+        size_t xLength = 0U;
+
+        prvGuardedAppend( cMessage, &xLength, sizeof( cMessage ), "heap: " );
+        prvGuardedAppend( cMessage, &xLength, sizeof( cMessage ), pcKind );
+        prvGuardedAppend( cMessage, &xLength, sizeof( cMessage ), " at " );
+        prvGuardedAppendNumber( cMessage, &xLength, sizeof( cMessage ), ( uintptr_t ) pvAddress, 16U );
+        prvGuardedAppend( cMessage, &xLength, sizeof( cMessage ), " (" );
+        prvGuardedAppendNumber( cMessage, &xLength, sizeof( cMessage ), ( uintptr_t ) xGuardedSlots[ xIndex ].xSize, 10U );
+        prvGuardedAppend( cMessage, &xLength, sizeof( cMessage ), "-byte object at " );
+        prvGuardedAppendNumber( cMessage, &xLength, sizeof( cMessage ), ( uintptr_t ) xGuardedSlots[ xIndex ].pv, 16U );
+        prvGuardedAppend( cMessage, &xLength, sizeof( cMessage ), ( xGuardedSlots[ xIndex ].xAllocated != 0 ) ? ", live)\n" : ", freed)\n" );
+
+        ( void ) write( STDERR_FILENO, cMessage, xLength );
+    }
+
+    /**
+     * @brief 从守护池分配：选最久以前释放的空闲槽，把对象右对齐到紧邻守护页的位置。
+     * @return void* 用户区指针；池未能建立、池满或对象放不进一页时返回 NULL
+     */
+    static void * prvGuardedMalloc( size_t xWantedSize, size_t xAlignment )
+    {
+        HeapGuardedSlot_t * pxSlot = NULL;
+        uint8_t * pucPool;
+        size_t xIndex;
+        void * pvReturn = NULL;
+
+        pthread_mutex_lock( &xGuardedMutex );
+        {
+            if( pucGuardedPool == NULL )
+            {
+                xGuardedPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+                pucPool = mmap( NULL, heapGUARDED_POOL_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+
+                if( pucPool != MAP_FAILED )
+                {
+                    __atomic_store_n( &pucGuardedPool, pucPool, __ATOMIC_RELEASE );
+                }
+            }
+
+            if( ( pucGuardedPool != NULL ) && ( xWantedSize <= xGuardedPageSize ) && ( xAlignment <= xGuardedPageSize ) )
+            {
+                for( xIndex = 0; xIndex < configHEAP_GUARDED_SLOTS; xIndex++ )
+                {
+                    if( ( xGuardedSlots[ xIndex ].xAllocated == 0 ) &&
+                        ( ( pxSlot == NULL ) || ( xGuardedSlots[ xIndex ].xFreedAt < pxSlot->xFreedAt ) ) )
+                    {
+                        pxSlot = &xGuardedSlots[ xIndex ];
+                    }
+                }
+
+                if( ( pxSlot != NULL ) &&
+                    ( mprotect( heapGUARDED_SLOT_PAGE( pxSlot - xGuardedSlots ), xGuardedPageSize, PROT_READ | PROT_WRITE ) == 0 ) )
+                {
+                    /* 对齐要求可能在对象末尾留下不超过 xAlignment - 1 字节的空隙，这部分越界无法检测 */
+                    pvReturn = ( void * ) ( ( ( uintptr_t ) heapGUARDED_SLOT_PAGE( pxSlot - xGuardedSlots ) + xGuardedPageSize - xWantedSize ) &
+                                            ~( ( uintptr_t ) xAlignment - 1 ) );
+                    pxSlot->pv = pvReturn;
+                    pxSlot->xSize = xWantedSize;
+                    pxSlot->xAllocated = 1;
+                }
+            }
+        }
+        pthread_mutex_unlock( &xGuardedMutex );
+
+        return pvReturn;
+    }
+
+    /**
+     * @brief 分配前调用：线程局部倒计时用尽时尝试从守护池分配。
+     * 间隔在 [1, 2 * configHEAP_GUARDED_SAMPLE_RATE - 1] 中均匀抽取，避免与固定的分配模式同步。
+     * @return void* 守护池中的对象；本次未被抽中或守护池无法提供时返回 NULL
+     */
+    static inline void * prvGuardedSample( size_t xWantedSize, size_t xAlignment )
+    {
+        void * pvReturn = NULL;
+
+        if( xAllocationsUntilGuarded > 1 )
+        {
+            xAllocationsUntilGuarded--;
+        }
+        else
+        {
+            if( ulGuardedRandom == 0 )
+            {
+                ulGuardedRandom = ( uint32_t ) ( ( uintptr_t ) &xAllocationsUntilGuarded >> 4 ) | 1U;
+            }
+            else if( xWantedSize > 0 )
+            {
+                pvReturn = prvGuardedMalloc( xWantedSize, xAlignment );
+            }
+
+            /* xorshift32 */
+            ulGuardedRandom ^= ulGuardedRandom << 13;
+            ulGuardedRandom ^= ulGuardedRandom >> 17;
+            ulGuardedRandom ^= ulGuardedRandom << 5;
+            xAllocationsUntilGuarded = 1U + ( ulGuardedRandom % ( ( 2U * configHEAP_GUARDED_SAMPLE_RATE ) - 1U ) );
+        }
+
+        return pvReturn;
+    }
+
+    /**
+     * @brief 释放守护池中的对象：校验指针，丢弃页面内容并恢复为不可访问。
+     * 重复释放或指针不是对象起始地址时报告错误并终止进程。
+     */
+    static void prvGuardedFree( void * pv )
+    {
+        size_t xPage = ( size_t ) ( ( uint8_t * ) pv - pucGuardedPool ) / xGuardedPageSize;
+        size_t xIndex = xPage / 2;
+
+        pthread_mutex_lock( &xGuardedMutex );
+        {
+            if( ( ( xPage & 1U ) == 0 ) || ( xGuardedSlots[ xIndex ].pv != pv ) )
+            {
+                prvGuardedReport( "invalid free", pv, ( xIndex < configHEAP_GUARDED_SLOTS ) ? xIndex : configHEAP_GUARDED_SLOTS - 1 );
+                abort();
+            }
+
+            if( xGuardedSlots[ xIndex ].xAllocated == 0 )
+            {
+                prvGuardedReport( "double free", pv, xIndex );
+                abort();
+            }
+
+            /* 丢弃页面后再次访问时读到的是零页，已释放数据不会残留 */
+            ( void ) madvise( heapGUARDED_SLOT_PAGE( xIndex ), xGuardedPageSize, MADV_DONTNEED );
+            ( void ) mprotect( heapGUARDED_SLOT_PAGE( xIndex ), xGuardedPageSize, PROT_NONE );
+            xGuardedSlots[ xIndex ].xAllocated = 0;
+            xGuardedSlots[ xIndex ].xFreedAt = ++xGuardedFreeSequence;
+        }
+        pthread_mutex_unlock( &xGuardedMutex );
+    }
+
+    static size_t prvGuardedSize( const void * pv )
+    {
+        return xGuardedSlots[ ( ( size_t ) ( ( const uint8_t * ) pv - pucGuardedPool ) / xGuardedPageSize ) / 2 ].xSize;
+    }
+#endif
+
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 2 ) || ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+    #if defined( __SSE2__ )
+        #include <emmintrin.h>
+    #endif
+
+    /**
+     * @brief 清零一段内存：大块用非临时存储直接写回内存，不占用缓存。
+     */
+    static void prvClearMemory( void * pv, size_t xSize )
+    {
+        uint8_t * puc = ( uint8_t * ) pv;
+
+        #if defined( __SSE2__ )
+        {
+            size_t xHead;
+            __m128i xZero;
+
+            if( xSize >= configHEAP_CLEAR_NON_TEMPORAL_THRESHOLD )
+            {
+                xHead = ( 16U - ( ( uintptr_t ) puc & 15U ) ) & 15U;
+                memset( puc, 0, xHead );
+                puc += xHead;
+                xSize -= xHead;
+                xZero = _mm_setzero_si128();
+
+                for( ; xSize >= 64U; xSize -= 64U, puc += 64U )
+                {
+                    _mm_stream_si128( ( __m128i * ) puc, xZero );
+                    _mm_stream_si128( ( __m128i * ) ( puc + 16 ), xZero );
+                    _mm_stream_si128( ( __m128i * ) ( puc + 32 ), xZero );
+                    _mm_stream_si128( ( __m128i * ) ( puc + 48 ), xZero );
+                }
+
+                /* 非临时存储是弱序的，块重新可见之前必须全部完成 */
+                _mm_sfence();
+            }
+        }
+        #endif
+
+        memset( puc, 0, xSize );
+    }
+#endif
+
+/* 释放路径上的清零；策略 3 不在释放时清零，策略 4 只有 vPortFree / vPortFreeSized 延迟清零，其余路径同步清零 */
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+    #define heapCLEAR_ON_FREE( pv, xSize )          memset( ( pv ), 0, ( xSize ) )
+#elif ( configHEAP_CLEAR_MEMORY_ON_FREE == 2 ) || ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+    #define heapCLEAR_ON_FREE( pv, xSize )          prvClearMemory( ( pv ), ( xSize ) )
+#else
+    #define heapCLEAR_ON_FREE( pv, xSize )
+#endif
+
+/* 分配路径上的清零（策略 3），在释放堆锁之后进行；块大小取自块头，覆盖整个用户区 */
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 3 )
+    #define heapCLEAR_ON_ALLOCATE( pv )             memset( ( pv ), 0, heapBLOCK_SIZE( ( ( BlockLink_t * ) ( ( ( uint8_t * ) ( pv ) ) - xHeapStructSize ) ) ) - xHeapStructSize )
+#else
+    #define heapCLEAR_ON_ALLOCATE( pv )
+#endif
+
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+    static BlockLink_t * pxPendingClear = NULL;  /* 待清零队列（后进先出），经 pxNextFreeBlock 链接 */
+    static size_t xPendingClearBytes = 0U;       /* 待清零的块大小之和 */
+#endif
+
+#if ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 )
+    static uint8_t ucHeapReserve[ configHEAP_EMERGENCY_RESERVE_SIZE ];
+    static BlockLink_t xReserveStart;            /* 储备区空闲链表头，链表按地址升序，以 NULL 结尾 */
+    static int xReserveInitialised = 0;
+    static HeapReserveStats_t xReserveStats;
+
+    /**
+     * @brief pv 是否位于储备区。储备区地址固定，无需加锁。
+     */
+    static inline int prvReserveOwns( const void * pv )
+    {
+        return ( ( uintptr_t ) pv - ( uintptr_t ) ucHeapReserve ) < configHEAP_EMERGENCY_RESERVE_SIZE;
+    }
+
+    /**
+     * @brief 把整个储备区初始化为一个空闲块。调用者必须持有 HEAP_LOCK。
+     */
+    static void prvReserveInit( void )
+    {
+        uintptr_t uxStart = ( ( uintptr_t ) ucHeapReserve + portBYTE_ALIGNMENT_MASK ) & ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK );
+        BlockLink_t * pxBlock = ( BlockLink_t * ) uxStart;
+
+        pxBlock->xBlockSize = ( configHEAP_EMERGENCY_RESERVE_SIZE - ( size_t ) ( uxStart - ( uintptr_t ) ucHeapReserve ) ) & ~portBYTE_ALIGNMENT_MASK;
+        pxBlock->pxNextFreeBlock = NULL;
+        xReserveStart.pxNextFreeBlock = pxBlock;
+        xReserveStats.xReserveSize = pxBlock->xBlockSize;
+        xReserveStats.xFreeBytes = pxBlock->xBlockSize;
+        xReserveStats.xMinimumEverFreeBytes = pxBlock->xBlockSize;
+        xReserveInitialised = 1;
+    }
+
+    /**
+     * @brief 从储备区按首次适配分配，块格式与主堆相同。
+     * @param xWantedSize 已由 prvBlockSizeFor 换算的块大小
+     */
+    static void * prvReserveMalloc( size_t xWantedSize )
+    {
+        BlockLink_t * pxPreviousBlock = &xReserveStart, * pxBlock, * pxNewBlockLink;
+        void * pvReturn = NULL;
+
+        HEAP_LOCK_FOR( eHeapLockPathMalloc );
+        {
+            if( xReserveInitialised == 0 ) { prvReserveInit(); }
+
+            for( pxBlock = xReserveStart.pxNextFreeBlock; ( pxBlock != NULL ) && ( pxBlock->xBlockSize < xWantedSize ); pxBlock = pxBlock->pxNextFreeBlock )
+            {
+                pxPreviousBlock = pxBlock;
+            }
+
+            if( ( xWantedSize > 0 ) && ( pxBlock != NULL ) )
+            {
+                pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+
+                if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+                {
+                    pxNewBlockLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+                    pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+                    pxNewBlockLink->pxNextFreeBlock = pxPreviousBlock->pxNextFreeBlock;
+                    pxPreviousBlock->pxNextFreeBlock = pxNewBlockLink;
+                    pxBlock->xBlockSize = xWantedSize;
+                }
+
+                xReserveStats.xFreeBytes -= pxBlock->xBlockSize;
+                if( xReserveStats.xFreeBytes < xReserveStats.xMinimumEverFreeBytes )
+                {
+                    xReserveStats.xMinimumEverFreeBytes = xReserveStats.xFreeBytes;
+                }
+
+                heapALLOCATE_BLOCK( pxBlock );
+                pxBlock->pxNextFreeBlock = NULL;
+                xReserveStats.xAllocations++;
+                pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+            }
+            else
+            {
+                xReserveStats.xFailures++;
+            }
+        }
+        HEAP_UNLOCK();
+
+        if( pvReturn != NULL )
+        {
+            heapCLEAR_ON_ALLOCATE( pvReturn );
+        }
+
+        return pvReturn;
+    }
+
+    /**
+     * @brief 把块还给储备区，与地址相邻的空闲块合并。
+     */
+    static void prvReserveFree( void * pv )
+    {
+        BlockLink_t * pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+        BlockLink_t * pxIterator, * pxNext;
+
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxBlock ) != 0 );
+        configASSERT( pxBlock->pxNextFreeBlock == NULL );
+
+        heapCLEAR_ON_FREE( pv, heapBLOCK_SIZE( pxBlock ) - xHeapStructSize );
+
+        HEAP_LOCK_FOR( eHeapLockPathFree );
+        {
+            heapFREE_BLOCK( pxBlock );
+            xReserveStats.xFreeBytes += pxBlock->xBlockSize;
+
+            for( pxIterator = &xReserveStart; ( pxIterator->pxNextFreeBlock != NULL ) && ( pxIterator->pxNextFreeBlock < pxBlock ); pxIterator = pxIterator->pxNextFreeBlock ) {}
+
+            pxNext = pxIterator->pxNextFreeBlock;
+
+            if( ( pxNext != NULL ) && ( ( ( uint8_t * ) pxBlock ) + pxBlock->xBlockSize == ( uint8_t * ) pxNext ) )
+            {
+                pxBlock->xBlockSize += pxNext->xBlockSize;
+                pxNext = pxNext->pxNextFreeBlock;
+            }
+
+            pxBlock->pxNextFreeBlock = pxNext;
+
+            if( ( pxIterator != &xReserveStart ) && ( ( ( uint8_t * ) pxIterator ) + pxIterator->xBlockSize == ( uint8_t * ) pxBlock ) )
+            {
+                pxIterator->xBlockSize += pxBlock->xBlockSize;
+                pxIterator->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+            }
+            else
+            {
+                pxIterator->pxNextFreeBlock = pxBlock;
+            }
+        }
+        HEAP_UNLOCK();
+    }
+#endif /* configHEAP_EMERGENCY_RESERVE_SIZE */
+
+/* 空闲链表在 pxBlock 处发生了变化（块被分配、释放、合并、分裂或移动），调用者必须持有 HEAP_LOCK */
+#define heapFREE_LIST_CHANGED( pxBlock )            do { heapCOMPACT_INVALIDATE(); heapCHECK_INVALIDATE( pxBlock ); } while( 0 )
+
+#if ( configHEAP_FRAGMENTATION_METRICS == 1 )
+    static size_t xFreeBlockHistogram[ heapFRAGMENTATION_HISTOGRAM_BUCKETS ]; /* 按 log2(块大小) 统计的空闲块个数 */
+    static size_t xNumberOfFreeBlocks = 0U;      /* 空闲块总数 */
+    static size_t xLargestFreeBlock = 0U;        /* 最大空闲块大小（仅在 xLargestFreeBlockValid 时准确） */
+    static int xLargestFreeBlockValid = 1;       /* 最大块被摘下后置 0，查询时再遍历一次重算 */
+    static size_t xTotalSearchSteps = 0U;        /* 分配时查找经过的空闲块总数 */
+    static size_t xNumberOfSearches = 0U;        /* 分配时查找的次数 */
+
+    /* 返回 floor(log2(x))，x 必须大于 0 */
+    static size_t prvLog2( size_t x )
+    {
+        size_t xBit = 0;
+
+        while( ( x >>= 1 ) != 0 )
+        {
+            xBit++;
+        }
+
+        return xBit;
+    }
+
+    static void prvFreeBlockAdded( size_t xBlockSize )
+    {
+        xFreeBlockHistogram[ prvLog2( xBlockSize ) ]++;
+        xNumberOfFreeBlocks++;
+
+        if( xBlockSize > xLargestFreeBlock )
+        {
+            xLargestFreeBlock = xBlockSize;
+        }
+    }
+
+    static void prvFreeBlockRemoved( size_t xBlockSize )
+    {
+        xFreeBlockHistogram[ prvLog2( xBlockSize ) ]--;
+        xNumberOfFreeBlocks--;
+
+        if( xBlockSize == xLargestFreeBlock )
+        {
+            xLargestFreeBlockValid = 0;
+        }
+    }
+
+    #define heapFREE_BLOCK_ADDED( xBlockSize )      prvFreeBlockAdded( xBlockSize )
+    #define heapFREE_BLOCK_REMOVED( xBlockSize )    prvFreeBlockRemoved( xBlockSize )
+    #define heapSEARCH_STEP()                       xTotalSearchSteps++
+    #define heapSEARCH_STEPS( xSteps )              xTotalSearchSteps += ( xSteps )
+    #define heapSEARCH_DONE()                       xNumberOfSearches++
+#else
+    #define heapFREE_BLOCK_ADDED( xBlockSize )
+    #define heapFREE_BLOCK_REMOVED( xBlockSize )
+    #define heapSEARCH_STEP()
+    #define heapSEARCH_STEPS( xSteps )
+    #define heapSEARCH_DONE()
+#endif
+
+#if ( configHEAP_FREE_INDEX == 1 )
+    static uint32_t ulFreeIndexSize[ configHEAP_FREE_INDEX_CAPACITY ];   /* 空闲块大小，饱和到 UINT32_MAX */
+    static uint32_t ulFreeIndexOffset[ configHEAP_FREE_INDEX_CAPACITY ]; /* 空闲块相对 ucHeap 的位置，升序 */
+    static size_t xFreeIndexCount = 0U;  /* 索引中的条目数 */
+    static size_t xFreeIndexBlocks = 0U; /* 空闲链表中的块数（索引暂停时仍然维护） */
+    static int xFreeIndexValid = 0;      /* 索引是否与空闲链表一致 */
+
+    #define heapINDEX_BLOCK( xIndex )       ( ( BlockLink_t * ) ( ( uintptr_t ) ucHeap + ( ( uintptr_t ) ulFreeIndexOffset[ xIndex ] * portBYTE_ALIGNMENT ) ) )
+
+    static inline uint32_t prvFreeIndexUnits( size_t xBytes )
+    {
+        return ( ( xBytes / portBYTE_ALIGNMENT ) < UINT32_MAX ) ? ( uint32_t ) ( xBytes / portBYTE_ALIGNMENT ) : UINT32_MAX;
+    }
+
+    /**
+     * @brief 从 xIndex 开始逐个比较，返回第一个大小不小于 ulWanted 的条目下标，没有时返回 xFreeIndexCount。
+     */
+    static size_t prvFreeIndexScanFrom( uint32_t ulWanted, size_t xIndex )
+    {
+        while( ( xIndex < xFreeIndexCount ) && ( ulFreeIndexSize[ xIndex ] < ulWanted ) )
+        {
+            xIndex++;
+        }
+
+        return xIndex;
+    }
+
+    static size_t prvFreeIndexScan( uint32_t ulWanted )
+    {
+        return prvFreeIndexScanFrom( ulWanted, 0U );
+    }
+
+    #if ( configHEAP_FREE_INDEX_SIMD == 1 ) && ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __SSE2__ )
+        #include <immintrin.h>
+
+        /*
+         * SSE2 / AVX2 只有有符号的 32 位比较：两边同时异或 0x80000000 后，有符号比较的结果与无符号比较相同。
+         * ulWanted 至少为 1，"大小 >= ulWanted" 等价于 "大小 > ulWanted - 1"。
+         */
+        #define heapINDEX_SIGN_BIAS    ( ( int ) 0x80000000U )
+
+        /**
+         * @brief SSE2 版本：每轮比较 16 个条目，命中后由各段掩码定位第一个满足条件的条目。
+         */
+        static size_t prvFreeIndexScanSSE2( uint32_t ulWanted )
+        {
+            const __m128i xBias = _mm_set1_epi32( heapINDEX_SIGN_BIAS );
+            const __m128i xLimit = _mm_xor_si128( _mm_set1_epi32( ( int ) ( ulWanted - 1U ) ), xBias );
+            const __m128i * pxSizes;
+            size_t xIndex;
+            unsigned int uxMask;
+
+            for( xIndex = 0U; ( xIndex + 16U ) <= xFreeIndexCount; xIndex += 16U )
+            {
+                pxSizes = ( const __m128i * ) &ulFreeIndexSize[ xIndex ];
+                uxMask = ( unsigned int ) _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( _mm_xor_si128( _mm_loadu_si128( pxSizes ), xBias ), xLimit ) ) );
+                uxMask |= ( unsigned int ) _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( _mm_xor_si128( _mm_loadu_si128( pxSizes + 1 ), xBias ), xLimit ) ) ) << 4;
+                uxMask |= ( unsigned int ) _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( _mm_xor_si128( _mm_loadu_si128( pxSizes + 2 ), xBias ), xLimit ) ) ) << 8;
+                uxMask |= ( unsigned int ) _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( _mm_xor_si128( _mm_loadu_si128( pxSizes + 3 ), xBias ), xLimit ) ) ) << 12;
+
+                if( uxMask != 0U )
+                {
+                    return xIndex + ( size_t ) __builtin_ctz( uxMask );
+                }
+            }
+
+            return prvFreeIndexScanFrom( ulWanted, xIndex );
+        }
+
+        /**
+         * @brief AVX2 版本：每轮比较 32 个条目。编译时不要求 -mavx2，只在运行时确认支持后才会被调用。
+         */
+        __attribute__( ( target( "avx2" ) ) ) static size_t prvFreeIndexScanAVX2( uint32_t ulWanted )
+        {
+            const __m256i xBias = _mm256_set1_epi32( heapINDEX_SIGN_BIAS );
+            const __m256i xLimit = _mm256_xor_si256( _mm256_set1_epi32( ( int ) ( ulWanted - 1U ) ), xBias );
+            const __m256i * pxSizes;
+            size_t xIndex;
+            uint64_t uxMask;
+
+            for( xIndex = 0U; ( xIndex + 32U ) <= xFreeIndexCount; xIndex += 32U )
+            {
+                pxSizes = ( const __m256i * ) &ulFreeIndexSize[ xIndex ];
+                uxMask = ( uint64_t ) ( unsigned int ) _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_xor_si256( _mm256_loadu_si256( pxSizes ), xBias ), xLimit ) ) );
+                uxMask |= ( uint64_t ) ( unsigned int ) _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_xor_si256( _mm256_loadu_si256( pxSizes + 1 ), xBias ), xLimit ) ) ) << 8;
+                uxMask |= ( uint64_t ) ( unsigned int ) _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_xor_si256( _mm256_loadu_si256( pxSizes + 2 ), xBias ), xLimit ) ) ) << 16;
+                uxMask |= ( uint64_t ) ( unsigned int ) _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_xor_si256( _mm256_loadu_si256( pxSizes + 3 ), xBias ), xLimit ) ) ) << 24;
+
+                if( uxMask != 0U )
+                {
+                    return xIndex + ( size_t ) __builtin_ctzll( uxMask );
+                }
+            }
+
+            return prvFreeIndexScanFrom( ulWanted, xIndex );
+        }
+
+        /**
+         * @brief 按当前 CPU 选择扫描函数。预加载时可能早于构造函数运行，先显式初始化 CPU 特性检测。
+         */
+        static size_t ( * prvFreeIndexSelectScan( void ) )( uint32_t )
+        {
+            __builtin_cpu_init();
+
+            return ( __builtin_cpu_supports( "avx2" ) != 0 ) ? prvFreeIndexScanAVX2 : prvFreeIndexScanSSE2;
+        }
+    #else
+        static size_t ( * prvFreeIndexSelectScan( void ) )( uint32_t )
+        {
+            return prvFreeIndexScan;
+        }
+    #endif
+
+    /* 当前使用的扫描函数，在重建索引时选定 */
+    static size_t ( * pxFreeIndexScan )( uint32_t ) = prvFreeIndexScan;
+
+    /**
+     * @brief 二分查找第一个位置不小于 pxBlock 的条目。
+     */
+    static size_t prvFreeIndexLowerBound( const BlockLink_t * pxBlock )
+    {
+        uint32_t ulOffset = ( uint32_t ) ( ( ( uintptr_t ) pxBlock - ( uintptr_t ) ucHeap ) / portBYTE_ALIGNMENT );
+        size_t xLow = 0U, xHigh = xFreeIndexCount, xMid;
+
+        while( xLow < xHigh )
+        {
+            xMid = ( xLow + xHigh ) / 2U;
+
+            if( ulFreeIndexOffset[ xMid ] < ulOffset )
+            {
+                xLow = xMid + 1U;
+            }
+            else
+            {
+                xHigh = xMid;
+            }
+        }
+
+        return xLow;
+    }
+
+    /**
+     * @brief 新的空闲块进入链表后登记到索引；容量不足或位置超出 32 位表示范围时暂停索引。
+     */
+    static void prvFreeIndexInsert( const BlockLink_t * pxBlock )
+    {
+        size_t xIndex;
+
+        xFreeIndexBlocks++;
+
+        if( xFreeIndexValid != 0 )
+        {
+            if( ( xFreeIndexCount == configHEAP_FREE_INDEX_CAPACITY ) ||
+                ( ( ( ( uintptr_t ) pxBlock - ( uintptr_t ) ucHeap ) / portBYTE_ALIGNMENT ) > UINT32_MAX ) )
+            {
+                xFreeIndexValid = 0;
+            }
+            else
+            {
+                xIndex = prvFreeIndexLowerBound( pxBlock );
+                memmove( &ulFreeIndexSize[ xIndex + 1U ], &ulFreeIndexSize[ xIndex ], ( xFreeIndexCount - xIndex ) * sizeof( uint32_t ) );
+                memmove( &ulFreeIndexOffset[ xIndex + 1U ], &ulFreeIndexOffset[ xIndex ], ( xFreeIndexCount - xIndex ) * sizeof( uint32_t ) );
+                ulFreeIndexSize[ xIndex ] = prvFreeIndexUnits( pxBlock->xBlockSize );
+                ulFreeIndexOffset[ xIndex ] = ( uint32_t ) ( ( ( uintptr_t ) pxBlock - ( uintptr_t ) ucHeap ) / portBYTE_ALIGNMENT );
+                xFreeIndexCount++;
+            }
+        }
+    }
+
+    /**
+     * @brief 空闲块离开链表（被分配或被合并）后从索引中删除。
+     */
+    static void prvFreeIndexRemove( const BlockLink_t * pxBlock )
+    {
+        size_t xIndex;
+
+        xFreeIndexBlocks--;
+
+        if( xFreeIndexValid != 0 )
+        {
+            xIndex = prvFreeIndexLowerBound( pxBlock );
+            configASSERT( ( xIndex < xFreeIndexCount ) && ( heapINDEX_BLOCK( xIndex ) == pxBlock ) );
+            xFreeIndexCount--;
+            memmove( &ulFreeIndexSize[ xIndex ], &ulFreeIndexSize[ xIndex + 1U ], ( xFreeIndexCount - xIndex ) * sizeof( uint32_t ) );
+            memmove( &ulFreeIndexOffset[ xIndex ], &ulFreeIndexOffset[ xIndex + 1U ], ( xFreeIndexCount - xIndex ) * sizeof( uint32_t ) );
+        }
+    }
+
+    /**
+     * @brief 空闲块原地改变大小（合并、分裂）后更新索引。
+     */
+    static void prvFreeIndexResize( const BlockLink_t * pxBlock )
+    {
+        size_t xIndex;
+
+        if( xFreeIndexValid != 0 )
+        {
+            xIndex = prvFreeIndexLowerBound( pxBlock );
+            configASSERT( ( xIndex < xFreeIndexCount ) && ( heapINDEX_BLOCK( xIndex ) == pxBlock ) );
+            ulFreeIndexSize[ xIndex ] = prvFreeIndexUnits( pxBlock->xBlockSize );
+        }
+    }
+
+    /**
+     * @brief 沿空闲链表重建索引（堆初始化、快照恢复后，或暂停后空闲块已足够少时）。
+     * @return int 重建成功返回 1
+     */
+    static int prvFreeIndexRebuild( void )
+    {
+        BlockLink_t * pxBlock;
+
+        xFreeIndexCount = 0U;
+        xFreeIndexBlocks = 0U;
+        xFreeIndexValid = 1;
+        pxFreeIndexScan = prvFreeIndexSelectScan();
+
+        for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+        {
+            prvFreeIndexInsert( pxBlock );
+        }
+
+        return xFreeIndexValid;
+    }
+
+    /**
+     * @brief 索引当前是否可用；暂停中且空闲块已足够少时顺便重建。
+     */
+    static inline int prvFreeIndexUsable( void )
+    {
+        if( ( xFreeIndexValid == 0 ) && ( xFreeIndexBlocks <= ( configHEAP_FREE_INDEX_CAPACITY / 2U ) ) )
+        {
+            ( void ) prvFreeIndexRebuild();
+        }
+
+        return xFreeIndexValid;
+    }
+
+    #define heapINDEX_INSERT( pxBlock )             prvFreeIndexInsert( pxBlock )
+    #define heapINDEX_REMOVE( pxBlock )             prvFreeIndexRemove( pxBlock )
+    #define heapINDEX_RESIZE( pxBlock )             prvFreeIndexResize( pxBlock )
+#else
+    #define heapINDEX_INSERT( pxBlock )
+    #define heapINDEX_REMOVE( pxBlock )
+    #define heapINDEX_RESIZE( pxBlock )
+#endif
+
+#if ( configHEAP_SAMPLING_PROFILER == 1 )
+    #include <execinfo.h>
+    #include <inttypes.h>
+    #include <stdio.h>
+
+    /* 调用点：同一条调用栈上被抽中的分配都归到同一项 */
+    typedef struct xHEAP_PROFILE_SITE
+    {
+        void * pvStack[ configHEAP_PROFILER_STACK_DEPTH ]; /**< 返回地址，由内向外 */
+        size_t xDepth;      /**< 有效帧数，0 表示该项空闲 */
+        size_t xLiveCount;  /**< 仍存活的样本个数 */
+        size_t xLiveBytes;  /**< 仍存活的样本请求字节数 */
+        size_t xPeakCount;  /**< 达到 xPeakBytes 时的存活样本个数 */
+        size_t xPeakBytes;  /**< xLiveBytes 的历史最大值 */
+        size_t xAllocCount; /**< 累计样本个数 */
+        size_t xAllocBytes; /**< 累计样本请求字节数 */
+    } HeapProfileSite_t;
+
+    /* 存活样本：被抽中的块到调用点的映射，线性探测开放寻址 */
+    typedef struct xHEAP_PROFILE_LIVE
+    {
+        void * pv;    /**< 用户区指针，NULL 表示空槽 */
+        size_t xSite; /**< 所属调用点在 xProfileSites 中的下标 */
+        size_t xSize; /**< 请求字节数 */
+    } HeapProfileLive_t;
+
+    /* 分配前抓取的样本，xDepth 为 0 表示本次分配不采样 */
+    typedef struct xHEAP_PROFILE_SAMPLE
+    {
+        void * pvStack[ configHEAP_PROFILER_STACK_DEPTH ];
+        size_t xDepth;
+        size_t xSize;
+    } HeapProfileSample_t;
+
+    static HeapProfileSite_t xProfileSites[ configHEAP_PROFILER_MAX_SITES ];
+    static HeapProfileLive_t xProfileLive[ configHEAP_PROFILER_MAX_LIVE ];
+    static size_t xProfileLiveCount = 0U;  /* xProfileLive 中已占用的槽数 */
+    static size_t xProfileInterval = configHEAP_PROFILER_SAMPLE_INTERVAL; /* 0 表示暂停采样 */
+
+    /* 保护上面两张表；与 HEAP_LOCK 同时持有时必须先取这把锁 */
+    static pthread_mutex_t xProfileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+    /* 线程局部的采样倒计时与随机数状态；initial-exec 模型保证访问它们不会触发分配 */
+    static __thread size_t xBytesUntilSample __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+    static __thread uint64_t uxProfileRandom __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+    static __thread int xInsideProfiler __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+
+    /* 暂停采样时，每分配这么多字节才重新读取一次采样间隔 */
+    #define heapPROFILER_PAUSED_RECHECK         ( ( size_t ) 1024 * 1024 )
+
+    /**
+     * @brief 按指数分布抽取到下一次采样为止的字节数（均值为 xInterval），
+     * 使采样点在字节流上构成泊松过程，与分配大小和分配顺序无关。
+     * -ln(u) 用分段线性加二次修正的 log2 近似计算，避免依赖 libm。
+     */
+    static size_t prvNextSampleInterval( size_t xInterval )
+    {
+        uint64_t q;
+        size_t xExponent = 0;
+        double dMantissa, dLog2;
+
+        /* xorshift64 */
+        uxProfileRandom ^= uxProfileRandom << 13;
+        uxProfileRandom ^= uxProfileRandom >> 7;
+        uxProfileRandom ^= uxProfileRandom << 17;
+
+        /* q 在 [1, 2^26] 中均匀分布，-ln(q / 2^26) = (26 - log2(q)) * ln2 */
+        q = ( uxProfileRandom >> 38 ) + 1U;
+
+        while( ( q >> ( xExponent + 1 ) ) != 0 )
+        {
+            xExponent++;
+        }
+
+        dMantissa = ( ( double ) q / ( double ) ( ( uint64_t ) 1 << xExponent ) ) - 1.0;
+        dLog2 = ( double ) xExponent + dMantissa * ( 1.0 + 0.3466 * ( 1.0 - dMantissa ) );
+
+        return ( size_t ) ( ( 26.0 - dLog2 ) * 0.6931471805599453 * ( double ) xInterval ) + 1U;
+    }
+
+    /**
+     * @brief 倒计时用尽后的慢路径：决定本次是否采样，需要时在加锁之前抓取调用栈。
+     */
+    static __attribute__( ( noinline ) ) void prvProfileSample( HeapProfileSample_t * pxSample, size_t xSize )
+    {
+        void * pvStack[ configHEAP_PROFILER_STACK_DEPTH + 1 ];
+        size_t xInterval = __atomic_load_n( &xProfileInterval, __ATOMIC_RELAXED );
+        int xDepth;
+
+        if( uxProfileRandom == 0 )
+        {
+            /* 线程第一次分配：只播种，不采样 */
+            uxProfileRandom = ( ( uint64_t ) ( uintptr_t ) &xBytesUntilSample * 0x9E3779B97F4A7C15ULL ) | 1U;
+        }
+        else if( ( xInterval != 0 ) && ( xInsideProfiler == 0 ) )
+        {
+            /* backtrace 首次调用时可能分配内存，期间不再递归采样 */
+            xInsideProfiler++;
+            xDepth = backtrace( pvStack, configHEAP_PROFILER_STACK_DEPTH + 1 );
+            xInsideProfiler--;
+
+            /* 跳过本函数自身所在的帧 */
+            if( xDepth > 1 )
+            {
+                pxSample->xDepth = ( size_t ) xDepth - 1;
+                pxSample->xSize = xSize;
+                memcpy( pxSample->pvStack, &pvStack[ 1 ], pxSample->xDepth * sizeof( void * ) );
+            }
+        }
+
+        xBytesUntilSample = ( xInterval != 0 ) ? prvNextSampleInterval( xInterval ) : heapPROFILER_PAUSED_RECHECK;
+    }
+
+    /**
+     * @brief 分配前调用：扣减倒计时，用尽时进入慢路径。
+     */
+    static inline void prvProfileBeforeAlloc( HeapProfileSample_t * pxSample, size_t xSize )
+    {
+        pxSample->xDepth = 0;
+
+        if( xSize < xBytesUntilSample )
+        {
+            xBytesUntilSample -= xSize;
+        }
+        else
+        {
+            prvProfileSample( pxSample, xSize );
+        }
+    }
+
+    /* 存活样本表中指针的起始探测位置 */
+    #define heapPROFILE_LIVE_HOME( pv )         ( ( size_t ) ( ( ( ( uintptr_t ) ( pv ) ) >> 4 ) * ( uintptr_t ) 0x9E3779B97F4A7C15ULL ) & ( configHEAP_PROFILER_MAX_LIVE - 1 ) )
+
+    /**
+     * @brief 分配成功后调用（不持有 HEAP_LOCK）：把样本计入调用点并登记存活块。
+     * 表满时样本被丢弃，块上的采样标记保留也无妨，释放时查不到就忽略。
+     */
+    static void prvProfileRecord( const HeapProfileSample_t * pxSample, void * pv )
+    {
+        HeapProfileSite_t * pxSite = NULL;
+        size_t xHash = pxSample->xDepth, xIndex, i;
+
+        for( i = 0; i < pxSample->xDepth; i++ )
+        {
+            xHash = ( xHash ^ ( size_t ) ( uintptr_t ) pxSample->pvStack[ i ] ) * ( size_t ) 0x100000001B3ULL;
+        }
+
+        pthread_mutex_lock( &xProfileMutex );
+        {
+            xIndex = xHash & ( configHEAP_PROFILER_MAX_SITES - 1 );
+
+            for( i = 0; i < configHEAP_PROFILER_MAX_SITES; i++ )
+            {
+                pxSite = &xProfileSites[ xIndex ];
+
+                if( pxSite->xDepth == 0 )
+                {
+                    memcpy( pxSite->pvStack, pxSample->pvStack, pxSample->xDepth * sizeof( void * ) );
+                    pxSite->xDepth = pxSample->xDepth;
+                    break;
+                }
+
+                if( ( pxSite->xDepth == pxSample->xDepth ) &&
+                    ( memcmp( pxSite->pvStack, pxSample->pvStack, pxSample->xDepth * sizeof( void * ) ) == 0 ) )
+                {
+                    break;
+                }
+
+                xIndex = ( xIndex + 1 ) & ( configHEAP_PROFILER_MAX_SITES - 1 );
+            }
+
+            /* 始终保留一个空槽，保证探测一定能终止 */
+            if( ( i < configHEAP_PROFILER_MAX_SITES ) && ( xProfileLiveCount < ( configHEAP_PROFILER_MAX_LIVE - 1 ) ) )
+            {
+                for( i = heapPROFILE_LIVE_HOME( pv ); xProfileLive[ i ].pv != NULL; i = ( i + 1 ) & ( configHEAP_PROFILER_MAX_LIVE - 1 ) ) {}
+
+                xProfileLive[ i ].pv = pv;
+                xProfileLive[ i ].xSite = xIndex;
+                xProfileLive[ i ].xSize = pxSample->xSize;
+                xProfileLiveCount++;
+
+                pxSite->xAllocCount++;
+                pxSite->xAllocBytes += pxSample->xSize;
+                pxSite->xLiveCount++;
+                pxSite->xLiveBytes += pxSample->xSize;
+
+                if( pxSite->xLiveBytes > pxSite->xPeakBytes )
+                {
+                    pxSite->xPeakBytes = pxSite->xLiveBytes;
+                    pxSite->xPeakCount = pxSite->xLiveCount;
+                }
+            }
+        }
+        pthread_mutex_unlock( &xProfileMutex );
+    }
+
+    /**
+     * @brief 从存活样本表中删除第 i 项（向后移位删除，不留墓碑）。调用者必须持有 xProfileMutex。
+     */
+    static void prvProfileLiveRemove( size_t i )
+    {
+        size_t j, xHome;
+
+        xProfileLive[ i ].pv = NULL;
+        xProfileLiveCount--;
+
+        /* 把后面探测链上的项前移，填补空出的槽 */
+        for( j = ( i + 1 ) & ( configHEAP_PROFILER_MAX_LIVE - 1 ); xProfileLive[ j ].pv != NULL; j = ( j + 1 ) & ( configHEAP_PROFILER_MAX_LIVE - 1 ) )
+        {
+            xHome = heapPROFILE_LIVE_HOME( xProfileLive[ j ].pv );
+
+            if( ( i <= j ) ? ( ( i < xHome ) && ( xHome <= j ) ) : ( ( i < xHome ) || ( xHome <= j ) ) )
+            {
+                continue;
+            }
+
+            xProfileLive[ i ] = xProfileLive[ j ];
+            xProfileLive[ j ].pv = NULL;
+            i = j;
+        }
+    }
+
+    /**
+     * @brief 查找 pv 的存活样本所在的槽。调用者必须持有 xProfileMutex。
+     * @return size_t 槽的编号；pv 不在表中时返回一个空槽
+     */
+    static size_t prvProfileLiveFind( const void * pv )
+    {
+        size_t i;
+
+        for( i = heapPROFILE_LIVE_HOME( pv ); ( xProfileLive[ i ].pv != NULL ) && ( xProfileLive[ i ].pv != pv ); i = ( i + 1 ) & ( configHEAP_PROFILER_MAX_LIVE - 1 ) ) {}
+
+        return i;
+    }
+
+    /**
+     * @brief 释放带采样标记的块之前调用：注销存活样本。
+     * 必须在块还给堆之前完成，否则同一地址可能已被重新分配并登记。
+     */
+    static void prvProfileForget( void * pv )
+    {
+        size_t i;
+
+        pthread_mutex_lock( &xProfileMutex );
+        {
+            i = prvProfileLiveFind( pv );
+
+            if( xProfileLive[ i ].pv != NULL )
+            {
+                xProfileSites[ xProfileLive[ i ].xSite ].xLiveCount--;
+                xProfileSites[ xProfileLive[ i ].xSite ].xLiveBytes -= xProfileLive[ i ].xSize;
+                prvProfileLiveRemove( i );
+            }
+        }
+        pthread_mutex_unlock( &xProfileMutex );
+    }
+
+    /**
+     * @brief 带采样标记的块被原地或搬移调整大小后调用：样本改记到新地址与新大小下，仍归原调用点。
+     */
+    static void prvProfileMove( void * pvOld, void * pvNew, size_t xNewSize )
+    {
+        HeapProfileSite_t * pxSite;
+        size_t i, xSite;
+
+        pthread_mutex_lock( &xProfileMutex );
+        {
+            i = prvProfileLiveFind( pvOld );
+
+            if( xProfileLive[ i ].pv != NULL )
+            {
+                xSite = xProfileLive[ i ].xSite;
+                pxSite = &xProfileSites[ xSite ];
+                pxSite->xLiveBytes = pxSite->xLiveBytes - xProfileLive[ i ].xSize + xNewSize;
+
+                if( pxSite->xLiveBytes > pxSite->xPeakBytes )
+                {
+                    pxSite->xPeakBytes = pxSite->xLiveBytes;
+                    pxSite->xPeakCount = pxSite->xLiveCount;
+                }
+
+                /* 地址变了要按新地址重新探测；删除后再插入总能找到空槽 */
+                prvProfileLiveRemove( i );
+                xProfileLiveCount++;
+                i = prvProfileLiveFind( pvNew );
+                xProfileLive[ i ].pv = pvNew;
+                xProfileLive[ i ].xSite = xSite;
+                xProfileLive[ i ].xSize = xNewSize;
+            }
+        }
+        pthread_mutex_unlock( &xProfileMutex );
+    }
+
+    /* 释放路径：块带采样标记时注销样本 */
+    #define heapPROFILE_FREE( pxLink )          if( ( ( pxLink )->xBlockSize & heapBLOCK_SAMPLED_BITMASK ) != 0 ) { prvProfileForget( ( ( uint8_t * ) ( pxLink ) ) + xHeapStructSize ); }
+#else
+    #define heapPROFILE_FREE( pxLink )
+#endif
+
+#if ( configHEAP_LATENCY_HISTOGRAMS == 1 ) || ( configHEAP_LOCK_STATS == 1 )
+    /* 读取周期计数器：x86 用 TSC，AArch64 用虚拟计数器，其他平台退化为纳秒时钟 */
+    #ifndef configHEAP_READ_CYCLES
+        #if defined( __x86_64__ ) || defined( __i386__ )
+            #include <x86intrin.h>
+            #define configHEAP_READ_CYCLES()    ( ( uint64_t ) __rdtsc() )
+        #elif defined( __aarch64__ )
+            static inline uint64_t prvReadCycles( void )
+            {
+                uint64_t uxValue;
+                __asm__ volatile ( "mrs %0, cntvct_el0" : "=r" ( uxValue ) );
+                return uxValue;
+            }
+            #define configHEAP_READ_CYCLES()    prvReadCycles()
+        #else
+            #include <time.h>
+            static inline uint64_t prvReadCycles( void )
+            {
+                struct timespec xNow;
+                ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+                return ( ( uint64_t ) xNow.tv_sec * 1000000000U ) + ( uint64_t ) xNow.tv_nsec;
+            }
+            #define configHEAP_READ_CYCLES()    prvReadCycles()
+        #endif
+    #endif
+
+    /**
+     * @brief 对数线性分桶：小于 2^B 的值各占一桶，之后每个 2 的幂区间再等分成 2^B 个子桶
+     * （B = heapLATENCY_SUB_BUCKET_BITS），相对误差不超过 1/2^B。
+     */
+    static inline size_t prvLatencyBucket( uint64_t uxValue )
+    {
+        size_t xExponent;
+
+        if( uxValue < ( 1U << heapLATENCY_SUB_BUCKET_BITS ) )
+        {
+            return ( size_t ) uxValue;
+        }
+
+        xExponent = 63U - ( size_t ) __builtin_clzll( uxValue );
+
+        return ( ( xExponent - heapLATENCY_SUB_BUCKET_BITS + 1U ) << heapLATENCY_SUB_BUCKET_BITS ) +
+               ( size_t ) ( ( uxValue >> ( xExponent - heapLATENCY_SUB_BUCKET_BITS ) ) & ( ( 1U << heapLATENCY_SUB_BUCKET_BITS ) - 1U ) );
+    }
+#endif
+
+#if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+    /* 每个线程一份的直方图，只由所属线程写入；线程退出后可被新线程接管，计数继续累加 */
+    typedef struct xHEAP_LATENCY_RECORD
+    {
+        struct xHEAP_LATENCY_RECORD * pxNext; /**< 全局记录链表中的下一项，挂上后不再改变 */
+        int xInUse;                           /**< 是否有线程正在使用该记录 */
+        size_t xMallocCycles[ heapLATENCY_BUCKETS ];
+        size_t xMallocNodes[ heapLATENCY_BUCKETS ];
+        size_t xFreeCycles[ heapLATENCY_BUCKETS ];
+        size_t xFreeNodes[ heapLATENCY_BUCKETS ];
+    } HeapLatencyRecord_t;
+
+    static HeapLatencyRecord_t * pxLatencyRecords = NULL; /* 只增不减的无锁链表 */
+    static pthread_key_t xLatencyKey;                     /* 线程退出时归还记录 */
+    static pthread_once_t xLatencyKeyOnce = PTHREAD_ONCE_INIT;
+
+    static __thread HeapLatencyRecord_t * pxLatencyRecord __attribute__( ( tls_model( "initial-exec" ) ) ) = NULL;
+    static __thread size_t xNodesVisited __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+
+    static void prvLatencyThreadExit( void * pvRecord )
+    {
+        __atomic_store_n( &( ( HeapLatencyRecord_t * ) pvRecord )->xInUse, 0, __ATOMIC_RELEASE );
+    }
+
+    static void prvLatencyKeyCreate( void )
+    {
+        ( void ) pthread_key_create( &xLatencyKey, prvLatencyThreadExit );
+    }
+
+    /**
+     * @brief 为当前线程取得一份记录：优先接管已退出线程留下的记录，否则用 mmap 新建一份
+     * 挂到链表头。不经过本堆分配，避免在统计路径上递归。
+     * @return HeapLatencyRecord_t* 失败（mmap 失败）返回 NULL，本线程不做统计
+     */
+    static HeapLatencyRecord_t * prvLatencyAttach( void )
+    {
+        HeapLatencyRecord_t * pxRecord;
+        int xExpected;
+
+        ( void ) pthread_once( &xLatencyKeyOnce, prvLatencyKeyCreate );
+
+        for( pxRecord = __atomic_load_n( &pxLatencyRecords, __ATOMIC_ACQUIRE ); pxRecord != NULL; pxRecord = pxRecord->pxNext )
+        {
+            xExpected = 0;
+
+            if( __atomic_compare_exchange_n( &pxRecord->xInUse, &xExpected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) )
+            {
+                break;
+            }
+        }
+
+        if( pxRecord == NULL )
+        {
+            pxRecord = mmap( NULL, sizeof( HeapLatencyRecord_t ), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+            if( pxRecord == MAP_FAILED )
+            {
+                return NULL;
+            }
+
+            pxRecord->xInUse = 1;
+            pxRecord->pxNext = __atomic_load_n( &pxLatencyRecords, __ATOMIC_RELAXED );
+
+            while( !__atomic_compare_exchange_n( &pxLatencyRecords, &pxRecord->pxNext, pxRecord, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) ) {}
+        }
+
+        ( void ) pthread_setspecific( xLatencyKey, pxRecord );
+
+        return pxRecord;
+    }
+
+    /* 单写者计数：普通的读-加-写即可，relaxed 原子访问只是为了让并发读取不被撕裂 */
+    #define heapLATENCY_COUNT( xCounter )   __atomic_store_n( &( xCounter ), __atomic_load_n( &( xCounter ), __ATOMIC_RELAXED ) + 1U, __ATOMIC_RELAXED )
+
+    /**
+     * @brief 一次操作结束时调用：把耗时和遍历节点数计入本线程的直方图。
+     * @param xIsFree 0: pvPortMalloc；1: vPortFree
+     */
+    static void prvLatencyRecord( int xIsFree, uint64_t uxCycles )
+    {
+        HeapLatencyRecord_t * pxRecord = pxLatencyRecord;
+
+        if( pxRecord == NULL )
+        {
+            pxRecord = pxLatencyRecord = prvLatencyAttach();
+        }
+
+        if( pxRecord != NULL )
+        {
+            if( xIsFree != 0 )
+            {
+                heapLATENCY_COUNT( pxRecord->xFreeCycles[ prvLatencyBucket( uxCycles ) ] );
+                heapLATENCY_COUNT( pxRecord->xFreeNodes[ prvLatencyBucket( xNodesVisited ) ] );
+            }
+            else
+            {
+                heapLATENCY_COUNT( pxRecord->xMallocCycles[ prvLatencyBucket( uxCycles ) ] );
+                heapLATENCY_COUNT( pxRecord->xMallocNodes[ prvLatencyBucket( xNodesVisited ) ] );
+            }
+        }
+    }
+
+    #define heapNODE_VISITED()                      xNodesVisited++
+#else
+    #define heapNODE_VISITED()
+#endif
+
+#if ( configHEAP_LOCK_STATS == 1 )
+    /* 以下状态只在持有 xHeapMutex 时读写，由堆锁本身保护 */
+    static HeapLockStats_t xLockStats;
+    static HeapLockPath_t eLockHeldPath = eHeapLockPathOther; /* 当前持锁者的调用路径 */
+    static uint64_t uxLockAcquiredAt = 0U;                     /* 当前持锁者拿到锁的时刻 */
+
+    static void prvHeapLock( HeapLockPath_t ePath )
+    {
+        HeapLockPathStats_t * pxPath = &xLockStats.xPaths[ ePath ];
+        uint64_t uxWait = 0U;
+        uint64_t uxStart;
+
+        /* 先试一次：拿到即为无竞争，等锁时间记为 0；拿不到才计时阻塞等待 */
+        if( pthread_mutex_trylock( &xHeapMutex ) != 0 )
+        {
+            uxStart = configHEAP_READ_CYCLES();
+            ( void ) pthread_mutex_lock( &xHeapMutex );
+            uxWait = configHEAP_READ_CYCLES() - uxStart;
+            pxPath->xContended++;
+        }
+
+        pxPath->xAcquisitions++;
+        pxPath->uxWaitCycles += uxWait;
+        pxPath->xWaitHistogram[ prvLatencyBucket( uxWait ) ]++;
+
+        eLockHeldPath = ePath;
+        uxLockAcquiredAt = configHEAP_READ_CYCLES();
+    }
+
+    static void prvHeapUnlock( void )
+    {
+        HeapLockPathStats_t * pxPath = &xLockStats.xPaths[ eLockHeldPath ];
+        uint64_t uxHold = configHEAP_READ_CYCLES() - uxLockAcquiredAt;
+
+        pxPath->uxHoldCycles += uxHold;
+        pxPath->xHoldHistogram[ prvLatencyBucket( uxHold ) ]++;
+
+        ( void ) pthread_mutex_unlock( &xHeapMutex );
+    }
+#endif
+
+
+/**
+ * @brief 从 pxIterator 开始向后寻找位置，将一个空闲块插入空闲链表。
+ * 链表按内存地址从小到大排序，插入后会自动检查并合并前后相邻的空闲空间。
+ * pxIterator 必须是链表中地址低于 pxBlockToInsert 的节点（最保守的是 &xStart）。
+ * @return BlockLink_t* 合并后包含该块的空闲块，可作为下一次更高地址插入的起点
+ */
+static BlockLink_t * prvInsertBlockIntoFreeListFrom( BlockLink_t * pxIterator, BlockLink_t * pxBlockToInsert )
+{
+    uint8_t * puc;
+
+    /* 寻找插入位置 */
+    for( ; pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock )
+    {
+        heapNODE_VISITED();
+    }
+
+    /* 检查是否能与前面的块合并 */
+    puc = ( uint8_t * ) pxIterator;
+    if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
+    {
+        heapFREE_BLOCK_REMOVED( pxIterator->xBlockSize );
+        pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+        pxBlockToInsert = pxIterator;
+    }
+
+    /* 检查是否能与后面的块合并 */
+    puc = ( uint8_t * ) pxBlockToInsert;
+    if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
+    {
+        if( pxIterator->pxNextFreeBlock != pxEnd )
+        {
+            heapINDEX_REMOVE( pxIterator->pxNextFreeBlock );
+            heapFREE_BLOCK_REMOVED( pxIterator->pxNextFreeBlock->xBlockSize );
+            pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
+            pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
+        }
+        else
+        {
+            pxBlockToInsert->pxNextFreeBlock = pxEnd;
+        }
+    }
+    else
+    {
+        pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+    }
+
+    if( pxIterator != pxBlockToInsert )
+    {
+        pxIterator->pxNextFreeBlock = pxBlockToInsert;
+        heapINDEX_INSERT( pxBlockToInsert );
+    }
+    else
+    {
+        heapINDEX_RESIZE( pxBlockToInsert );
+    }
+
+    heapFREE_BLOCK_ADDED( pxBlockToInsert->xBlockSize );
+    heapFREE_LIST_CHANGED( pxBlockToInsert );
+
+    return pxBlockToInsert;
+}
+
+/**
+ * @brief 返回空闲链表中地址低于 pxBlock 的最后一个节点（没有时为 &xStart）。
+ * 启用索引时二分查找，否则从链表头遍历。调用者必须持有 HEAP_LOCK。
+ */
+static BlockLink_t * prvFreeListPredecessor( const BlockLink_t * pxBlock )
+{
+    BlockLink_t * pxIterator = &xStart;
+
+    #if ( configHEAP_FREE_INDEX == 1 )
+    {
+        size_t xIndex;
+
+        if( prvFreeIndexUsable() != 0 )
+        {
+            xIndex = prvFreeIndexLowerBound( pxBlock );
+
+            return ( xIndex > 0U ) ? heapINDEX_BLOCK( xIndex - 1U ) : &xStart;
+        }
+    }
+    #endif
+
+    while( pxIterator->pxNextFreeBlock < pxBlock )
+    {
+        pxIterator = pxIterator->pxNextFreeBlock;
+        heapNODE_VISITED();
+    }
+
+    return pxIterator;
+}
+
+/**
+ * @brief 将一个空闲块插入空闲链表（从链表头开始寻找位置）。
+ */
+static void prvInsertBlockIntoFreeList( BlockLink_t * pxBlockToInsert )
+{
+    ( void ) prvInsertBlockIntoFreeListFrom( prvFreeListPredecessor( pxBlockToInsert ), pxBlockToInsert );
+}
+
+#if ( configHEAP_HOSTED == 1 )
+
+/**
+ * @brief 预留 configHEAP_HOSTED_RESERVE_SIZE 字节的地址空间（不可访问，不占物理内存）。
+ * @param uxBase 要求的起始地址，0 表示由内核选择
+ * @return uint8_t* 预留区间的起始地址；指定地址已被占用或 mmap 失败时返回 NULL
+ */
+static uint8_t * prvHeapReserve( uintptr_t uxBase )
+{
+    int xFlags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    void * pvReserved;
+    size_t xSlack = 0U;
+
+    #ifdef MAP_FIXED_NOREPLACE
+        if( uxBase != 0 )
+        {
+            xFlags |= MAP_FIXED_NOREPLACE;
+        }
+    #endif
+
+    #if ( configHEAP_HOSTED_HUGE_PAGES != 0 )
+    {
+        /* 多预留一个大页，之后裁掉首尾，使堆池起点对齐到大页 */
+        if( uxBase == 0 )
+        {
+            xSlack = configHEAP_HOSTED_HUGE_PAGE_SIZE;
+        }
+    }
+    #endif
+
+    pvReserved = mmap( ( void * ) uxBase, configHEAP_HOSTED_RESERVE_SIZE + xSlack, PROT_NONE, xFlags, -1, 0 );
+
+    /* 不支持 MAP_FIXED_NOREPLACE 的内核会把地址当作提示，需要自己检查 */
+    if( ( pvReserved != MAP_FAILED ) && ( uxBase != 0 ) && ( ( uintptr_t ) pvReserved != uxBase ) )
+    {
+        ( void ) munmap( pvReserved, configHEAP_HOSTED_RESERVE_SIZE );
+        pvReserved = MAP_FAILED;
+    }
+
+    #if ( configHEAP_HOSTED_HUGE_PAGES != 0 )
+    {
+        uintptr_t uxAligned;
+
+        if( ( pvReserved != MAP_FAILED ) && ( xSlack != 0U ) )
+        {
+            uxAligned = ( ( uintptr_t ) pvReserved + xSlack - 1U ) & ~( ( uintptr_t ) xSlack - 1U );
+
+            if( uxAligned != ( uintptr_t ) pvReserved )
+            {
+                ( void ) munmap( pvReserved, uxAligned - ( uintptr_t ) pvReserved );
+            }
+
+            if( ( uxAligned - ( uintptr_t ) pvReserved ) != xSlack )
+            {
+                ( void ) munmap( ( void * ) ( uxAligned + configHEAP_HOSTED_RESERVE_SIZE ), xSlack - ( uxAligned - ( uintptr_t ) pvReserved ) );
+            }
+
+            pvReserved = ( void * ) uxAligned;
+        }
+
+        if( pvReserved != MAP_FAILED )
+        {
+            /* 标记随区间保留，之后 mprotect 拆出的可读写部分同样适用 */
+            ( void ) madvise( pvReserved, configHEAP_HOSTED_RESERVE_SIZE, MADV_HUGEPAGE );
+        }
+    }
+    #endif
+
+    return ( pvReserved != MAP_FAILED ) ? ( uint8_t * ) pvReserved : NULL;
+}
+
+/**
+ * @brief 提交的粒度：普通页大小，hugetlbfs 大页模式下为大页大小。
+ */
+static size_t prvHeapCommitGranule( void )
+{
+    #if ( configHEAP_HOSTED_HUGE_PAGES == 2 )
+        return configHEAP_HOSTED_HUGE_PAGE_SIZE;
+    #else
+        return ( size_t ) sysconf( _SC_PAGESIZE );
+    #endif
+}
+
+/**
+ * @brief 让 [puc, puc + xSize) 中的每一页立即分配物理页。
+ * 逐页做原子的"或 0"：内容不变，即使其他线程正在使用这段内存也不受影响。
+ */
+static void prvHeapTouch( uint8_t * puc, size_t xSize )
+{
+    size_t xPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+    size_t xOffset;
+
+    #ifdef MADV_POPULATE_WRITE
+        /* Linux 5.14 起由内核一次完成，旧内核返回 EINVAL 后逐页写入 */
+        if( madvise( puc, xSize, MADV_POPULATE_WRITE ) == 0 )
+        {
+            return;
+        }
+    #endif
+
+    for( xOffset = 0U; xOffset < xSize; xOffset += xPageSize )
+    {
+        ( void ) __atomic_fetch_or( puc + xOffset, ( uint8_t ) 0, __ATOMIC_RELAXED );
+    }
+}
+
+/**
+ * @brief 把预留区间中的 [puc, puc + xSize) 提交为可读写，并按配置换成大页、锁定或预取。
+ * 调用者必须持有 HEAP_LOCK（初始化之前除外）。
+ * @return int 成功返回 1
+ */
+static int prvHeapCommit( uint8_t * puc, size_t xSize )
+{
+    int xCommitted = 0;
+    int xResident = 0;
+
+    #if ( configHEAP_HOSTED_HUGE_PAGES == 2 ) && defined( MAP_HUGETLB )
+    {
+        /* 不带 MAP_NORESERVE：大页在映射时就预留，不足时在这里失败，而不是之后访问时收到 SIGBUS */
+        if( mmap( puc, xSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0 ) != MAP_FAILED )
+        {
+            xHeapHugePageBytes += xSize;
+            xCommitted = 1;
+        }
+        else
+        {
+            /*
+             * 旧内核在 MAP_FIXED 映射失败时可能已拆掉原预留，重新占住这段地址。
+             * 新映射不带预留区间上的 MADV_HUGEPAGE 标记，需要重新设置，退回普通页时才能按 1 处理。
+             */
+            if( mmap( puc, xSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0 ) != MAP_FAILED )
+            {
+                ( void ) madvise( puc, xSize, MADV_HUGEPAGE );
+            }
+        }
+    }
+    #endif
+
+    if( xCommitted == 0 )
+    {
+        xCommitted = ( mprotect( puc, xSize, PROT_READ | PROT_WRITE ) == 0 );
+    }
+
+    #if ( configHEAP_HOSTED_MLOCK == 1 )
+    {
+        /* mlock 会把整段页面调入内存，成功后不需要再预取 */
+        if( xCommitted != 0 )
+        {
+            if( mlock( puc, xSize ) == 0 )
+            {
+                xHeapLockedBytes += xSize;
+                xResident = 1;
+            }
+            else
+            {
+                xHeapLockFailures++;
+            }
+        }
+    }
+    #endif
+
+    #if ( configHEAP_HOSTED_PREFAULT == 1 ) || ( configHEAP_HOSTED_MLOCK == 1 )
+    {
+        if( ( xCommitted != 0 ) && ( xResident == 0 ) && ( xHeapPrefaultDeferred == 0 ) )
+        {
+            prvHeapTouch( puc, xSize );
+        }
+    }
+    #endif
+
+    ( void ) xResident;
+
+    return xCommitted;
+}
+
+#endif /* configHEAP_HOSTED */
+
+/**
+ * @brief 初始化堆池。
+ * 整理 ucHeap 数组，设置链表头尾指针。
+ */
+static void prvHeapInit( void )
+{
+    BlockLink_t * pxFirstFreeBlock;
+    uintptr_t uxStartAddress, uxEndAddress;
+    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+    #if ( configHEAP_HOSTED == 1 )
+    {
+        size_t xGranule = prvHeapCommitGranule();
+
+        /* 只预留地址空间，提交部分按页（或大页）对齐后改为可读写 */
+        xTotalHeapSize = ( xTotalHeapSize + xGranule - 1 ) & ~( xGranule - 1 );
+        ucHeap = prvHeapReserve( ( uintptr_t ) configHEAP_HOSTED_BASE_ADDRESS );
+        configASSERT( ucHeap != NULL );
+        configASSERT( prvHeapCommit( ucHeap, xTotalHeapSize ) != 0 );
+
+        xHeapCommittedSize = xTotalHeapSize;
+    }
+    #endif
+
+    uxStartAddress = ( uintptr_t ) ucHeap;
+
+    /* 确保堆池起始地址对齐 */
+    if( ( uxStartAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    {
+        uxStartAddress += ( portBYTE_ALIGNMENT - 1 );
+        uxStartAddress &= ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK );
+        xTotalHeapSize -= ( size_t ) ( uxStartAddress - ( uintptr_t ) ucHeap );
+    }
+
+    xStart.pxNextFreeBlock = ( void * ) uxStartAddress;
+    xStart.xBlockSize = ( size_t ) 0;
+
+    uxEndAddress = uxStartAddress + ( uintptr_t ) xTotalHeapSize;
+    uxEndAddress -= ( uintptr_t ) xHeapStructSize;
+    uxEndAddress &= ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK );
+    pxEnd = ( BlockLink_t * ) uxEndAddress;
+    pxEnd->xBlockSize = 0;
+    pxEnd->pxNextFreeBlock = NULL;
+
+    pxFirstFreeBlock = ( BlockLink_t * ) uxStartAddress;
+    pxFirstFreeBlock->xBlockSize = ( size_t ) ( uxEndAddress - uxStartAddress );
+    pxFirstFreeBlock->pxNextFreeBlock = pxEnd;
+
+    xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+
+    heapFREE_BLOCK_ADDED( pxFirstFreeBlock->xBlockSize );
+
+    #if ( configHEAP_FREE_INDEX == 1 )
+    {
+        ( void ) prvFreeIndexRebuild();
+    }
+    #endif
+}
+
+/**
+ * @brief 把用户请求的字节数换算成块大小：加上 Header 的开销并进行对齐。
+ * @return size_t 块大小；若 xWantedSize 为 0 或换算时溢出则返回 0
+ */
+static size_t prvBlockSizeFor( size_t xWantedSize )
+{
+    size_t xBlockSize = 0;
+
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= ( ( size_t ) -1 ) - xHeapStructSize - portBYTE_ALIGNMENT_MASK ) )
+    {
+        xBlockSize = ( xWantedSize + xHeapStructSize + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+    }
+
+    return xBlockSize;
+}
+
+#if ( configHEAP_HOSTED == 1 )
+
+/**
+ * @brief 向高地址扩展堆池：提交新的页，并把原来的 pxEnd 所在位置变成一个新的空闲块。
+ * 调用者必须持有 HEAP_LOCK。
+ * @return int 扩展成功返回 1，预留空间用尽或 mprotect 失败返回 0
+ */
+static int prvHeapGrow( size_t xWantedSize )
+{
+    BlockLink_t * pxIterator, * pxNewBlock, * pxOldEnd = pxEnd;
+    size_t xGrowSize;
+    int xReturn = 0;
+
+    xGrowSize = ( xWantedSize + xHeapStructSize + configHEAP_HOSTED_GROW_SIZE - 1 ) / configHEAP_HOSTED_GROW_SIZE;
+    xGrowSize *= configHEAP_HOSTED_GROW_SIZE;
+    xGrowSize = ( xGrowSize + prvHeapCommitGranule() - 1 ) & ~( prvHeapCommitGranule() - 1 );
+
+    if( ( xGrowSize > xWantedSize ) &&
+        ( xGrowSize <= ( configHEAP_HOSTED_RESERVE_SIZE - xHeapCommittedSize ) ) &&
+        ( prvHeapCommit( ucHeap + xHeapCommittedSize, xGrowSize ) != 0 ) )
+    {
+        xHeapCommittedSize += xGrowSize;
+
+        /* 移动结束标记之前先找到指向它的节点，此时空闲链表仍然完整 */
+        pxIterator = prvFreeListPredecessor( pxOldEnd );
+
+        /* 新的结束标记整体上移 xGrowSize，旧标记及其后的空间成为新的空闲块 */
+        pxEnd = ( BlockLink_t * ) ( ( ( uint8_t * ) pxOldEnd ) + xGrowSize );
+        pxEnd->xBlockSize = 0;
+        pxEnd->pxNextFreeBlock = NULL;
+
+        pxIterator->pxNextFreeBlock = pxEnd;
+
+        pxNewBlock = pxOldEnd;
+        pxNewBlock->xBlockSize = xGrowSize;
+        xFreeBytesRemaining += xGrowSize;
+        ( void ) prvInsertBlockIntoFreeListFrom( pxIterator, pxNewBlock );
+
+        xReturn = 1;
+    }
+
+    return xReturn;
+}
+
+#endif /* configHEAP_HOSTED */
+
+#if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+
+static size_t xLargeMappedBytes = 0U;      /* 当前所有大对象映射的总字节数 */
+static size_t xLargePeakMappedBytes = 0U;  /* xLargeMappedBytes 的历史最大值 */
+static size_t xLargeAllocations = 0U;      /* 成功映射的大对象个数 */
+static size_t xLargeFrees = 0U;            /* 已解除映射的大对象个数 */
+static size_t xLargeRemaps = 0U;           /* pvPortRealloc 用 mremap 调整大小的次数 */
+
+/**
+ * @brief pv 是否是大对象（块头带 heapBLOCK_LARGE_BITMASK）。pv 必须为 NULL 或来自本堆。
+ */
+static inline int prvLargeOwns( const void * pv )
+{
+    return ( pv != NULL ) &&
+           ( ( ( ( const BlockLink_t * ) ( ( ( const uint8_t * ) pv ) - xHeapStructSize ) )->xBlockSize & heapBLOCK_LARGE_BITMASK ) != 0 );
+}
+
+/**
+ * @brief 块大小向上取整到页大小，即大对象的映射长度。溢出或超出块大小上限时返回 0。
+ */
+static size_t prvLargeMapSize( size_t xBlockSize )
+{
+    size_t xPageMask = ( size_t ) sysconf( _SC_PAGESIZE ) - 1U;
+
+    if( xBlockSize > ( heapBLOCK_SIZE_LIMIT & ~xPageMask ) )
+    {
+        return 0U;
+    }
+
+    return ( xBlockSize + xPageMask ) & ~xPageMask;
+}
+
+/**
+ * @brief 为块大小为 xBlockSize 的分配单独建立一个映射。不持有 HEAP_LOCK 调用。
+ * @param pxUsePool 映射失败时置 1，由调用者退回堆池；成功或被所有者配额拒绝时置 0
+ * @return void* 用户区指针；失败返回 NULL
+ */
+static void * prvLargeAllocate( size_t xBlockSize, size_t uxOwner, int * pxUsePool )
+{
+    size_t xMapSize = prvLargeMapSize( xBlockSize );
+    BlockLink_t * pxLink = MAP_FAILED;
+    void * pvReturn = NULL;
+
+    if( xMapSize != 0U )
+    {
+        pxLink = ( BlockLink_t * ) mmap( NULL, xMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    }
+
+    *pxUsePool = ( pxLink == MAP_FAILED );
+
+    if( pxLink != MAP_FAILED )
+    {
+        pxLink->xBlockSize = xMapSize | heapBLOCK_ALLOCATED_BITMASK | heapBLOCK_LARGE_BITMASK;
+        pxLink->pxNextFreeBlock = NULL;
+        pvReturn = ( void * ) ( ( ( uint8_t * ) pxLink ) + xHeapStructSize );
+
+        HEAP_LOCK_FOR( eHeapLockPathMalloc );
+        {
+            if( heapOWNER_ADMIT( uxOwner, xMapSize ) )
+            {
+                heapOWNER_CHARGE( pvReturn, uxOwner );
+
+                xLargeMappedBytes += xMapSize;
+                xLargeAllocations++;
+
+                if( xLargeMappedBytes > xLargePeakMappedBytes )
+                {
+                    xLargePeakMappedBytes = xLargeMappedBytes;
+                }
+            }
+            else
+            {
+                pvReturn = NULL;
+            }
+        }
+        HEAP_UNLOCK();
+
+        if( pvReturn == NULL )
+        {
+            ( void ) munmap( pxLink, xMapSize );
+        }
+    }
+
+    return pvReturn;
+}
+
+/**
+ * @brief 解除大对象的映射。内核回收的页面再次映射时是零页，不需要按清零策略处理。
+ */
+static void prvLargeFree( void * pv )
+{
+    BlockLink_t * pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+    size_t xMapSize = heapBLOCK_SIZE( pxLink );
+
+    configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+    heapPROFILE_FREE( pxLink );
+
+    HEAP_LOCK_FOR( eHeapLockPathFree );
+    {
+        heapOWNER_RELEASE( pxLink );
+        xLargeMappedBytes -= xMapSize;
+        xLargeFrees++;
+    }
+    HEAP_UNLOCK();
+
+    ( void ) munmap( pxLink, xMapSize );
+}
+
+/**
+ * @brief 调整大对象的大小：新大小仍不小于阈值时用 mremap 调整映射（内核移动页表而不复制数据），
+ * 否则移回堆池。失败时原对象保持不变。
+ */
+static void * prvLargeRealloc( void * pv, size_t xWantedSize )
+{
+    BlockLink_t * pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+    size_t xOldSize = heapBLOCK_SIZE( pxLink );
+    size_t xNewBlockSize = prvBlockSizeFor( xWantedSize );
+    size_t xNewSize = prvLargeMapSize( xNewBlockSize );
+    void * pvReturn = NULL;
+
+    if( ( xNewBlockSize == 0U ) || ( xNewSize == 0U ) )
+    {
+        return NULL;
+    }
+
+    if( xNewSize == xOldSize )
+    {
+        return pv;
+    }
+
+    #if defined( MREMAP_MAYMOVE )
+    if( xNewBlockSize >= configHEAP_LARGE_OBJECT_THRESHOLD )
+    {
+        BlockLink_t * pxNewLink = NULL;
+        int xAdmitted;
+
+        /* 先按新大小记账，保证并发的分配看不到超出硬上限的空间 */
+        HEAP_LOCK_FOR( eHeapLockPathMalloc );
+        {
+            xAdmitted = ( xNewSize < xOldSize ) || heapOWNER_ADMIT_GROWTH( pxLink, xNewSize - xOldSize );
+
+            if( xAdmitted != 0 )
+            {
+                heapOWNER_RESIZE( pxLink, xOldSize, xNewSize );
+            }
+        }
+        HEAP_UNLOCK();
+
+        if( xAdmitted != 0 )
+        {
+            pxNewLink = ( BlockLink_t * ) mremap( pxLink, xOldSize, xNewSize, MREMAP_MAYMOVE );
+
+            HEAP_LOCK_FOR( eHeapLockPathMalloc );
+            {
+                if( pxNewLink != MAP_FAILED )
+                {
+                    pxNewLink->xBlockSize = xNewSize | ( pxNewLink->xBlockSize & heapBLOCK_FLAGS_MASK );
+                    xLargeMappedBytes = xLargeMappedBytes - xOldSize + xNewSize;
+                    xLargeRemaps++;
+
+                    if( xLargeMappedBytes > xLargePeakMappedBytes )
+                    {
+                        xLargePeakMappedBytes = xLargeMappedBytes;
+                    }
+
+                    pvReturn = ( void * ) ( ( ( uint8_t * ) pxNewLink ) + xHeapStructSize );
+                }
+                else
+                {
+                    heapOWNER_RESIZE( pxLink, xNewSize, xOldSize );
+                }
+            }
+            HEAP_UNLOCK();
+        }
+
+        /* 剖析器按地址记录采样：把记录改到新地址与新大小下（旧映射已不可访问，标记从新块头读取） */
+        #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        {
+            if( ( pvReturn != NULL ) && ( ( pxNewLink->xBlockSize & heapBLOCK_SAMPLED_BITMASK ) != 0 ) )
+            {
+                prvProfileMove( pv, pvReturn, xWantedSize );
+            }
+        }
+        #endif
+    }
+    else
+    #endif /* MREMAP_MAYMOVE */
+    {
+        /* 缩小到阈值以下（或系统不支持 mremap）：复制到新分配的位置 */
+        pvReturn = pvPortMalloc( xWantedSize );
+
+        if( pvReturn != NULL )
+        {
+            memcpy( pvReturn, pv, ( ( xOldSize - xHeapStructSize ) < xWantedSize ) ? ( xOldSize - xHeapStructSize ) : xWantedSize );
+            vPortFree( pv );
+        }
+    }
+
+    return pvReturn;
+}
+
+    #define heapLARGE_OWNS( pv )                    prvLargeOwns( pv )
+#else
+    #define heapLARGE_OWNS( pv )                    ( 0 )
+#endif /* configHEAP_LARGE_OBJECT_THRESHOLD */
+
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+
+/**
+ * @brief 把刚释放的块挂入待清零队列。块保持已分配状态，不会被分配、合并或整理。
+ */
+static void prvDeferClear( BlockLink_t * pxLink )
+{
+    HEAP_LOCK_FOR( eHeapLockPathFree );
+    {
+        configASSERT( ( pxLink->xBlockSize & heapBLOCK_PENDING_CLEAR_BITMASK ) == 0 );
+
+        heapOWNER_RELEASE( pxLink );
+
+        /* 其余状态位已无意义，只保留已分配位 */
+        pxLink->xBlockSize = heapBLOCK_SIZE( pxLink ) | heapBLOCK_ALLOCATED_BITMASK | heapBLOCK_PENDING_CLEAR_BITMASK;
+        pxLink->pxNextFreeBlock = pxPendingClear;
+        pxPendingClear = pxLink;
+        xPendingClearBytes += heapBLOCK_SIZE( pxLink );
+        xNumberOfSuccessfulFrees++;
+    }
+    HEAP_UNLOCK();
+}
+
+/**
+ * @brief 同步清零整个待清零队列并把块并入空闲链表，分配找不到空闲块时调用。
+ * 调用者必须持有 HEAP_LOCK。
+ * @return int 队列非空返回 1
+ */
+static int prvDrainPendingClear( void )
+{
+    BlockLink_t * pxLink;
+    int xDrained = ( pxPendingClear != NULL ) ? 1 : 0;
+
+    while( pxPendingClear != NULL )
+    {
+        pxLink = pxPendingClear;
+        pxPendingClear = pxLink->pxNextFreeBlock;
+        heapFREE_BLOCK( pxLink );
+        prvClearMemory( ( ( uint8_t * ) pxLink ) + xHeapStructSize, pxLink->xBlockSize - xHeapStructSize );
+        xFreeBytesRemaining += pxLink->xBlockSize;
+        prvInsertBlockIntoFreeList( pxLink );
+    }
+
+    xPendingClearBytes = 0U;
+
+    return xDrained;
+}
+
+#endif /* configHEAP_CLEAR_MEMORY_ON_FREE == 4 */
+
+/**
+ * @brief 在空闲链表中按首次适配查找足够大的块（宿主机模式下找不到时会先扩展堆池）。
+ * 调用者必须持有 HEAP_LOCK。
+ * @param ppxPreviousBlock 输出：找到的块在链表中的前驱
+ * @return BlockLink_t* 找到的空闲块；找不到时返回 pxEnd
+ */
+static BlockLink_t * prvFindFirstFit( size_t xWantedSize, BlockLink_t ** ppxPreviousBlock )
+{
+    BlockLink_t * pxBlock = pxEnd, * pxPreviousBlock = &xStart;
+
+    #if ( configHEAP_FREE_INDEX == 1 )
+        size_t xIndex;
+        uint32_t ulWanted = prvFreeIndexUnits( xWantedSize );
+    #endif
+
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+    {
+        #if ( configHEAP_FREE_INDEX == 1 )
+        if( ( ulWanted < UINT32_MAX ) && ( prvFreeIndexUsable() != 0 ) )
+        {
+            /* 顺序扫描紧凑的大小数组，只在选中后访问块头 */
+            xIndex = pxFreeIndexScan( ulWanted );
+            heapSEARCH_STEPS( xIndex );
+
+            if( xIndex < xFreeIndexCount )
+            {
+                pxBlock = heapINDEX_BLOCK( xIndex );
+                pxPreviousBlock = ( xIndex > 0U ) ? heapINDEX_BLOCK( xIndex - 1U ) : &xStart;
+            }
+        }
+        else
+        #endif
+        {
+            pxBlock = xStart.pxNextFreeBlock;
+
+            /* 寻找第一个足够大的空闲块（First Fit） */
+            while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
+            {
+                pxPreviousBlock = pxBlock;
+                pxBlock = pxBlock->pxNextFreeBlock;
+                heapSEARCH_STEP();
+                heapNODE_VISITED();
+            }
+        }
+
+        heapSEARCH_DONE();
+    }
+
+    #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+    {
+        /* 待清零的块先兑现，再考虑扩展堆池 */
+        if( ( pxBlock == pxEnd ) && ( xWantedSize > 0 ) && ( prvDrainPendingClear() != 0 ) )
+        {
+            return prvFindFirstFit( xWantedSize, ppxPreviousBlock );
+        }
+    }
+    #endif
+
+    #if ( configHEAP_HOSTED == 1 )
+    {
+        /* 扩展出的新块本身就足够大，重新查找一定能找到 */
+        if( ( pxBlock == pxEnd ) && ( xWantedSize > 0 ) && ( prvHeapGrow( xWantedSize ) != 0 ) )
+        {
+            pxBlock = prvFindFirstFit( xWantedSize, &pxPreviousBlock );
+        }
+    }
+    #endif
+
+    *ppxPreviousBlock = pxPreviousBlock;
+
+    return pxBlock;
+}
+
+/**
+ * @brief 把 prvFindFirstFit 找到的空闲块从链表摘下，按需分裂，并标记为已分配。
+ * 调用者必须持有 HEAP_LOCK。
+ * @return void* 用户区指针
+ */
+static void * prvCarveBlock( BlockLink_t * pxPreviousBlock, BlockLink_t * pxBlock, size_t xWantedSize )
+{
+    BlockLink_t * pxNewBlockLink;
+    void * pvReturn;
+
+    pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+    pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+    heapINDEX_REMOVE( pxBlock );
+    heapFREE_BLOCK_REMOVED( pxBlock->xBlockSize );
+    heapFREE_LIST_CHANGED( pxBlock );
+
+    /* 如果剩余空间足够大，则分裂该块 */
+    if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+    {
+        pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+        pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+        pxBlock->xBlockSize = xWantedSize;
+        ( void ) prvInsertBlockIntoFreeListFrom( pxPreviousBlock, pxNewBlockLink );
+    }
+
+    xFreeBytesRemaining -= pxBlock->xBlockSize;
+    if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+    {
+        xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+    }
+
+    heapALLOCATE_BLOCK( pxBlock ); /* 标记为已分配 */
+    pxBlock->pxNextFreeBlock = NULL;
+    xNumberOfSuccessfulAllocations++;
+
+    return pvReturn;
+}
+
+/**
+ * @brief 在空闲链表中按首次适配找到一个块并将其标记为已分配。
+ * 调用者必须持有 HEAP_LOCK，且 xWantedSize 已由 prvBlockSizeFor 换算。
+ * @return void* 用户区指针；没有足够大的空闲块时返回 NULL
+ */
+static void * prvAllocateBlock( size_t xWantedSize )
+{
+    BlockLink_t * pxBlock, * pxPreviousBlock;
+    void * pvReturn = NULL;
+
+    pxBlock = prvFindFirstFit( xWantedSize, &pxPreviousBlock );
+
+    if( pxBlock != pxEnd )
+    {
+        pvReturn = prvCarveBlock( pxPreviousBlock, pxBlock, xWantedSize );
+    }
+
+    return pvReturn;
+}
+
+/* --- 公共接口实现 --- */
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    void * pvReturn;
+    size_t uxOwner = heapCURRENT_OWNER();
+    heapRECLAIM_DECLARE();
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+    {
+        /* 被抽中的分配由守护池提供；池满时仍走普通路径 */
+        pvReturn = prvGuardedSample( xWantedSize, portBYTE_ALIGNMENT );
+
+        if( pvReturn != NULL )
+        {
+            return pvReturn;
+        }
+    }
+    #endif
+
+    #if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+        uint64_t uxStartCycles = configHEAP_READ_CYCLES();
+        xNodesVisited = 0;
+    #endif
+
+    #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        HeapProfileSample_t xSample;
+        prvProfileBeforeAlloc( &xSample, xWantedSize );
+    #endif
+
+    xWantedSize = prvBlockSizeFor( xWantedSize );
+
+    #if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+        int xUsePool = 1;
+
+        /* 大对象单独映射，不进入空闲链表；映射失败时仍走堆池 */
+        pvReturn = ( xWantedSize >= configHEAP_LARGE_OBJECT_THRESHOLD ) ? prvLargeAllocate( xWantedSize, uxOwner, &xUsePool ) : NULL;
+
+        #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        {
+            if( ( pvReturn != NULL ) && ( xSample.xDepth != 0 ) )
+            {
+                ( ( BlockLink_t * ) ( ( ( uint8_t * ) pvReturn ) - xHeapStructSize ) )->xBlockSize |= heapBLOCK_SAMPLED_BITMASK;
+            }
+        }
+        #endif
+
+        if( xUsePool != 0 )
+    #endif
+    {
+        /* 分配失败时先调用回收回调，再重试一次 */
+        do
+        {
+            HEAP_LOCK_FOR( eHeapLockPathMalloc );
+            {
+                if( pxEnd == NULL ) { prvHeapInit(); }
+
+                pvReturn = heapOWNER_ADMIT( uxOwner, xWantedSize ) ? prvAllocateBlock( xWantedSize ) : NULL;
+
+                if( pvReturn != NULL )
+                {
+                    heapOWNER_CHARGE( pvReturn, uxOwner );
+                }
+
+                #if ( configHEAP_SAMPLING_PROFILER == 1 )
+                {
+                    if( ( pvReturn != NULL ) && ( xSample.xDepth != 0 ) )
+                    {
+                        ( ( BlockLink_t * ) ( ( ( uint8_t * ) pvReturn ) - xHeapStructSize ) )->xBlockSize |= heapBLOCK_SAMPLED_BITMASK;
+                    }
+                }
+                #endif
+
+                heapRECLAIM_NOTE_FREE();
+            }
+            HEAP_UNLOCK();
+        } while( heapRECLAIM_RETRY( pvReturn, xWantedSize ) );
+
+        heapRECLAIM_AFTER_ALLOCATE( pvReturn );
+    }
+
+    #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 3 )
+    {
+        /* 大对象的映射本来就是零页 */
+        if( ( pvReturn != NULL ) && ( heapLARGE_OWNS( pvReturn ) == 0 ) )
+        {
+            heapCLEAR_ON_ALLOCATE( pvReturn );
+        }
+    }
+    #endif
+
+    #if ( configHEAP_SAMPLING_PROFILER == 1 )
+    {
+        if( ( pvReturn != NULL ) && ( xSample.xDepth != 0 ) )
+        {
+            prvProfileRecord( &xSample, pvReturn );
+        }
+    }
+    #endif
+
+    #if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+    {
+        prvLatencyRecord( 0, configHEAP_READ_CYCLES() - uxStartCycles );
+    }
+    #endif
+
+    return pvReturn;
+}
+
+void vPortFree( void * pv )
+{
+    uint8_t * puc = ( uint8_t * ) pv;
+    BlockLink_t * pxLink;
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+    {
+        if( prvGuardedOwns( pv ) )
+        {
+            prvGuardedFree( pv );
+            pv = NULL;
+        }
+    }
+    #endif
+
+    #if ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 )
+    {
+        if( prvReserveOwns( pv ) )
+        {
+            prvReserveFree( pv );
+            pv = NULL;
+        }
+    }
+    #endif
+
+    #if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+    {
+        if( prvLargeOwns( pv ) )
+        {
+            prvLargeFree( pv );
+            pv = NULL;
+        }
+    }
+    #endif
+
+    #if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+        uint64_t uxStartCycles = configHEAP_READ_CYCLES();
+        xNodesVisited = 0;
+    #endif
+
+    if( pv != NULL )
+    {
+        puc -= xHeapStructSize;
+        pxLink = ( void * ) puc;
+
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+        configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+        if( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 )
+        {
+            heapPROFILE_FREE( pxLink );
+
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+            {
+                prvDeferClear( pxLink );
+            }
+            #else
+            {
+                heapCLEAR_ON_FREE( pv, heapBLOCK_SIZE( pxLink ) - xHeapStructSize );
+
+                /* 块头状态只在持锁时改变，完整性检查与原地扩大读取相邻块头时不会看到中间状态 */
+                HEAP_LOCK_FOR( eHeapLockPathFree );
+                {
+                    heapOWNER_RELEASE( pxLink );
+                    heapFREE_BLOCK( pxLink );
+                    xFreeBytesRemaining += pxLink->xBlockSize;
+                    prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
+                    xNumberOfSuccessfulFrees++;
+                }
+                HEAP_UNLOCK();
+            }
+            #endif
+        }
+
+        #if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+        {
+            prvLatencyRecord( 1, configHEAP_READ_CYCLES() - uxStartCycles );
+        }
+        #endif
+    }
+}
+
+void * pvPortCalloc( size_t xNum, size_t xSize )
+{
+    void * pv = NULL;
+
+    if( ( xSize == 0 ) || ( xNum <= ( ( ( size_t ) -1 ) / xSize ) ) )
+    {
+        pv = pvPortMalloc( xNum * xSize );
+
+        #if ( configHEAP_CLEAR_MEMORY_ON_FREE != 3 )
+        {
+            /* 策略 3 下 pvPortMalloc 已清零（守护池的页面本来就是零页）；大对象的映射同样是零页 */
+            if( ( pv != NULL ) && ( heapLARGE_OWNS( pv ) == 0 ) )
+            {
+                memset( pv, 0, xNum * xSize );
+            }
+        }
+        #endif
+    }
+
+    return pv;
+}
+
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+
+size_t xPortHeapClearPending( size_t xMaxBytes )
+{
+    BlockLink_t * pxLink;
+    size_t xCleared = 0U, xRemaining;
+
+    for( ; ; )
+    {
+        HEAP_LOCK();
+        {
+            pxLink = ( xCleared < xMaxBytes ) ? pxPendingClear : NULL;
+
+            if( pxLink != NULL )
+            {
+                pxPendingClear = pxLink->pxNextFreeBlock;
+                pxLink->pxNextFreeBlock = NULL;
+            }
+
+            xRemaining = xPendingClearBytes;
+        }
+        HEAP_UNLOCK();
+
+        if( pxLink == NULL )
+        {
+            break;
+        }
+
+        /* 块已离开队列但仍是已分配状态，别人碰不到，清零不必持锁 */
+        prvClearMemory( ( ( uint8_t * ) pxLink ) + xHeapStructSize, heapBLOCK_SIZE( pxLink ) - xHeapStructSize );
+        xCleared += heapBLOCK_SIZE( pxLink );
+
+        HEAP_LOCK();
+        {
+            xPendingClearBytes -= heapBLOCK_SIZE( pxLink );
+            heapFREE_BLOCK( pxLink );
+            xFreeBytesRemaining += pxLink->xBlockSize;
+            prvInsertBlockIntoFreeList( pxLink );
+        }
+        HEAP_UNLOCK();
+    }
+
+    return xRemaining;
+}
+
+#endif /* configHEAP_CLEAR_MEMORY_ON_FREE == 4 */
+
+/**
+ * @brief 首次适配查找一个能放下对齐后用户区的空闲块。
+ * 用户区对齐后，块前面空出的部分要么为 0，要么大到足以成为独立的空闲块。
+ * 调用者必须持有 HEAP_LOCK。
+ * @param pxLeadSize 输出：找到的块前面需要留作空闲块的字节数
+ * @return BlockLink_t* 找到的空闲块；找不到时返回 pxEnd
+ */
+static BlockLink_t * prvFindAlignedFit( size_t xWantedSize, size_t xAlignment, BlockLink_t ** ppxPreviousBlock, size_t * pxLeadSize )
+{
+    BlockLink_t * pxBlock, * pxPreviousBlock = &xStart;
+    uintptr_t uxUser;
+    size_t xLeadSize = 0;
+
+    for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+    {
+        uxUser = ( ( uintptr_t ) pxBlock + xHeapStructSize + xAlignment - 1 ) & ~( ( uintptr_t ) xAlignment - 1 );
+        xLeadSize = ( size_t ) ( uxUser - xHeapStructSize - ( uintptr_t ) pxBlock );
+
+        if( ( xLeadSize != 0 ) && ( xLeadSize <= heapMINIMUM_BLOCK_SIZE ) )
+        {
+            uxUser = ( ( uintptr_t ) pxBlock + xHeapStructSize + heapMINIMUM_BLOCK_SIZE + xAlignment ) & ~( ( uintptr_t ) xAlignment - 1 );
+            xLeadSize = ( size_t ) ( uxUser - xHeapStructSize - ( uintptr_t ) pxBlock );
+        }
+
+        if( ( pxBlock->xBlockSize > xLeadSize ) && ( ( pxBlock->xBlockSize - xLeadSize ) >= xWantedSize ) )
+        {
+            break;
+        }
+
+        pxPreviousBlock = pxBlock;
+        heapSEARCH_STEP();
+    }
+
+    heapSEARCH_DONE();
+
+    *ppxPreviousBlock = pxPreviousBlock;
+    *pxLeadSize = xLeadSize;
+
+    return pxBlock;
+}
+
+void * pvPortMallocAligned( size_t xWantedSize, size_t xAlignment )
+{
+    BlockLink_t * pxBlock, * pxPreviousBlock, * pxAlignedBlock;
+    size_t xLeadSize;
+    size_t uxOwner = heapCURRENT_OWNER();
+    void * pvReturn = NULL;
+    heapRECLAIM_DECLARE();
+
+    #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        HeapProfileSample_t xSample;
+        xSample.xDepth = 0;
+
+        /* 小对齐要求转给 pvPortMalloc，由它负责采样 */
+        if( xAlignment > portBYTE_ALIGNMENT )
+        {
+            prvProfileBeforeAlloc( &xSample, xWantedSize );
+        }
+    #endif
+
+    configASSERT( ( xAlignment & ( xAlignment - 1 ) ) == 0 );
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+    {
+        if( xAlignment > portBYTE_ALIGNMENT )
+        {
+            pvReturn = prvGuardedSample( xWantedSize, xAlignment );
+        }
+    }
+    #endif
+
+    if( pvReturn != NULL )
+    {
+        /* 已由守护池提供 */
+    }
+    else if( xAlignment <= portBYTE_ALIGNMENT )
+    {
+        pvReturn = pvPortMalloc( xWantedSize );
+    }
+    else if( ( ( xWantedSize = prvBlockSizeFor( xWantedSize ) ) != 0 ) &&
+             ( xWantedSize <= heapBLOCK_SIZE_LIMIT ) && ( xAlignment <= heapBLOCK_SIZE_LIMIT ) )
+    {
+        /* 分配失败时先调用回收回调，再重试一次 */
+        do
+        {
+            HEAP_LOCK_FOR( eHeapLockPathMalloc );
+            {
+                if( pxEnd == NULL ) { prvHeapInit(); }
+
+                if( heapOWNER_ADMIT( uxOwner, xWantedSize ) )
+                {
+                    pxBlock = prvFindAlignedFit( xWantedSize, xAlignment, &pxPreviousBlock, &xLeadSize );
+
+                    #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+                    {
+                        if( ( pxBlock == pxEnd ) && ( prvDrainPendingClear() != 0 ) )
+                        {
+                            pxBlock = prvFindAlignedFit( xWantedSize, xAlignment, &pxPreviousBlock, &xLeadSize );
+                        }
+                    }
+                    #endif
+
+                    #if ( configHEAP_HOSTED == 1 )
+                    {
+                        /* 扩展出的新块要能容纳最坏情况下的前导空闲块与对齐余量 */
+                        if( ( pxBlock == pxEnd ) && ( prvHeapGrow( xWantedSize + xAlignment + heapMINIMUM_BLOCK_SIZE ) != 0 ) )
+                        {
+                            pxBlock = prvFindAlignedFit( xWantedSize, xAlignment, &pxPreviousBlock, &xLeadSize );
+                        }
+                    }
+                    #endif
+
+                    if( pxBlock != pxEnd )
+                    {
+                        /* 前导部分原地留在链表中，对齐后的部分作为它的后继插入，再按普通块切分 */
+                        if( xLeadSize != 0 )
+                        {
+                            pxAlignedBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + xLeadSize );
+                            pxAlignedBlock->xBlockSize = pxBlock->xBlockSize - xLeadSize;
+                            pxAlignedBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+                            heapFREE_BLOCK_REMOVED( pxBlock->xBlockSize );
+                            heapFREE_BLOCK_ADDED( xLeadSize );
+                            heapFREE_BLOCK_ADDED( pxAlignedBlock->xBlockSize );
+                            heapFREE_LIST_CHANGED( pxBlock );
+                            pxBlock->xBlockSize = xLeadSize;
+                            pxBlock->pxNextFreeBlock = pxAlignedBlock;
+                            heapINDEX_RESIZE( pxBlock );
+                            heapINDEX_INSERT( pxAlignedBlock );
+                            pxPreviousBlock = pxBlock;
+                            pxBlock = pxAlignedBlock;
+                        }
+
+                        pvReturn = prvCarveBlock( pxPreviousBlock, pxBlock, xWantedSize );
+                        heapOWNER_CHARGE( pvReturn, uxOwner );
+
+                        #if ( configHEAP_SAMPLING_PROFILER == 1 )
+                        {
+                            if( xSample.xDepth != 0 )
+                            {
+                                pxBlock->xBlockSize |= heapBLOCK_SAMPLED_BITMASK;
+                            }
+                        }
+                        #endif
+                    }
+                }
+
+                heapRECLAIM_NOTE_FREE();
+            }
+            HEAP_UNLOCK();
+        } while( heapRECLAIM_RETRY( pvReturn, xWantedSize ) );
+
+        heapRECLAIM_AFTER_ALLOCATE( pvReturn );
+
+        #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 3 )
+        {
+            if( pvReturn != NULL )
+            {
+                heapCLEAR_ON_ALLOCATE( pvReturn );
+            }
+        }
+        #endif
+
+        #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        {
+            if( ( pvReturn != NULL ) && ( xSample.xDepth != 0 ) )
+            {
+                prvProfileRecord( &xSample, pvReturn );
+            }
+        }
+        #endif
+    }
+
+    return pvReturn;
+}
+
+/**
+ * @brief 查找地址最高的、足够大的空闲块（空闲链表按地址升序，需走完整个链表）。
+ * 调用者必须持有 HEAP_LOCK。
+ * @return BlockLink_t* 找到的空闲块；找不到时返回 pxEnd
+ */
+static BlockLink_t * prvFindLastFit( size_t xWantedSize, BlockLink_t ** ppxPreviousBlock )
+{
+    BlockLink_t * pxBlock, * pxPreviousBlock = &xStart;
+    BlockLink_t * pxFound = pxEnd, * pxFoundPrevious = &xStart;
+
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+    {
+        for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+        {
+            if( pxBlock->xBlockSize >= xWantedSize )
+            {
+                pxFound = pxBlock;
+                pxFoundPrevious = pxPreviousBlock;
+            }
+
+            pxPreviousBlock = pxBlock;
+            heapSEARCH_STEP();
+        }
+
+        heapSEARCH_DONE();
+    }
+
+    *ppxPreviousBlock = pxFoundPrevious;
+
+    return pxFound;
+}
+
+void * pvPortMallocHinted( size_t xWantedSize, HeapLifetimeHint_t eHint )
+{
+    BlockLink_t * pxBlock, * pxPreviousBlock, * pxNewBlockLink;
+    size_t uxOwner = heapCURRENT_OWNER();
+    void * pvReturn = NULL;
+
+    /* 短生命周期的分配就是普通的首次适配，自然落在堆的低端 */
+    if( eHint != eHeapLongLived )
+    {
+        return pvPortMalloc( xWantedSize );
+    }
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+    {
+        pvReturn = prvGuardedSample( xWantedSize, portBYTE_ALIGNMENT );
+
+        if( pvReturn != NULL )
+        {
+            return pvReturn;
+        }
+    }
+    #endif
+
+    #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        HeapProfileSample_t xSample;
+        prvProfileBeforeAlloc( &xSample, xWantedSize );
+    #endif
+
+    xWantedSize = prvBlockSizeFor( xWantedSize );
+
+    HEAP_LOCK_FOR( eHeapLockPathMalloc );
+    {
+        if( pxEnd == NULL ) { prvHeapInit(); }
+
+        if( heapOWNER_ADMIT( uxOwner, xWantedSize ) )
+        {
+            pxBlock = prvFindLastFit( xWantedSize, &pxPreviousBlock );
+
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+            {
+                if( ( pxBlock == pxEnd ) && ( xWantedSize > 0 ) && ( prvDrainPendingClear() != 0 ) )
+                {
+                    pxBlock = prvFindLastFit( xWantedSize, &pxPreviousBlock );
+                }
+            }
+            #endif
+
+            #if ( configHEAP_HOSTED == 1 )
+            {
+                if( ( pxBlock == pxEnd ) && ( xWantedSize > 0 ) && ( prvHeapGrow( xWantedSize ) != 0 ) )
+                {
+                    pxBlock = prvFindLastFit( xWantedSize, &pxPreviousBlock );
+                }
+            }
+            #endif
+
+            if( pxBlock == pxEnd )
+            {
+                /* 没有合适的块 */
+            }
+            else if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+            {
+                /* 从块的高端切下：低端的剩余部分原地留在链表中，不必改动链接 */
+                heapFREE_BLOCK_REMOVED( pxBlock->xBlockSize );
+                pxBlock->xBlockSize -= xWantedSize;
+                heapINDEX_RESIZE( pxBlock );
+                heapFREE_BLOCK_ADDED( pxBlock->xBlockSize );
+                heapFREE_LIST_CHANGED( pxBlock );
+
+                pxNewBlockLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + pxBlock->xBlockSize );
+                pxNewBlockLink->xBlockSize = xWantedSize;
+
+                xFreeBytesRemaining -= xWantedSize;
+                if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                {
+                    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                }
+
+                heapALLOCATE_BLOCK( pxNewBlockLink );
+                pxNewBlockLink->pxNextFreeBlock = NULL;
+                xNumberOfSuccessfulAllocations++;
+
+                pvReturn = ( void * ) ( ( ( uint8_t * ) pxNewBlockLink ) + xHeapStructSize );
+            }
+            else
+            {
+                pvReturn = prvCarveBlock( pxPreviousBlock, pxBlock, xWantedSize );
+            }
+
+            if( pvReturn != NULL )
+            {
+                heapOWNER_CHARGE( pvReturn, uxOwner );
+            }
+        }
+
+        #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        {
+            if( ( pvReturn != NULL ) && ( xSample.xDepth != 0 ) )
+            {
+                ( ( BlockLink_t * ) ( ( ( uint8_t * ) pvReturn ) - xHeapStructSize ) )->xBlockSize |= heapBLOCK_SAMPLED_BITMASK;
+            }
+        }
+        #endif
+    }
+    HEAP_UNLOCK();
+
+    #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 3 )
+    {
+        if( pvReturn != NULL )
+        {
+            heapCLEAR_ON_ALLOCATE( pvReturn );
+        }
+    }
+    #endif
+
+    #if ( configHEAP_SAMPLING_PROFILER == 1 )
+    {
+        if( ( pvReturn != NULL ) && ( xSample.xDepth != 0 ) )
+        {
+            prvProfileRecord( &xSample, pvReturn );
+        }
+    }
+    #endif
+
+    return pvReturn;
+}
+
+void * pvPortRealloc( void * pv, size_t xWantedSize )
+{
+    BlockLink_t * pxLink, * pxNext, * pxIterator, * pxNewBlockLink;
+    size_t xBlockSize, xNewBlockSize, xCopySize;
+    void * pvReturn = NULL;
+
+    if( pv == NULL )
+    {
+        pvReturn = pvPortMalloc( xWantedSize );
+    }
+    else if( xWantedSize == 0 )
+    {
+        vPortFree( pv );
+    }
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+    else if( prvGuardedOwns( pv ) )
+    {
+        /* 守护池中的对象无法原地调整，总是移到新分配的位置 */
+        pvReturn = pvPortMalloc( xWantedSize );
+
+        if( pvReturn != NULL )
+        {
+            xCopySize = prvGuardedSize( pv );
+            memcpy( pvReturn, pv, ( xCopySize < xWantedSize ) ? xCopySize : xWantedSize );
+            vPortFree( pv );
+        }
+    }
+    #endif
+    #if ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 )
+    else if( prvReserveOwns( pv ) )
+    {
+        /* 储备区中的对象仍是关键分配：优先移回主堆，主堆不够时留在储备区 */
+        pvReturn = pvPortMallocCritical( xWantedSize );
+
+        if( pvReturn != NULL )
+        {
+            xCopySize = xPortGetAllocatedSize( pv );
+            memcpy( pvReturn, pv, ( xCopySize < xWantedSize ) ? xCopySize : xWantedSize );
+            vPortFree( pv );
+        }
+    }
+    #endif
+    #if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+    else if( prvLargeOwns( pv ) )
+    {
+        pvReturn = prvLargeRealloc( pv, xWantedSize );
+    }
+    #endif
+    else if( ( xNewBlockSize = prvBlockSizeFor( xWantedSize ) ) != 0 )
+    {
+        pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+        configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+        xBlockSize = heapBLOCK_SIZE( pxLink );
+
+        if( xNewBlockSize <= xBlockSize )
+        {
+            /* 原地缩小：尾部足够大时切下来还给堆 */
+            if( ( xBlockSize - xNewBlockSize ) > heapMINIMUM_BLOCK_SIZE )
+            {
+                pxNewBlockLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pxLink ) + xNewBlockSize );
+
+                heapCLEAR_ON_FREE( ( ( uint8_t * ) pxNewBlockLink ) + xHeapStructSize, xBlockSize - xNewBlockSize - xHeapStructSize );
+
+                HEAP_LOCK_FOR( eHeapLockPathMalloc );
+                {
+                    pxNewBlockLink->xBlockSize = xBlockSize - xNewBlockSize;
+                    heapOWNER_RESIZE( pxLink, xBlockSize, xNewBlockSize );
+                    pxLink->xBlockSize = xNewBlockSize | ( pxLink->xBlockSize & heapBLOCK_FLAGS_MASK );
+                    xFreeBytesRemaining += pxNewBlockLink->xBlockSize;
+                    prvInsertBlockIntoFreeList( pxNewBlockLink );
+                }
+                HEAP_UNLOCK();
+            }
+
+            pvReturn = pv;
+        }
+        else
+        {
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 3 )
+                size_t xOldBlockSize = xBlockSize;
+            #endif
+
+            HEAP_LOCK_FOR( eHeapLockPathMalloc );
+            {
+                /* 原地扩大：紧随其后的物理块空闲且足够大时直接并入 */
+                pxNext = ( BlockLink_t * ) ( ( ( uint8_t * ) pxLink ) + xBlockSize );
+
+                if( ( pxNext != pxEnd ) && ( heapBLOCK_IS_ALLOCATED( pxNext ) == 0 ) &&
+                    ( ( xBlockSize + pxNext->xBlockSize ) >= xNewBlockSize ) &&
+                    heapOWNER_ADMIT_GROWTH( pxLink, xNewBlockSize - xBlockSize ) )
+                {
+                    pxIterator = prvFreeListPredecessor( pxNext );
+
+                    pxIterator->pxNextFreeBlock = pxNext->pxNextFreeBlock;
+                    heapINDEX_REMOVE( pxNext );
+                    heapFREE_BLOCK_REMOVED( pxNext->xBlockSize );
+                    heapFREE_LIST_CHANGED( pxLink );
+                    xFreeBytesRemaining -= pxNext->xBlockSize;
+                    xBlockSize += pxNext->xBlockSize;
+
+                    if( ( xBlockSize - xNewBlockSize ) > heapMINIMUM_BLOCK_SIZE )
+                    {
+                        pxNewBlockLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pxLink ) + xNewBlockSize );
+                        pxNewBlockLink->xBlockSize = xBlockSize - xNewBlockSize;
+                        xBlockSize = xNewBlockSize;
+                        xFreeBytesRemaining += pxNewBlockLink->xBlockSize;
+                        ( void ) prvInsertBlockIntoFreeListFrom( pxIterator, pxNewBlockLink );
+                    }
+
+                    heapOWNER_RESIZE( pxLink, heapBLOCK_SIZE( pxLink ), xBlockSize );
+                    pxLink->xBlockSize = xBlockSize | ( pxLink->xBlockSize & heapBLOCK_FLAGS_MASK );
+
+                    if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                    {
+                        xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                    }
+
+                    pvReturn = pv;
+                }
+            }
+            HEAP_UNLOCK();
+
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 3 )
+            {
+                /* 并入的部分（含原后继块的块头）在分配前没有清零过 */
+                if( pvReturn != NULL )
+                {
+                    memset( ( ( uint8_t * ) pxLink ) + xOldBlockSize, 0, xBlockSize - xOldBlockSize );
+                }
+            }
+            #endif
+        }
+
+        /* 原地调整失败：分配新块、复制、释放旧块 */
+        if( pvReturn == NULL )
+        {
+            pvReturn = pvPortMalloc( xWantedSize );
+
+            if( pvReturn != NULL )
+            {
+                xCopySize = xBlockSize - xHeapStructSize;
+                memcpy( pvReturn, pv, ( xCopySize < xWantedSize ) ? xCopySize : xWantedSize );
+                vPortFree( pv );
+            }
+        }
+    }
+
+    return pvReturn;
+}
+
+size_t xPortGetAllocatedSize( void * pv )
+{
+    BlockLink_t * pxLink;
+    size_t xReturn = 0;
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+    {
+        if( prvGuardedOwns( pv ) )
+        {
+            xReturn = prvGuardedSize( pv );
+            pv = NULL;
+        }
+    }
+    #endif
+
+    if( pv != NULL )
+    {
+        pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+        xReturn = heapBLOCK_SIZE( pxLink ) - xHeapStructSize;
+    }
+
+    return xReturn;
+}
+
+void vPortFreeSized( void * pv, size_t xSize )
+{
+    BlockLink_t * pxLink;
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+    {
+        if( prvGuardedOwns( pv ) )
+        {
+            prvGuardedFree( pv );
+            pv = NULL;
+        }
+    }
+    #endif
+
+    #if ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 )
+    {
+        if( prvReserveOwns( pv ) )
+        {
+            prvReserveFree( pv );
+            pv = NULL;
+        }
+    }
+    #endif
+
+    #if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+    {
+        if( prvLargeOwns( pv ) )
+        {
+            prvLargeFree( pv );
+            pv = NULL;
+        }
+    }
+    #endif
+
+    if( pv != NULL )
+    {
+        pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+        #if ( configHEAP_CHECK_SIZED_FREE == 1 )
+        {
+            /* 块可能因剩余空间过小未被分裂，实际大小最多比换算值多 heapMINIMUM_BLOCK_SIZE */
+            size_t xExpectedSize = prvBlockSizeFor( xSize );
+            size_t xActualSize = heapBLOCK_SIZE( pxLink );
+
+            configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+            configASSERT( pxLink->pxNextFreeBlock == NULL );
+            configASSERT( ( xActualSize >= xExpectedSize ) && ( xActualSize <= ( xExpectedSize + heapMINIMUM_BLOCK_SIZE ) ) );
+        }
+        #else
+        {
+            /* 发布版不读取大小提示，路径与 vPortFree 相同 */
+            ( void ) xSize;
+        }
+        #endif
+
+        heapPROFILE_FREE( pxLink );
+
+        #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+        {
+            prvDeferClear( pxLink );
+        }
+        #else
+        {
+            /* 按块的实际大小清零：调用者可以写到 xPortGetAllocatedSize 为止，realloc 原地缩小也会留下旧数据 */
+            heapCLEAR_ON_FREE( pv, heapBLOCK_SIZE( pxLink ) - xHeapStructSize );
+
+            HEAP_LOCK_FOR( eHeapLockPathFree );
+            {
+                heapOWNER_RELEASE( pxLink );
+                heapFREE_BLOCK( pxLink );
+                xFreeBytesRemaining += pxLink->xBlockSize;
+                prvInsertBlockIntoFreeList( pxLink );
+                xNumberOfSuccessfulFrees++;
+            }
+            HEAP_UNLOCK();
+        }
+        #endif
+    }
+}
+
+/**
+ * @brief qsort 比较函数：按地址从小到大排列指针。
+ */
+static int prvCompareAddress( const void * pvA, const void * pvB )
+{
+    uintptr_t uxA = ( uintptr_t ) *( void * const * ) pvA;
+    uintptr_t uxB = ( uintptr_t ) *( void * const * ) pvB;
+
+    return ( uxA > uxB ) - ( uxA < uxB );
+}
+
+#if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+
+/**
+ * @brief 逐个调用 pvPortMalloc 完成一批大对象分配：大对象各自单独映射，无法整批相邻切分。
+ * 仍保证全部成功或全部失败。
+ */
+static void * prvMallocBatchEach( size_t xWantedSize, size_t xCount, void * pvBlocks[] )
+{
+    size_t xIndex, xAllocated;
+
+    for( xAllocated = 0; xAllocated < xCount; xAllocated++ )
+    {
+        pvBlocks[ xAllocated ] = pvPortMalloc( xWantedSize );
+
+        if( pvBlocks[ xAllocated ] == NULL )
+        {
+            break;
+        }
+    }
+
+    if( xAllocated < xCount )
+    {
+        for( xIndex = 0; xIndex < xCount; xIndex++ )
+        {
+            if( xIndex < xAllocated )
+            {
+                vPortFree( pvBlocks[ xIndex ] );
+            }
+
+            pvBlocks[ xIndex ] = NULL;
+        }
+    }
+
+    return ( xCount > 0 ) ? pvBlocks[ 0 ] : NULL;
+}
+
+#endif /* configHEAP_LARGE_OBJECT_THRESHOLD > 0 */
+
+void * pvPortMallocBatch( size_t xWantedSize, size_t xCount, void * pvBlocks[] )
+{
+    BlockLink_t * pxBlock, * pxPreviousBlock, * pxNewBlockLink;
+    size_t xTotalSize = 0, xCarvedSize;
+    size_t xIndex, xAllocated = 0;
+    size_t uxOwner = heapCURRENT_OWNER();
+    uint8_t * puc;
+    void * pvReturn;
+    heapRECLAIM_DECLARE();
+
+    #if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+    {
+        if( prvBlockSizeFor( xWantedSize ) >= configHEAP_LARGE_OBJECT_THRESHOLD )
+        {
+            return prvMallocBatchEach( xWantedSize, xCount, pvBlocks );
+        }
+    }
+    #endif
+
+    #if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+        uint64_t uxStartCycles = configHEAP_READ_CYCLES();
+        xNodesVisited = 0;
+    #endif
+
+    xWantedSize = prvBlockSizeFor( xWantedSize );
+
+    if( ( xWantedSize > 0 ) && ( xCount > 0 ) && ( xCount <= ( ( size_t ) -1 ) / xWantedSize ) )
+    {
+        xTotalSize = xWantedSize * xCount;
+    }
+
+    /* 整批失败时与单个分配一样先调用回收回调，再重试一次 */
+    do
+    {
+        HEAP_LOCK_FOR( eHeapLockPathMalloc );
+        {
+            if( pxEnd == NULL ) { prvHeapInit(); }
+
+            if( ( xTotalSize > 0 ) && heapOWNER_ADMIT( uxOwner, xTotalSize ) )
+            {
+                /* 先尝试找一个能容纳整批对象的空闲块，整批相邻切分 */
+                pxBlock = prvFindFirstFit( xTotalSize, &pxPreviousBlock );
+
+                if( pxBlock != pxEnd )
+                {
+                    ( void ) prvCarveBlock( pxPreviousBlock, pxBlock, xTotalSize );
+
+                    /* 不再分裂时多出的尾部空间归最后一个对象所有 */
+                    heapFREE_BLOCK( pxBlock );
+                    xCarvedSize = pxBlock->xBlockSize;
+                    puc = ( uint8_t * ) pxBlock;
+
+                    for( xIndex = 0; xIndex < xCount; xIndex++ )
+                    {
+                        pxNewBlockLink = ( BlockLink_t * ) ( puc + ( xIndex * xWantedSize ) );
+                        pxNewBlockLink->xBlockSize = ( xIndex == ( xCount - 1 ) ) ? ( xCarvedSize - ( xIndex * xWantedSize ) ) : xWantedSize;
+                        heapALLOCATE_BLOCK( pxNewBlockLink );
+                        pxNewBlockLink->pxNextFreeBlock = NULL;
+                        pvBlocks[ xIndex ] = ( void * ) ( ( ( uint8_t * ) pxNewBlockLink ) + xHeapStructSize );
+                    }
+
+                    xAllocated = xCount;
+                    xNumberOfSuccessfulAllocations += xCount - 1;
+                }
+                else
+                {
+                    /* 没有整块可用时逐个分配，仍只加一次锁 */
+                    for( xAllocated = 0; xAllocated < xCount; xAllocated++ )
+                    {
+                        pvBlocks[ xAllocated ] = prvAllocateBlock( xWantedSize );
+
+                        if( pvBlocks[ xAllocated ] == NULL )
+                        {
+                            break;
+                        }
+                    }
+
+                    /* 全部成功或全部失败：不完整的一批退回堆中 */
+                    if( xAllocated < xCount )
+                    {
+                        for( xIndex = 0; xIndex < xAllocated; xIndex++ )
+                        {
+                            pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pvBlocks[ xIndex ] ) - xHeapStructSize );
+                            heapFREE_BLOCK( pxBlock );
+                            xFreeBytesRemaining += pxBlock->xBlockSize;
+                            prvInsertBlockIntoFreeList( pxBlock );
+                        }
+
+                        xNumberOfSuccessfulAllocations -= xAllocated;
+                        xAllocated = 0;
+                    }
+                }
+
+                for( xIndex = 0; xIndex < xAllocated; xIndex++ )
+                {
+                    heapOWNER_CHARGE( pvBlocks[ xIndex ], uxOwner );
+                }
+            }
+
+            pvReturn = ( xAllocated > 0 ) ? pvBlocks[ 0 ] : NULL;
+            heapRECLAIM_NOTE_FREE();
+        }
+        HEAP_UNLOCK();
+    } while( heapRECLAIM_RETRY( pvReturn, xTotalSize ) );
+
+    heapRECLAIM_AFTER_ALLOCATE( pvReturn );
+
+    if( xAllocated == 0 )
+    {
+        for( xIndex = 0; xIndex < xCount; xIndex++ )
+        {
+            pvBlocks[ xIndex ] = NULL;
+        }
+    }
+
+    #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 3 )
+    {
+        for( xIndex = 0; xIndex < xAllocated; xIndex++ )
+        {
+            heapCLEAR_ON_ALLOCATE( pvBlocks[ xIndex ] );
+        }
+    }
+    #endif
+
+    #if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+    {
+        /* 整批计为一次 malloc 样本 */
+        prvLatencyRecord( 0, configHEAP_READ_CYCLES() - uxStartCycles );
+    }
+    #endif
+
+    return pvReturn;
+}
+
+void vPortFreeBatch( void * pvBlocks[], size_t xCount )
+{
+    BlockLink_t * pxLink, * pxIterator;
+    void * pvPrevious = NULL;
+    size_t xIndex;
+
+    /* 按地址排序后，整批只需沿空闲链表前进一遍即可全部插入并合并；重复的指针也会排在相邻位置 */
+    qsort( pvBlocks, xCount, sizeof( void * ), prvCompareAddress );
+
+    for( xIndex = 0; xIndex < xCount; xIndex++ )
+    {
+        /* 同一批中出现两次即为重复释放：此时块头仍标记为已分配，下面的断言查不出来 */
+        configASSERT( ( pvBlocks[ xIndex ] == NULL ) || ( pvBlocks[ xIndex ] != pvPrevious ) );
+        pvPrevious = pvBlocks[ xIndex ];
+
+        #if ( configHEAP_GUARDED_SAMPLING == 1 )
+        {
+            if( prvGuardedOwns( pvBlocks[ xIndex ] ) )
+            {
+                prvGuardedFree( pvBlocks[ xIndex ] );
+                pvBlocks[ xIndex ] = NULL;
+            }
+        }
+        #endif
+
+        #if ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 )
+        {
+            if( prvReserveOwns( pvBlocks[ xIndex ] ) )
+            {
+                prvReserveFree( pvBlocks[ xIndex ] );
+                pvBlocks[ xIndex ] = NULL;
+            }
+        }
+        #endif
+
+        #if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+        {
+            if( prvLargeOwns( pvBlocks[ xIndex ] ) )
+            {
+                prvLargeFree( pvBlocks[ xIndex ] );
+                pvBlocks[ xIndex ] = NULL;
+            }
+        }
+        #endif
+
+        if( pvBlocks[ xIndex ] != NULL )
+        {
+            pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pvBlocks[ xIndex ] ) - xHeapStructSize );
+
+            configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+            configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+            heapPROFILE_FREE( pxLink );
+
+            heapCLEAR_ON_FREE( pvBlocks[ xIndex ], heapBLOCK_SIZE( pxLink ) - xHeapStructSize );
+        }
+    }
+
+    HEAP_LOCK_FOR( eHeapLockPathFree );
+    {
+        pxIterator = &xStart;
+
+        for( xIndex = 0; xIndex < xCount; xIndex++ )
+        {
+            if( pvBlocks[ xIndex ] != NULL )
+            {
+                pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pvBlocks[ xIndex ] ) - xHeapStructSize );
+                heapOWNER_RELEASE( pxLink );
+                heapFREE_BLOCK( pxLink );
+                xFreeBytesRemaining += pxLink->xBlockSize;
+                pxIterator = prvInsertBlockIntoFreeListFrom( pxIterator, pxLink );
+                xNumberOfSuccessfulFrees++;
+            }
+        }
+    }
+    HEAP_UNLOCK();
+}
+
+#if ( configHEAP_FRAGMENTATION_METRICS == 1 )
+
+void vPortGetHeapFragmentationStats( HeapFragmentationStats_t * pxStats )
+{
+    BlockLink_t * pxBlock;
+    size_t xIndex;
+
+    HEAP_LOCK_FOR( eHeapLockPathStats );
+    {
+        if( pxEnd == NULL ) { prvHeapInit(); }
+
+        /* 最大块被分配或合并掉之后才需要重新遍历，平时直接使用增量维护的值 */
+        if( xLargestFreeBlockValid == 0 )
+        {
+            xLargestFreeBlock = 0;
+
+            for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+            {
+                if( pxBlock->xBlockSize > xLargestFreeBlock )
+                {
+                    xLargestFreeBlock = pxBlock->xBlockSize;
+                }
+            }
+
+            xLargestFreeBlockValid = 1;
+        }
+
+        for( xIndex = 0; xIndex < heapFRAGMENTATION_HISTOGRAM_BUCKETS; xIndex++ )
+        {
+            pxStats->xFreeBlockHistogram[ xIndex ] = xFreeBlockHistogram[ xIndex ];
+        }
+
+        pxStats->xNumberOfFreeBlocks = xNumberOfFreeBlocks;
+        pxStats->xSizeOfLargestFreeBlockInBytes = xLargestFreeBlock;
+        pxStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxStats->xTotalSearchSteps = xTotalSearchSteps;
+        pxStats->xNumberOfSearches = xNumberOfSearches;
+    }
+    HEAP_UNLOCK();
+
+    /* 外部碎片率 = 1 - 最大空闲块 / 总空闲字节，以千分比表示 */
+    pxStats->xFragmentationPerMille = 0;
+
+    if( pxStats->xAvailableHeapSpaceInBytes > 0 )
+    {
+        pxStats->xFragmentationPerMille = 1000U - ( size_t ) ( ( ( uint64_t ) pxStats->xSizeOfLargestFreeBlockInBytes * 1000U ) / pxStats->xAvailableHeapSpaceInBytes );
+    }
+
+    pxStats->xAverageSearchLength = ( pxStats->xNumberOfSearches > 0 ) ? ( pxStats->xTotalSearchSteps / pxStats->xNumberOfSearches ) : 0;
+}
+
+#endif /* configHEAP_FRAGMENTATION_METRICS */
+
+#if ( configHEAP_RELOCATABLE_HANDLES == 1 )
+
+/* 句柄对象的用户区紧跟在块头之后 */
+#define heapHANDLE_DATA( pxBlock )          ( ( void * ) ( ( ( uint8_t * ) ( pxBlock ) ) + xHeapStructSize ) )
+
+HeapHandle_t xPortHandleAlloc( size_t xWantedSize )
+{
+    BlockLink_t * pxBlock;
+    HeapHandle_t xHandle = 0;
+    size_t xIndex;
+    size_t uxOwner = heapCURRENT_OWNER();
+    void * pv;
+
+    xWantedSize = prvBlockSizeFor( xWantedSize );
+
+    HEAP_LOCK_FOR( eHeapLockPathMalloc );
+    {
+        if( pxEnd == NULL ) { prvHeapInit(); }
+
+        for( xIndex = 0; xIndex < configHEAP_HANDLE_COUNT; xIndex++ )
+        {
+            if( xHandleTable[ xIndex ].pxBlock == NULL )
+            {
+                break;
+            }
+        }
+
+        if( ( xIndex < configHEAP_HANDLE_COUNT ) && heapOWNER_ADMIT( uxOwner, xWantedSize ) )
+        {
+            pv = prvAllocateBlock( xWantedSize );
+
+            if( pv != NULL )
+            {
+                heapOWNER_CHARGE( pv, uxOwner );
+
+                /* 解锁后整理器随时可能移动该块，只能在锁内清零 */
+                heapCLEAR_ON_ALLOCATE( pv );
+
+                pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+                pxBlock->xBlockSize |= heapBLOCK_RELOCATABLE_BITMASK;
+                xHandleTable[ xIndex ].pxBlock = pxBlock;
+                xHandleTable[ xIndex ].xPinCount = 0;
+                xHandle = ( HeapHandle_t ) ( xIndex + 1 );
+            }
+        }
+    }
+    HEAP_UNLOCK();
+
+    return xHandle;
+}
+
+void vPortHandleFree( HeapHandle_t xHandle )
+{
+    BlockLink_t * pxBlock = NULL;
+
+    if( xHandle != 0 )
+    {
+        configASSERT( xHandle <= configHEAP_HANDLE_COUNT );
+
+        HEAP_LOCK_FOR( eHeapLockPathFree );
+        {
+            pxBlock = xHandleTable[ xHandle - 1 ].pxBlock;
+            configASSERT( pxBlock != NULL );
+            configASSERT( xHandleTable[ xHandle - 1 ].xPinCount == 0 );
+
+            /* 先去掉可重定位标记，之后整理器就不会再碰这个块 */
+            pxBlock->xBlockSize &= ~heapBLOCK_RELOCATABLE_BITMASK;
+            xHandleTable[ xHandle - 1 ].pxBlock = NULL;
+        }
+        HEAP_UNLOCK();
+
+        vPortFree( heapHANDLE_DATA( pxBlock ) );
+    }
+}
+
+void * pvPortHandlePin( HeapHandle_t xHandle )
+{
+    void * pvReturn = NULL;
+
+    if( ( xHandle != 0 ) && ( xHandle <= configHEAP_HANDLE_COUNT ) )
+    {
+        HEAP_LOCK();
+        {
+            if( xHandleTable[ xHandle - 1 ].pxBlock != NULL )
+            {
+                xHandleTable[ xHandle - 1 ].xPinCount++;
+                pvReturn = heapHANDLE_DATA( xHandleTable[ xHandle - 1 ].pxBlock );
+            }
+        }
+        HEAP_UNLOCK();
+    }
+
+    return pvReturn;
+}
+
+void vPortHandleUnpin( HeapHandle_t xHandle )
+{
+    configASSERT( ( xHandle != 0 ) && ( xHandle <= configHEAP_HANDLE_COUNT ) );
+
+    HEAP_LOCK();
+    {
+        configASSERT( xHandleTable[ xHandle - 1 ].xPinCount > 0 );
+        xHandleTable[ xHandle - 1 ].xPinCount--;
+    }
+    HEAP_UNLOCK();
+}
+
+/**
+ * @brief 查找块对应的句柄表项。只有可重定位块才会被查找，表项必然存在。
+ */
+static HeapHandleEntry_t * prvHandleEntryFor( const BlockLink_t * pxBlock )
+{
+    size_t xIndex;
+
+    for( xIndex = 0; xHandleTable[ xIndex ].pxBlock != pxBlock; xIndex++ )
+    {
+        configASSERT( xIndex < ( configHEAP_HANDLE_COUNT - 1 ) );
+    }
+
+    return &xHandleTable[ xIndex ];
+}
+
+int xPortHeapCompactStep( size_t xMaxSteps )
+{
+    BlockLink_t * pxFree, * pxNext, * pxNewFree;
+    HeapHandleEntry_t * pxEntry;
+    size_t xFreeSize, xMoveSize, xSteps;
+    int xMoreWork = 1;
+
+    HEAP_LOCK();
+    {
+        if( pxEnd == NULL ) { prvHeapInit(); }
+
+        /* 两次调用之间有人分配或释放过，游标可能已不在链表中，从头开始 */
+        if( ( pxCompactCursor == NULL ) || ( xCompactGeneration != xFreeListGeneration ) )
+        {
+            pxCompactCursor = &xStart;
+        }
+
+        for( xSteps = 0; xSteps < xMaxSteps; xSteps++ )
+        {
+            pxFree = pxCompactCursor->pxNextFreeBlock;
+            pxNext = ( BlockLink_t * ) ( ( ( uint8_t * ) pxFree ) + pxFree->xBlockSize );
+
+            /* 已经到达最高地址的空闲块：它之后再没有可以下移的块 */
+            if( ( pxFree == pxEnd ) || ( pxNext == pxEnd ) )
+            {
+                xMoreWork = 0;
+                break;
+            }
+
+            /* 相邻的空闲块总是已合并，所以 pxNext 一定是已分配块 */
+            pxEntry = NULL;
+
+            if( ( pxNext->xBlockSize & heapBLOCK_RELOCATABLE_BITMASK ) != 0 )
+            {
+                pxEntry = prvHandleEntryFor( pxNext );
+            }
+
+            if( ( pxEntry != NULL ) && ( pxEntry->xPinCount == 0 ) )
+            {
+                /* 把 pxNext 整体滑到 pxFree 的位置，空闲空间随之移到它后面 */
+                xFreeSize = pxFree->xBlockSize;
+                xMoveSize = heapBLOCK_SIZE( pxNext );
+
+                pxCompactCursor->pxNextFreeBlock = pxFree->pxNextFreeBlock;
+                heapINDEX_REMOVE( pxFree );
+                heapFREE_BLOCK_REMOVED( xFreeSize );
+                heapFREE_LIST_CHANGED( pxFree );
+
+                memmove( pxFree, pxNext, xMoveSize );
+                pxEntry->pxBlock = pxFree;
+
+                pxNewFree = ( BlockLink_t * ) ( ( ( uint8_t * ) pxFree ) + xMoveSize );
+
+                /* 腾出的空间里残留着被移动对象的旧数据 */
+                heapCLEAR_ON_FREE( pxNewFree, xFreeSize );
+
+                pxNewFree->xBlockSize = xFreeSize;
+                ( void ) prvInsertBlockIntoFreeListFrom( pxCompactCursor, pxNewFree );
+            }
+            else
+            {
+                /* 被钉住或不可重定位的块挡住了去路，跳过这个空闲块继续向后 */
+                pxCompactCursor = pxFree;
+            }
+        }
+
+        xCompactGeneration = xFreeListGeneration;
+    }
+    HEAP_UNLOCK();
+
+    return xMoreWork;
+}
+
+#endif /* configHEAP_RELOCATABLE_HANDLES */
+
+#if ( configHEAP_GUARDED_SAMPLING == 1 )
+
+/**
+ * @brief SIGSEGV 处理函数：故障地址落在守护池内时判断是越界还是释放后使用并输出报告，
+ * 然后恢复原来的处理方式返回，让同一条指令再次触发故障，交给原处理函数或默认动作（产生 core）。
+ */
+static void prvGuardedSegvHandler( int xSignal, siginfo_t * pxInfo, void * pvContext )
+{
+    uint8_t * pucAddress = ( uint8_t * ) pxInfo->si_addr;
+    size_t xPage;
+
+    ( void ) xSignal;
+    ( void ) pvContext;
+
+    if( prvGuardedOwns( pucAddress ) )
+    {
+        xPage = ( size_t ) ( pucAddress - pucGuardedPool ) / xGuardedPageSize;
+
+        if( ( xPage & 1U ) != 0 )
+        {
+            prvGuardedReport( "use after free", pucAddress, xPage / 2 );
+        }
+        else if( ( xPage > 0 ) && ( xGuardedSlots[ ( xPage / 2 ) - 1 ].xAllocated != 0 ) )
+        {
+            /* 对象紧贴右侧守护页，落在守护页上的访问多半是前一个槽的对象向后越界 */
+            prvGuardedReport( "buffer overflow", pucAddress, ( xPage / 2 ) - 1 );
+        }
+        else if( ( xPage / 2 ) < configHEAP_GUARDED_SLOTS )
+        {
+            prvGuardedReport( "buffer underflow", pucAddress, xPage / 2 );
+        }
+        else
+        {
+            prvGuardedReport( "wild access", pucAddress, configHEAP_GUARDED_SLOTS - 1 );
+        }
+    }
+
+    ( void ) sigaction( SIGSEGV, &xPreviousSegvAction, NULL );
+}
+
+int xPortGuardedInstallSignalHandler( void )
+{
+    struct sigaction xAction;
+
+    memset( &xAction, 0, sizeof( xAction ) );
+    xAction.sa_sigaction = prvGuardedSegvHandler;
+    xAction.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    ( void ) sigemptyset( &xAction.sa_mask );
+
+    return ( sigaction( SIGSEGV, &xAction, &xPreviousSegvAction ) == 0 );
+}
+
+#endif /* configHEAP_GUARDED_SAMPLING */
+
+#if ( configHEAP_INTEGRITY_CHECK == 1 )
+
+/**
+ * @brief 从 pxCheckCursor 开始按物理顺序检查最多 xMaxBlocks 个块。
+ * 调用者必须持有 HEAP_LOCK。到达 pxEnd 时再核对链表是否恰好走完、空闲字节数是否一致。
+ * @return int 正常返回 1；发现损坏返回 0（并把游标复位到堆头）
+ */
+static int prvCheckBlocks( size_t xMaxBlocks )
+{
+    BlockLink_t * pxBlock = pxCheckCursor;
+    BlockLink_t * pxExpectedFree = pxCheckLastFree->pxNextFreeBlock;
+    const char * pcReason = NULL;
+    size_t xBlockSize, xCount;
+
+    for( xCount = 0; ( xCount < xMaxBlocks ) && ( pxBlock < pxEnd ); xCount++ )
+    {
+        xBlockSize = heapBLOCK_SIZE( pxBlock );
+
+        if( ( ( ( uintptr_t ) pxBlock ) & portBYTE_ALIGNMENT_MASK ) != 0 )
+        {
+            pcReason = "misaligned block";
+        }
+        else if( ( xBlockSize < xHeapStructSize ) || ( ( xBlockSize & portBYTE_ALIGNMENT_MASK ) != 0 ) ||
+                 ( xBlockSize > ( size_t ) ( ( ( uint8_t * ) pxEnd ) - ( ( uint8_t * ) pxBlock ) ) ) )
+        {
+            pcReason = "bad block size";
+        }
+        else if( heapBLOCK_IS_ALLOCATED( pxBlock ) != 0 )
+        {
+            if( pxBlock == pxExpectedFree )
+            {
+                pcReason = "allocated block on free list";
+            }
+            else if( ( pxBlock->pxNextFreeBlock != NULL ) && ( ( pxBlock->xBlockSize & heapBLOCK_PENDING_CLEAR_BITMASK ) == 0 ) )
+            {
+                pcReason = "allocated block has a link";
+            }
+
+            xCheckPreviousFree = 0;
+        }
+        else
+        {
+            if( pxBlock != pxExpectedFree )
+            {
+                pcReason = "free block missing from free list";
+            }
+            else if( pxBlock->xBlockSize != xBlockSize )
+            {
+                pcReason = "free block has flags";
+            }
+            else if( xCheckPreviousFree != 0 )
+            {
+                pcReason = "adjacent free blocks not coalesced";
+            }
+            else if( ( pxBlock->pxNextFreeBlock <= pxBlock ) || ( pxBlock->pxNextFreeBlock > pxEnd ) )
+            {
+                pcReason = "free list out of order";
+            }
+            else
+            {
+                pxCheckLastFree = pxBlock;
+                pxExpectedFree = pxBlock->pxNextFreeBlock;
+                xCheckFreeBytes += xBlockSize;
+            }
+
+            xCheckPreviousFree = 1;
+        }
+
+        if( pcReason != NULL )
+        {
+            break;
+        }
+
+        pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+    }
+
+    if( ( pcReason == NULL ) && ( pxBlock >= pxEnd ) )
+    {
+        if( pxBlock != pxEnd )
+        {
+            pcReason = "block overruns heap end";
+        }
+        else if( pxExpectedFree != pxEnd )
+        {
+            pcReason = "free list points outside heap";
+            pxBlock = pxExpectedFree;
+        }
+        else if( xCheckFreeBytes != xFreeBytesRemaining )
+        {
+            pcReason = "free byte count mismatch";
+        }
+        else
+        {
+            xCheckPasses++;
+            pxBlock = NULL;
+        }
+    }
+
+    if( pcReason != NULL )
+    {
+        configHEAP_CORRUPTION_HOOK( ( void * ) pxBlock, pcReason );
+        pxBlock = NULL;
+    }
+
+    pxCheckCursor = pxBlock;
+
+    return ( pcReason == NULL );
+}
+
+/**
+ * @brief 游标失效（首次运行、上一轮结束或游标之前的块结构变了）时回到堆头重新开始。
+ */
+static void prvCheckResume( void )
+{
+    if( ( pxCheckCursor == NULL ) || ( uxCheckLowestChange < ( uintptr_t ) pxCheckCursor ) )
+    {
+        pxCheckCursor = ( BlockLink_t * ) ( ( ( uintptr_t ) ucHeap + portBYTE_ALIGNMENT_MASK ) & ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK ) );
+        pxCheckLastFree = &xStart;
+        xCheckPreviousFree = 0;
+        xCheckFreeBytes = 0;
+    }
+
+    uxCheckLowestChange = UINTPTR_MAX;
+}
+
+int xPortHeapCheck( void )
+{
+    int xReturn;
+
+    HEAP_LOCK();
+    {
+        if( pxEnd == NULL ) { prvHeapInit(); }
+
+        pxCheckCursor = NULL;
+        prvCheckResume();
+        xReturn = prvCheckBlocks( ( size_t ) -1 );
+    }
+    HEAP_UNLOCK();
+
+    return xReturn;
+}
+
+int xPortHeapCheckStep( size_t xMaxBlocks )
+{
+    int xReturn;
+
+    HEAP_LOCK();
+    {
+        if( pxEnd == NULL ) { prvHeapInit(); }
+
+        prvCheckResume();
+        xReturn = prvCheckBlocks( xMaxBlocks );
+    }
+    HEAP_UNLOCK();
+
+    return xReturn;
+}
+
+size_t xPortGetHeapCheckPasses( void ) { return xCheckPasses; }
+
+#endif /* configHEAP_INTEGRITY_CHECK */
+
+#if ( configHEAP_SNAPSHOT == 1 )
+
+#include <stdio.h>
+
+/* 快照文件标识 "FHSN" 与格式版本 */
+#define heapSNAPSHOT_MAGIC                  ( ( uint32_t ) 0x4E534846UL )
+#define heapSNAPSHOT_VERSION                ( ( uint32_t ) 1 )
+
+/* 指针与文件内偏移互相转换：偏移统一加 1 存储，0 表示 NULL */
+#define heapTO_OFFSET( pv )                 ( ( ( pv ) != NULL ) ? ( ( uint64_t ) ( ( uint8_t * ) ( pv ) - ucHeap ) + 1U ) : 0U )
+#define heapFROM_OFFSET( ull )              ( ( ( ull ) != 0U ) ? ( void * ) ( ucHeap + ( size_t ) ( ( ull ) - 1U ) ) : NULL )
+
+/* 快照文件头，其后依次是句柄表（若启用）和按 ullImageOffset 对齐的堆镜像 */
+typedef struct xHEAP_SNAPSHOT_HEADER
+{
+    uint32_t ulMagic;
+    uint32_t ulVersion;
+    uint32_t ulSizeOfSize;              /* sizeof( size_t )，防止在不同字长的程序间误用 */
+    uint32_t ulHeapStructSize;          /* xHeapStructSize */
+    uint64_t ullBaseAddress;            /* 保存时 ucHeap 的地址，恢复时必须一致 */
+    uint64_t ullImageSize;              /* 堆镜像字节数 */
+    uint64_t ullImageOffset;            /* 堆镜像在文件中的偏移（宿主机模式下按页对齐，可直接 mmap） */
+    uint64_t ullFirstFree;              /* xStart.pxNextFreeBlock */
+    uint64_t ullEnd;                    /* pxEnd */
+    uint64_t ullRoot;                   /* 应用的根对象 */
+    uint64_t ullFreeBytesRemaining;
+    uint64_t ullMinimumEverFreeBytesRemaining;
+    uint64_t ullNumberOfSuccessfulAllocations;
+    uint64_t ullNumberOfSuccessfulFrees;
+    uint64_t ullHandleCount;            /* 紧随文件头的句柄表项个数，每项一个 uint64_t 偏移 */
+} HeapSnapshotHeader_t;
+
+/**
+ * @brief 把空闲链表中的指针原地改写为偏移（xToOffset 为 1），或反向改写回指针。
+ * 调用者必须持有 HEAP_LOCK。已分配块的 pxNextFreeBlock 总是 NULL，无需处理。
+ */
+static void prvConvertFreeListLinks( BlockLink_t * pxFirstFree, int xToOffset )
+{
+    BlockLink_t * pxBlock = pxFirstFree;
+    BlockLink_t * pxNext;
+
+    while( pxBlock != pxEnd )
+    {
+        if( xToOffset != 0 )
+        {
+            pxNext = pxBlock->pxNextFreeBlock;
+            pxBlock->pxNextFreeBlock = ( BlockLink_t * ) ( uintptr_t ) heapTO_OFFSET( pxNext );
+        }
+        else
+        {
+            pxNext = ( BlockLink_t * ) heapFROM_OFFSET( ( uint64_t ) ( uintptr_t ) pxBlock->pxNextFreeBlock );
+            pxBlock->pxNextFreeBlock = pxNext;
+        }
+
+        pxBlock = pxNext;
+    }
+}
+
+int xPortHeapSnapshotSave( const char * pcPath, void * pvRoot )
+{
+    HeapSnapshotHeader_t xHeader;
+    BlockLink_t * pxFirstFree;
+    uint64_t ullEntry;
+    size_t xIndex;
+    FILE * pxFile;
+    char cStreamBuffer[ 4096 ];
+    int xReturn = 0;
+
+    pxFile = fopen( pcPath, "wb" );
+
+    if( pxFile != NULL )
+    {
+        /* 下面在堆锁内写文件：stdio 第一次写入时会 malloc 缓冲区，而 malloc 可能正是本堆（LD_PRELOAD），
+         * 会在非递归的堆锁上自锁。预先给流指定栈上的缓冲区，锁内就不会再分配 */
+        xReturn = ( setvbuf( pxFile, cStreamBuffer, _IOFBF, sizeof( cStreamBuffer ) ) == 0 );
+    }
+
+    if( xReturn != 0 )
+    {
+        HEAP_LOCK();
+        {
+            if( pxEnd == NULL ) { prvHeapInit(); }
+
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+            {
+                /* 待清零队列不进入快照：恢复后这些块会变成无人释放的已分配块 */
+                ( void ) prvDrainPendingClear();
+            }
+            #endif
+
+            memset( &xHeader, 0, sizeof( xHeader ) );
+            xHeader.ulMagic = heapSNAPSHOT_MAGIC;
+            xHeader.ulVersion = heapSNAPSHOT_VERSION;
+            xHeader.ulSizeOfSize = ( uint32_t ) sizeof( size_t );
+            xHeader.ulHeapStructSize = ( uint32_t ) xHeapStructSize;
+            xHeader.ullBaseAddress = ( uint64_t ) ( uintptr_t ) ucHeap;
+            xHeader.ullFirstFree = heapTO_OFFSET( xStart.pxNextFreeBlock );
+            xHeader.ullEnd = heapTO_OFFSET( pxEnd );
+            xHeader.ullRoot = heapTO_OFFSET( pvRoot );
+            xHeader.ullFreeBytesRemaining = xFreeBytesRemaining;
+            xHeader.ullMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+            xHeader.ullNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+            xHeader.ullNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+
+            #if ( configHEAP_HOSTED == 1 )
+            {
+                size_t xPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+
+                xHeader.ullImageSize = xHeapCommittedSize;
+                xHeader.ullImageOffset = xPageSize;
+                configASSERT( sizeof( xHeader ) + ( configHEAP_HANDLE_COUNT * sizeof( uint64_t ) ) <= xPageSize );
+            }
+            #else
+            {
+                xHeader.ullImageSize = configTOTAL_HEAP_SIZE;
+                xHeader.ullImageOffset = sizeof( xHeader );
+            }
+            #endif
+
+            #if ( configHEAP_RELOCATABLE_HANDLES == 1 )
+            {
+                xHeader.ullHandleCount = configHEAP_HANDLE_COUNT;
+
+                #if ( configHEAP_HOSTED == 0 )
+                {
+                    xHeader.ullImageOffset += configHEAP_HANDLE_COUNT * sizeof( uint64_t );
+                }
+                #endif
+            }
+            #endif
+
+            xReturn = ( fwrite( &xHeader, sizeof( xHeader ), 1, pxFile ) == 1 );
+
+            #if ( configHEAP_RELOCATABLE_HANDLES == 1 )
+            {
+                /* 钉住计数不保存：恢复后的指针都要重新通过 pvPortHandlePin 获取 */
+                for( xIndex = 0; xIndex < configHEAP_HANDLE_COUNT; xIndex++ )
+                {
+                    ullEntry = heapTO_OFFSET( xHandleTable[ xIndex ].pxBlock );
+                    xReturn &= ( fwrite( &ullEntry, sizeof( ullEntry ), 1, pxFile ) == 1 );
+                }
+            }
+            #else
+                ( void ) ullEntry;
+                ( void ) xIndex;
+            #endif
+
+            /* 镜像中的链接以偏移形式写出，写完立即改回指针 */
+            pxFirstFree = xStart.pxNextFreeBlock;
+            prvConvertFreeListLinks( pxFirstFree, 1 );
+            xReturn &= ( fseek( pxFile, ( long ) xHeader.ullImageOffset, SEEK_SET ) == 0 );
+            xReturn &= ( fwrite( ucHeap, 1, ( size_t ) xHeader.ullImageSize, pxFile ) == ( size_t ) xHeader.ullImageSize );
+            prvConvertFreeListLinks( pxFirstFree, 0 );
+        }
+        HEAP_UNLOCK();
+    }
+
+    if( pxFile != NULL )
+    {
+        xReturn &= ( fclose( pxFile ) == 0 );
+    }
+
+    return xReturn;
+}
+
+void * pvPortHeapSnapshotRestore( const char * pcPath )
+{
+    HeapSnapshotHeader_t xHeader;
+    BlockLink_t * pxBlock;
+    uint64_t ullEntry;
+    size_t xIndex;
+    FILE * pxFile;
+    void * pvRoot = NULL;
+    int xLoaded = 0;
+
+    pxFile = fopen( pcPath, "rb" );
+
+    if( pxFile != NULL )
+    {
+        HEAP_LOCK();
+        {
+            /* 只能在堆第一次使用之前恢复 */
+            if( ( pxEnd == NULL ) &&
+                ( fread( &xHeader, sizeof( xHeader ), 1, pxFile ) == 1 ) &&
+                ( xHeader.ulMagic == heapSNAPSHOT_MAGIC ) &&
+                ( xHeader.ulVersion == heapSNAPSHOT_VERSION ) &&
+                ( xHeader.ulSizeOfSize == sizeof( size_t ) ) &&
+                ( xHeader.ulHeapStructSize == xHeapStructSize ) &&
+                ( xHeader.ullHandleCount == ( ( configHEAP_RELOCATABLE_HANDLES == 1 ) ? configHEAP_HANDLE_COUNT : 0 ) ) )
+            {
+                #if ( configHEAP_HOSTED == 1 )
+                {
+                    /* 在原地址重新预留，再把镜像以私有映射铺在开头：页面按需读入，写时复制 */
+                    ucHeap = prvHeapReserve( ( uintptr_t ) xHeader.ullBaseAddress );
+
+                    if( ucHeap != NULL )
+                    {
+                        if( ( xHeader.ullImageSize <= configHEAP_HOSTED_RESERVE_SIZE ) &&
+                            ( mmap( ucHeap, ( size_t ) xHeader.ullImageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                                    fileno( pxFile ), ( off_t ) xHeader.ullImageOffset ) != MAP_FAILED ) )
+                        {
+                            xHeapCommittedSize = ( size_t ) xHeader.ullImageSize;
+                            xLoaded = 1;
+                        }
+                        else
+                        {
+                            ( void ) munmap( ucHeap, configHEAP_HOSTED_RESERVE_SIZE );
+                            ucHeap = NULL;
+                        }
+                    }
+                }
+                #else
+                {
+                    /* 静态堆池：地址与大小都必须和保存时一致，然后整体读入 */
+                    xLoaded = ( xHeader.ullBaseAddress == ( uint64_t ) ( uintptr_t ) ucHeap ) &&
+                              ( xHeader.ullImageSize == configTOTAL_HEAP_SIZE ) &&
+                              ( fseek( pxFile, ( long ) xHeader.ullImageOffset, SEEK_SET ) == 0 ) &&
+                              ( fread( ucHeap, 1, configTOTAL_HEAP_SIZE, pxFile ) == configTOTAL_HEAP_SIZE );
+                }
+                #endif
+            }
+
+            if( xLoaded != 0 )
+            {
+                xStart.pxNextFreeBlock = ( BlockLink_t * ) heapFROM_OFFSET( xHeader.ullFirstFree );
+                xStart.xBlockSize = ( size_t ) 0;
+                pxEnd = ( BlockLink_t * ) heapFROM_OFFSET( xHeader.ullEnd );
+                prvConvertFreeListLinks( xStart.pxNextFreeBlock, 0 );
+
+                xFreeBytesRemaining = ( size_t ) xHeader.ullFreeBytesRemaining;
+                xMinimumEverFreeBytesRemaining = ( size_t ) xHeader.ullMinimumEverFreeBytesRemaining;
+                xNumberOfSuccessfulAllocations = ( size_t ) xHeader.ullNumberOfSuccessfulAllocations;
+                xNumberOfSuccessfulFrees = ( size_t ) xHeader.ullNumberOfSuccessfulFrees;
+
+                #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+                {
+                    /* 原队列中的块已随堆池镜像一起被覆盖 */
+                    pxPendingClear = NULL;
+                    xPendingClearBytes = 0U;
+                }
+                #endif
+
+                #if ( configHEAP_OWNER_QUOTAS == 1 )
+                {
+                    prvOwnerRecount();
+                }
+                #endif
+
+                #if ( configHEAP_FREE_INDEX == 1 )
+                {
+                    ( void ) prvFreeIndexRebuild();
+                }
+                #endif
+
+                #if ( configHEAP_RELOCATABLE_HANDLES == 1 )
+                {
+                    ( void ) fseek( pxFile, ( long ) sizeof( xHeader ), SEEK_SET );
+
+                    for( xIndex = 0; xIndex < configHEAP_HANDLE_COUNT; xIndex++ )
+                    {
+                        ullEntry = 0;
+                        ( void ) fread( &ullEntry, sizeof( ullEntry ), 1, pxFile );
+                        xHandleTable[ xIndex ].pxBlock = ( BlockLink_t * ) heapFROM_OFFSET( ullEntry );
+                        xHandleTable[ xIndex ].xPinCount = 0;
+                    }
+
+                    pxCompactCursor = NULL;
+                }
+                #else
+                    ( void ) ullEntry;
+                    ( void ) xIndex;
+                #endif
+
+                /* 碎片化指标不在快照中，按恢复后的空闲链表重新统计 */
+                for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+                {
+                    heapFREE_BLOCK_ADDED( pxBlock->xBlockSize );
+                }
+
+                pvRoot = heapFROM_OFFSET( xHeader.ullRoot );
+            }
+        }
+        HEAP_UNLOCK();
+
+        ( void ) fclose( pxFile );
+    }
+
+    return pvRoot;
+}
+
+#endif /* configHEAP_SNAPSHOT */
+
+#if ( configHEAP_SAMPLING_PROFILER == 1 )
+
+void vPortHeapProfilerSetInterval( size_t xBytes )
+{
+    __atomic_store_n( &xProfileInterval, xBytes, __ATOMIC_RELAXED );
+}
+
+int xPortHeapProfileDump( const char * pcPath, int xPeak )
+{
+    const HeapProfileSite_t * pxSite;
+    size_t xCount = 0, xBytes = 0, xAllocCount = 0, xAllocBytes = 0, xIndex, i;
+    char cBuffer[ 256 ];
+    FILE * pxFile, * pxMaps;
+    int xReturn = 0;
+
+    /* 标准 I/O 内部会分配内存，输出期间本线程不采样，也就不会在 xProfileMutex 上自锁 */
+    xInsideProfiler++;
+
+    pxFile = fopen( pcPath, "w" );
+
+    if( pxFile != NULL )
+    {
+        pthread_mutex_lock( &xProfileMutex );
+        {
+            for( xIndex = 0; xIndex < configHEAP_PROFILER_MAX_SITES; xIndex++ )
+            {
+                pxSite = &xProfileSites[ xIndex ];
+                xCount += ( xPeak != 0 ) ? pxSite->xPeakCount : pxSite->xLiveCount;
+                xBytes += ( xPeak != 0 ) ? pxSite->xPeakBytes : pxSite->xLiveBytes;
+                xAllocCount += pxSite->xAllocCount;
+                xAllocBytes += pxSite->xAllocBytes;
+            }
+
+            /* gperftools heap_v2 文本格式：计数是原始样本值，由 pprof 按采样间隔还原 */
+            fprintf( pxFile, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+                     xCount, xBytes, xAllocCount, xAllocBytes, __atomic_load_n( &xProfileInterval, __ATOMIC_RELAXED ) );
+
+            for( xIndex = 0; xIndex < configHEAP_PROFILER_MAX_SITES; xIndex++ )
+            {
+                pxSite = &xProfileSites[ xIndex ];
+
+                if( pxSite->xDepth != 0 )
+                {
+                    fprintf( pxFile, "%zu: %zu [%zu: %zu] @",
+                             ( xPeak != 0 ) ? pxSite->xPeakCount : pxSite->xLiveCount,
+                             ( xPeak != 0 ) ? pxSite->xPeakBytes : pxSite->xLiveBytes,
+                             pxSite->xAllocCount, pxSite->xAllocBytes );
+
+                    for( i = 0; i < pxSite->xDepth; i++ )
+                    {
+                        fprintf( pxFile, " 0x%" PRIxPTR, ( uintptr_t ) pxSite->pvStack[ i ] );
+                    }
+
+                    fputc( '\n', pxFile );
+                }
+            }
+        }
+        pthread_mutex_unlock( &xProfileMutex );
+
+        /* pprof 依据模块映射把地址还原成符号 */
+        fputs( "\nMAPPED_LIBRARIES:\n", pxFile );
+        pxMaps = fopen( "/proc/self/maps", "r" );
+
+        if( pxMaps != NULL )
+        {
+            while( ( i = fread( cBuffer, 1, sizeof( cBuffer ), pxMaps ) ) > 0 )
+            {
+                ( void ) fwrite( cBuffer, 1, i, pxFile );
+            }
+
+            ( void ) fclose( pxMaps );
+        }
+
+        xReturn = ( ferror( pxFile ) == 0 );
+        xReturn = ( fclose( pxFile ) == 0 ) && xReturn;
+    }
+
+    xInsideProfiler--;
+
+    return xReturn;
+}
+
+#endif /* configHEAP_SAMPLING_PROFILER */
+
+#if ( configHEAP_LATENCY_HISTOGRAMS == 1 )
+
+void vPortGetHeapLatencyStats( HeapLatencyStats_t * pxStats )
+{
+    const HeapLatencyRecord_t * pxRecord;
+    size_t xBucket;
+
+    memset( pxStats, 0, sizeof( *pxStats ) );
+
+    /* 记录只挂不摘，沿链表读取时其他线程仍可并发计数，合并结果是近似的瞬时值 */
+    for( pxRecord = __atomic_load_n( &pxLatencyRecords, __ATOMIC_ACQUIRE ); pxRecord != NULL; pxRecord = pxRecord->pxNext )
+    {
+        for( xBucket = 0; xBucket < heapLATENCY_BUCKETS; xBucket++ )
+        {
+            pxStats->xMallocCycles[ xBucket ] += __atomic_load_n( &pxRecord->xMallocCycles[ xBucket ], __ATOMIC_RELAXED );
+            pxStats->xMallocNodes[ xBucket ] += __atomic_load_n( &pxRecord->xMallocNodes[ xBucket ], __ATOMIC_RELAXED );
+            pxStats->xFreeCycles[ xBucket ] += __atomic_load_n( &pxRecord->xFreeCycles[ xBucket ], __ATOMIC_RELAXED );
+            pxStats->xFreeNodes[ xBucket ] += __atomic_load_n( &pxRecord->xFreeNodes[ xBucket ], __ATOMIC_RELAXED );
+        }
+
+        pxStats->xNumberOfThreads++;
+    }
+
+    for( xBucket = 0; xBucket < heapLATENCY_BUCKETS; xBucket++ )
+    {
+        pxStats->xNumberOfMallocs += pxStats->xMallocCycles[ xBucket ];
+        pxStats->xNumberOfFrees += pxStats->xFreeCycles[ xBucket ];
+    }
+}
+
+#endif /* configHEAP_LATENCY_HISTOGRAMS */
+
+#if ( configHEAP_LOCK_STATS == 1 )
+
+void vPortGetHeapLockStats( HeapLockStats_t * pxStats )
+{
+    /* 本次查询的获取在复制之前已计入，持锁时间要到下一次快照才可见 */
+    HEAP_LOCK_FOR( eHeapLockPathStats );
+    {
+        memcpy( pxStats, &xLockStats, sizeof( *pxStats ) );
+    }
+    HEAP_UNLOCK();
+}
+
+void vPortResetHeapLockStats( void )
+{
+    HEAP_LOCK_FOR( eHeapLockPathStats );
+    {
+        memset( &xLockStats, 0, sizeof( xLockStats ) );
+    }
+    HEAP_UNLOCK();
+}
+
+#endif /* configHEAP_LOCK_STATS */
+
+#if ( configHEAP_LATENCY_HISTOGRAMS == 1 ) || ( configHEAP_LOCK_STATS == 1 )
+
+uint64_t uxPortHeapLatencyBucketValue( size_t xBucket )
+{
+    size_t xExponent;
+
+    if( xBucket < ( 1U << heapLATENCY_SUB_BUCKET_BITS ) )
+    {
+        return ( uint64_t ) xBucket;
+    }
+
+    xExponent = ( xBucket >> heapLATENCY_SUB_BUCKET_BITS ) + heapLATENCY_SUB_BUCKET_BITS - 1U;
+
+    return ( ( uint64_t ) ( xBucket & ( ( 1U << heapLATENCY_SUB_BUCKET_BITS ) - 1U ) ) | ( 1U << heapLATENCY_SUB_BUCKET_BITS ) ) << ( xExponent - heapLATENCY_SUB_BUCKET_BITS );
+}
+
+uint64_t uxPortHeapLatencyPercentile( const size_t pxHistogram[ heapLATENCY_BUCKETS ], size_t xPerMille )
+{
+    size_t xTotal = 0, xSeen = 0, xTarget, xBucket;
+
+    for( xBucket = 0; xBucket < heapLATENCY_BUCKETS; xBucket++ )
+    {
+        xTotal += pxHistogram[ xBucket ];
+    }
+
+    /* 目标名次向上取整，至少为 1；空直方图返回 0 */
+    xTarget = ( ( xTotal * xPerMille ) + 999U ) / 1000U;
+    xTarget = ( xTarget == 0 ) ? 1 : xTarget;
+
+    for( xBucket = 0; xBucket < heapLATENCY_BUCKETS; xBucket++ )
+    {
+        xSeen += pxHistogram[ xBucket ];
+
+        if( xSeen >= xTarget )
+        {
+            return uxPortHeapLatencyBucketValue( xBucket );
+        }
+    }
+
+    return 0;
+}
+
+#endif /* configHEAP_LATENCY_HISTOGRAMS || configHEAP_LOCK_STATS */
+
+#if ( configHEAP_OWNER_QUOTAS == 1 )
+
+void vPortHeapSetCurrentOwner( size_t uxOwner )
+{
+    configASSERT( uxOwner < heapOWNER_COUNT );
+    uxHeapCurrentOwner = uxOwner;
+}
+
+void vPortHeapSetOwnerLimits( size_t uxOwner, size_t xSoftLimit, size_t xHardLimit )
+{
+    configASSERT( uxOwner < heapOWNER_COUNT );
+
+    if( uxOwner < heapOWNER_COUNT )
+    {
+        HEAP_LOCK();
+        {
+            xOwnerStats[ uxOwner ].xSoftLimit = xSoftLimit;
+            xOwnerStats[ uxOwner ].xHardLimit = xHardLimit;
+        }
+        HEAP_UNLOCK();
+    }
+}
+
+void vPortGetHeapOwnerStats( size_t uxOwner, HeapOwnerStats_t * pxStats )
+{
+    configASSERT( uxOwner < heapOWNER_COUNT );
+
+    if( uxOwner < heapOWNER_COUNT )
+    {
+        HEAP_LOCK_FOR( eHeapLockPathStats );
+        {
+            *pxStats = xOwnerStats[ uxOwner ];
+        }
+        HEAP_UNLOCK();
+    }
+}
+
+#endif /* configHEAP_OWNER_QUOTAS */
+
+#if ( configHEAP_RECLAIM_CALLBACKS == 1 )
+
+int xPortHeapRegisterReclaim( HeapReclaimCallback_t pxCallback, void * pvContext, size_t uxPriority, size_t xWatermark )
+{
+    size_t xIndex;
+    int xReturn = 0;
+
+    configASSERT( pxCallback != NULL );
+
+    HEAP_LOCK();
+    {
+        if( xReclaimEntryCount < configHEAP_RECLAIM_MAX_CALLBACKS )
+        {
+            /* 插入排序：同优先级的回调按注册顺序调用 */
+            for( xIndex = xReclaimEntryCount; ( xIndex > 0 ) && ( xReclaimEntries[ xIndex - 1 ].uxPriority > uxPriority ); xIndex-- )
+            {
+                xReclaimEntries[ xIndex ] = xReclaimEntries[ xIndex - 1 ];
+            }
+
+            xReclaimEntries[ xIndex ].pxCallback = pxCallback;
+            xReclaimEntries[ xIndex ].pvContext = pvContext;
+            xReclaimEntries[ xIndex ].uxPriority = uxPriority;
+            xReclaimEntries[ xIndex ].xWatermark = xWatermark;
+            xReclaimEntries[ xIndex ].xArmed = 1;
+            xReclaimEntryCount++;
+            prvReclaimUpdateThresholds();
+            xReturn = 1;
+        }
+    }
+    HEAP_UNLOCK();
+
+    return xReturn;
+}
+
+void vPortHeapUnregisterReclaim( HeapReclaimCallback_t pxCallback, void * pvContext )
+{
+    size_t xIndex;
+
+    HEAP_LOCK();
+    {
+        for( xIndex = 0; xIndex < xReclaimEntryCount; xIndex++ )
+        {
+            if( ( xReclaimEntries[ xIndex ].pxCallback == pxCallback ) && ( xReclaimEntries[ xIndex ].pvContext == pvContext ) )
+            {
+                memmove( &xReclaimEntries[ xIndex ], &xReclaimEntries[ xIndex + 1 ], ( xReclaimEntryCount - xIndex - 1 ) * sizeof( HeapReclaimEntry_t ) );
+                xReclaimEntryCount--;
+                prvReclaimUpdateThresholds();
+                break;
+            }
+        }
+    }
+    HEAP_UNLOCK();
+}
+
+#endif /* configHEAP_RECLAIM_CALLBACKS */
+
+#if ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 )
+
+void * pvPortMallocCritical( size_t xWantedSize )
+{
+    void * pvReturn = pvPortMalloc( xWantedSize );
+
+    /* 只有主堆失败才会走到这里，普通分配的快速路径不受影响 */
+    if( ( pvReturn == NULL ) && ( xWantedSize > 0 ) )
+    {
+        pvReturn = prvReserveMalloc( prvBlockSizeFor( xWantedSize ) );
+    }
+
+    return pvReturn;
+}
+
+void vPortGetHeapReserveStats( HeapReserveStats_t * pxStats )
+{
+    HEAP_LOCK_FOR( eHeapLockPathStats );
+    {
+        if( xReserveInitialised == 0 ) { prvReserveInit(); }
+
+        *pxStats = xReserveStats;
+    }
+    HEAP_UNLOCK();
+}
+
+#endif /* configHEAP_EMERGENCY_RESERVE_SIZE */
+
+#if ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+
+void vPortGetHeapLargeObjectStats( HeapLargeObjectStats_t * pxStats )
+{
+    HEAP_LOCK_FOR( eHeapLockPathStats );
+    {
+        pxStats->xMappedBytes = xLargeMappedBytes;
+        pxStats->xPeakMappedBytes = xLargePeakMappedBytes;
+        pxStats->xAllocations = xLargeAllocations;
+        pxStats->xFrees = xLargeFrees;
+        pxStats->xRemaps = xLargeRemaps;
+    }
+    HEAP_UNLOCK();
+}
+
+#endif /* configHEAP_LARGE_OBJECT_THRESHOLD */
+
+#if ( configHEAP_HOSTED == 1 )
+
+/* 并行预取时每个线程负责的一段 */
+typedef struct xHEAP_TOUCH_SLICE
+{
+    uint8_t * puc;
+    size_t xSize;
+} HeapTouchSlice_t;
+
+static void * prvHeapTouchThread( void * pvSlice )
+{
+    prvHeapTouch( ( ( HeapTouchSlice_t * ) pvSlice )->puc, ( ( HeapTouchSlice_t * ) pvSlice )->xSize );
+
+    return NULL;
+}
+
+void vPortHeapInitialise( void )
+{
+    HeapTouchSlice_t xSlices[ configHEAP_HOSTED_PREFAULT_THREADS ];
+    pthread_t xThreads[ configHEAP_HOSTED_PREFAULT_THREADS ];
+    int xStarted[ configHEAP_HOSTED_PREFAULT_THREADS ];
+    size_t xPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+    size_t xSliceSize, xCommitted = 0U, xIndex;
+
+    HEAP_LOCK();
+    {
+        if( pxEnd == NULL )
+        {
+            /* 初始提交先不预取，解锁后再分给多个线程；这期间其他线程已经可以分配 */
+            xHeapPrefaultDeferred = ( configHEAP_HOSTED_PREFAULT_THREADS > 1 );
+            prvHeapInit();
+            xHeapPrefaultDeferred = 0;
+
+            xCommitted = ( ( configHEAP_HOSTED_PREFAULT_THREADS > 1 ) && ( xHeapLockedBytes == 0U ) ) ? xHeapCommittedSize : 0U;
+        }
+    }
+    HEAP_UNLOCK();
+
+    if( ( xCommitted > 0U ) && ( ( configHEAP_HOSTED_PREFAULT == 1 ) || ( configHEAP_HOSTED_MLOCK == 1 ) ) )
+    {
+        xSliceSize = ( ( xCommitted / configHEAP_HOSTED_PREFAULT_THREADS ) + xPageSize - 1U ) & ~( xPageSize - 1U );
+
+        for( xIndex = 0U; xIndex < configHEAP_HOSTED_PREFAULT_THREADS; xIndex++ )
+        {
+            xSlices[ xIndex ].puc = ucHeap + ( xIndex * xSliceSize );
+            xSlices[ xIndex ].xSize = ( ( xIndex * xSliceSize ) >= xCommitted ) ? 0U :
+                                      ( ( xCommitted - ( xIndex * xSliceSize ) ) < xSliceSize ) ? ( xCommitted - ( xIndex * xSliceSize ) ) : xSliceSize;
+
+            /* 第 0 段由当前线程处理；线程创建失败时也就地处理 */
+            xStarted[ xIndex ] = ( xIndex > 0U ) && ( xSlices[ xIndex ].xSize > 0U ) &&
+                                 ( pthread_create( &xThreads[ xIndex ], NULL, prvHeapTouchThread, &xSlices[ xIndex ] ) == 0 );
+        }
+
+        for( xIndex = 0U; xIndex < configHEAP_HOSTED_PREFAULT_THREADS; xIndex++ )
+        {
+            if( xStarted[ xIndex ] != 0 )
+            {
+                ( void ) pthread_join( xThreads[ xIndex ], NULL );
+            }
+            else if( xSlices[ xIndex ].xSize > 0U )
+            {
+                prvHeapTouch( xSlices[ xIndex ].puc, xSlices[ xIndex ].xSize );
+            }
+        }
+    }
+}
+
+void vPortGetHeapHostedStats( HeapHostedStats_t * pxStats )
+{
+    HEAP_LOCK_FOR( eHeapLockPathStats );
+    {
+        pxStats->xCommittedBytes = xHeapCommittedSize;
+        pxStats->xHugePageBytes = xHeapHugePageBytes;
+        pxStats->xLockedBytes = xHeapLockedBytes;
+        pxStats->xLockFailures = xHeapLockFailures;
+    }
+    HEAP_UNLOCK();
+}
+
+void vPortHeapForkPrepare( void )
+{
+    /* 剖析器输出时持有 xProfileMutex 并可能分配内存，加锁顺序为先剖析器后堆 */
+    #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        pthread_mutex_lock( &xProfileMutex );
+    #endif
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+        pthread_mutex_lock( &xGuardedMutex );
+    #endif
+
+    HEAP_LOCK();
+}
+
+void vPortHeapForkRelease( void )
+{
+    HEAP_UNLOCK();
+
+    #if ( configHEAP_GUARDED_SAMPLING == 1 )
+        pthread_mutex_unlock( &xGuardedMutex );
+    #endif
+
+    #if ( configHEAP_SAMPLING_PROFILER == 1 )
+        pthread_mutex_unlock( &xProfileMutex );
+    #endif
+}
+
+#endif /* configHEAP_HOSTED */
+
+size_t xPortGetFreeHeapSize( void ) { return xFreeBytesRemaining; }
+size_t xPortGetMinimumEverFreeHeapSize( void ) { return xMinimumEverFreeBytesRemaining; }
+
+/* --- Arena（区域分配器） --- */
+
+/* Arena 内存块头：所有块通过 pxNextChunk 串成单链表 */
+typedef struct xHEAP_ARENA_CHUNK
+{
+    struct xHEAP_ARENA_CHUNK * pxNextChunk; /**< 链上的下一个内存块 */
+    size_t xCapacity;                       /**< 块头之后可供分配的字节数 */
+} ArenaChunk_t;
+
+struct xHEAP_ARENA
+{
+    ArenaChunk_t * pxFirstChunk;   /**< 第一个内存块，与 Arena 结构体同属一次分配 */
+    ArenaChunk_t * pxCurrentChunk; /**< 当前正在递增分配的内存块 */
+    size_t xOffset;                /**< 当前块内已使用的字节数 */
+    size_t xChunkSize;             /**< 追加新块时的默认容量 */
+};
+
+static const size_t xArenaStructSize = ( sizeof( HeapArena_t ) + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+static const size_t xArenaChunkStructSize = ( sizeof( ArenaChunk_t ) + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+
+/* 块头之后的第一个可用字节 */
+#define arenaCHUNK_DATA( pxChunk )          ( ( ( uint8_t * ) ( pxChunk ) ) + xArenaChunkStructSize )
+
+HeapArena_t * pxPortArenaCreate( size_t xChunkSize )
+{
+    HeapArena_t * pxArena = NULL;
+    ArenaChunk_t * pxChunk;
+    size_t xTotalSize;
+
+    xChunkSize = ( xChunkSize + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+    xTotalSize = xArenaStructSize + xArenaChunkStructSize + xChunkSize;
+
+    /* 防止 xChunkSize 过大导致加法回绕 */
+    if( ( xChunkSize > 0 ) && ( xTotalSize > xChunkSize ) )
+    {
+        pxArena = pvPortMalloc( xTotalSize );
+    }
+
+    if( pxArena != NULL )
+    {
+        pxChunk = ( ArenaChunk_t * ) ( ( ( uint8_t * ) pxArena ) + xArenaStructSize );
+        pxChunk->pxNextChunk = NULL;
+        pxChunk->xCapacity = xChunkSize;
+
+        pxArena->pxFirstChunk = pxChunk;
+        pxArena->pxCurrentChunk = pxChunk;
+        pxArena->xOffset = 0;
+        pxArena->xChunkSize = xChunkSize;
+    }
+
+    return pxArena;
+}
+
+void * pvPortArenaAlloc( HeapArena_t * pxArena, size_t xWantedSize )
+{
+    ArenaChunk_t * pxChunk = pxArena->pxCurrentChunk;
+    ArenaChunk_t * pxNewChunk;
+    size_t xOffset = pxArena->xOffset;
+    size_t xNewCapacity;
+    void * pvReturn = NULL;
+
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= ( ( size_t ) -1 ) - portBYTE_ALIGNMENT_MASK - xArenaChunkStructSize ) )
+    {
+        xWantedSize = ( xWantedSize + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+
+        /* 当前块放不下时沿链向后找：先复用回滚后保留下来的块，链尾仍不够再向堆申请新块 */
+        while( ( pxChunk != NULL ) && ( xWantedSize > ( pxChunk->xCapacity - xOffset ) ) )
+        {
+            if( pxChunk->pxNextChunk == NULL )
+            {
+                xNewCapacity = ( xWantedSize > pxArena->xChunkSize ) ? xWantedSize : pxArena->xChunkSize;
+                pxNewChunk = pvPortMalloc( xArenaChunkStructSize + xNewCapacity );
+
+                if( pxNewChunk != NULL )
+                {
+                    pxNewChunk->pxNextChunk = NULL;
+                    pxNewChunk->xCapacity = xNewCapacity;
+                    pxChunk->pxNextChunk = pxNewChunk;
+                }
+            }
+
+            pxChunk = pxChunk->pxNextChunk;
+            xOffset = 0;
+        }
+
+        if( pxChunk != NULL )
+        {
+            pvReturn = ( void * ) ( arenaCHUNK_DATA( pxChunk ) + xOffset );
+            pxArena->pxCurrentChunk = pxChunk;
+            pxArena->xOffset = xOffset + xWantedSize;
+        }
+    }
+
+    return pvReturn;
+}
+
+HeapArenaMark_t xPortArenaMark( const HeapArena_t * pxArena )
+{
+    HeapArenaMark_t xMark;
+
+    xMark.pvChunk = ( void * ) pxArena->pxCurrentChunk;
+    xMark.xOffset = pxArena->xOffset;
+
+    return xMark;
+}
+
+void vPortArenaRewind( HeapArena_t * pxArena, HeapArenaMark_t xMark )
+{
+    configASSERT( xMark.pvChunk != NULL );
+    configASSERT( xMark.xOffset <= ( ( ArenaChunk_t * ) xMark.pvChunk )->xCapacity );
+
+    pxArena->pxCurrentChunk = ( ArenaChunk_t * ) xMark.pvChunk;
+    pxArena->xOffset = xMark.xOffset;
+}
+
+void vPortArenaReset( HeapArena_t * pxArena )
+{
+    pxArena->pxCurrentChunk = pxArena->pxFirstChunk;
+    pxArena->xOffset = 0;
+}
+
+void vPortArenaDestroy( HeapArena_t * pxArena )
+{
+    ArenaChunk_t * pxChunk;
+    ArenaChunk_t * pxNextChunk;
+
+    if( pxArena != NULL )
+    {
+        /* 第一个块与 Arena 结构体同属一次分配，最后随 Arena 一起释放 */
+        for( pxChunk = pxArena->pxFirstChunk->pxNextChunk; pxChunk != NULL; pxChunk = pxNextChunk )
+        {
+            pxNextChunk = pxChunk->pxNextChunk;
+            vPortFree( pxChunk );
+        }
+
+        vPortFree( pxArena );
+    }
+}
\ No newline at end of file
@@ -1,49 +1,601 @@
-/*
- * 基于 FreeRTOS 内存管理接口修改
- * Original: FreeRTOS Kernel V11.1.0
- * Copyright (C) 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
- * 
- * SPDX-License-Identifier: MIT
- *
- * 本头文件定义了基于 FreeRTOS 的内存管理接口，提供了标准的 malloc/free 功能。
- */
-#ifndef HEAP_H
-#define HEAP_H
-
-#include <stddef.h>
-#include <stdint.h>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-/**
- * @brief 内存分配函数
- * * @param xWantedSize 期望分配的字节数
- * @return void* 指向分配内存的指针；若分配失败则返回 NULL
- */
-void * pvPortMalloc( size_t xWantedSize );
-
-/**
- * @brief 内存释放函数
- * * @param pv 指向要释放内存的指针（必须由 pvPortMalloc 分配）
- */
-void vPortFree( void * pv );
-
-/**
- * @brief 获取当前堆中剩余的空闲内存大小
- * * @return size_t 当前可用字节数
- */
-size_t xPortGetFreeHeapSize( void );
-
-/**
- * @brief 获取系统运行以来历史最低的空闲内存大小（水位线）
- * * @return size_t 历史最少剩余字节数。值越小说明内存压力越大。
- */
-size_t xPortGetMinimumEverFreeHeapSize( void );
-
-#ifdef __cplusplus
-}
-#endif
-
+/*
+ * 基于 FreeRTOS 内存管理接口修改
+ * Original: FreeRTOS Kernel V11.1.0
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * 
+ * SPDX-License-Identifier: MIT
+ *
+ * 本头文件定义了基于 FreeRTOS 的内存管理接口，提供了标准的 malloc/free 功能。
+ */
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 内存分配函数
+ * * @param xWantedSize 期望分配的字节数
+ * @return void* 指向分配内存的指针；若分配失败则返回 NULL
+ */
+void * pvPortMalloc( size_t xWantedSize );
+
+/**
+ * @brief 内存释放函数
+ * * @param pv 指向要释放内存的指针（必须由 pvPortMalloc 分配）
+ */
+void vPortFree( void * pv );
+
+/**
+ * @brief 分配 xNum 个 xSize 字节的对象并清零
+ * @return void* 指向分配内存的指针；若分配失败或 xNum * xSize 溢出则返回 NULL
+ */
+void * pvPortCalloc( size_t xNum, size_t xSize );
+
+/**
+ * @brief 按指定对齐分配内存
+ * @param xWantedSize 期望分配的字节数
+ * @param xAlignment 对齐字节数，必须是 2 的幂；不大于 portBYTE_ALIGNMENT 时等同于 pvPortMalloc
+ * @return void* 满足对齐要求的指针，可用 vPortFree 释放；失败返回 NULL
+ */
+void * pvPortMallocAligned( size_t xWantedSize, size_t xAlignment );
+
+/**
+ * @brief 分配生命周期提示
+ */
+typedef enum
+{
+    eHeapShortLived = 0, /**< 很快会释放：首次适配，放在堆的低端 */
+    eHeapLongLived       /**< 长期持有：从地址最高的合适空闲块的高端切下，放在堆的高端 */
+} HeapLifetimeHint_t;
+
+/**
+ * @brief 带生命周期提示的分配。
+ * 长短生命周期的块分居堆的两端，长期持有的块不会在低端形成孤岛，
+ * 短生命周期分配的首次适配查找也不必越过它们。
+ * 长期分配需要遍历整个空闲链表，只适合启动阶段或不频繁的分配。
+ * @param xWantedSize 期望分配的字节数
+ * @param eHint 生命周期提示
+ * @return void* 指向分配内存的指针，可用 vPortFree 释放；失败返回 NULL
+ */
+void * pvPortMallocHinted( size_t xWantedSize, HeapLifetimeHint_t eHint );
+
+/**
+ * @brief 调整已分配内存的大小
+ * 缩小时原地切下尾部；扩大时若紧随其后的块空闲且足够大则原地合并，否则重新分配并复制。
+ * @param pv 原指针，为 NULL 时等同于 pvPortMalloc
+ * @param xWantedSize 新的字节数，为 0 时等同于 vPortFree 并返回 NULL
+ * @return void* 新指针；失败时返回 NULL，原内存保持不变
+ */
+void * pvPortRealloc( void * pv, size_t xWantedSize );
+
+/**
+ * @brief 获取已分配内存实际可用的字节数（不小于分配时请求的大小）
+ * @return size_t 可用字节数；pv 为 NULL 时返回 0
+ */
+size_t xPortGetAllocatedSize( void * pv );
+
+/**
+ * @brief 带大小提示的内存释放函数
+ * 调试版会用块头校验 xSize；发布版（NDEBUG）不读取 xSize。
+ * 块大小本来就记录在块头里，目前这个入口并不比 vPortFree 快，只是为调用者保留了带大小的接口。
+ * 释放清零与 vPortFree 相同，覆盖整个块的可用空间。
+ * @param pv 指向要释放内存的指针（必须由 pvPortMalloc 分配）
+ * @param xSize 分配时传给 pvPortMalloc 的字节数
+ */
+void vPortFreeSized( void * pv, size_t xSize );
+
+/**
+ * @brief 批量分配 xCount 个同样大小的对象，整批只加一次锁。
+ * 优先从同一个空闲块中连续切分出所有对象；找不到时再逐个分配。
+ * 分配是全部成功或全部失败的：失败时 pvBlocks 全部置为 NULL，不留下任何已分配的块
+ * （宿主机模式下为这一批扩展出的堆池空间不会收回，作为空闲块保留）。
+ * 与 pvPortMalloc 一样参与所有者配额、失败时的回收重试与延迟统计（整批计为一次样本）；
+ * 每个对象达到大对象阈值时逐个走 pvPortMalloc。整批相邻切分的对象不参与守护页抽样和分析器抽样。
+ * @param xWantedSize 每个对象的字节数
+ * @param xCount 对象个数
+ * @param pvBlocks 输出数组，至少 xCount 个元素；每个元素都可单独用 vPortFree 释放
+ * @return void* 第一个对象的指针（即 pvBlocks[0]）；失败返回 NULL
+ */
+void * pvPortMallocBatch( size_t xWantedSize, size_t xCount, void * pvBlocks[] );
+
+/**
+ * @brief 批量释放，整批只加一次锁。
+ * 释放前会把 pvBlocks 按地址原地排序，使所有块沿空闲链表一遍完成插入与合并。
+ * @param pvBlocks 待释放的指针数组（元素可为 NULL，调用后数组顺序会被改变）
+ * @param xCount 数组元素个数
+ */
+void vPortFreeBatch( void * pvBlocks[], size_t xCount );
+
+/**
+ * @brief 获取当前堆中剩余的空闲内存大小
+ * * @return size_t 当前可用字节数
+ */
+size_t xPortGetFreeHeapSize( void );
+
+/**
+ * @brief 获取系统运行以来历史最低的空闲内存大小（水位线）
+ * * @return size_t 历史最少剩余字节数。值越小说明内存压力越大。
+ */
+size_t xPortGetMinimumEverFreeHeapSize( void );
+
+/**
+ * @brief 延迟清零（configHEAP_CLEAR_MEMORY_ON_FREE == 4）下的空闲钩子：
+ * 清零待清零队列中的块并把它们并入空闲链表。清零时不持有堆锁。
+ * @param xMaxBytes 本次最多清零的字节数（以块为单位，最后一块可能超出）
+ * @return size_t 队列中仍待清零的字节数
+ */
+size_t xPortHeapClearPending( size_t xMaxBytes );
+
+/**
+ * @brief 宿主机模式（configHEAP_HOSTED == 1）下的 fork 保护。
+ * 供 pthread_atfork 注册：prepare 阶段持有堆锁，父子进程中各自释放，
+ * 保证子进程不会继承一把被其他线程持有的锁。
+ */
+void vPortHeapForkPrepare( void );
+void vPortHeapForkRelease( void );
+
+/**
+ * @brief 宿主机模式下提前初始化堆池：预留地址空间并提交初始部分，按配置使用大页、mlock 锁定或预取。
+ * 实时线程启动前调用，之后的 pvPortMalloc 不再触发初始化；初始堆池足够大时也不会扩展，不会再发生缺页。
+ * configHEAP_HOSTED_PREFAULT_THREADS 大于 1 时在释放堆锁后用多个线程并行预取。堆已初始化时什么也不做。
+ */
+void vPortHeapInitialise( void );
+
+/**
+ * @brief 宿主机模式下堆池的提交与驻留统计
+ */
+typedef struct xHEAP_HOSTED_STATS
+{
+    size_t xCommittedBytes; /**< 已提交（可读写）的字节数 */
+    size_t xHugePageBytes;  /**< 其中以 MAP_HUGETLB 大页提交的字节数 */
+    size_t xLockedBytes;    /**< 其中已被 mlock 锁定的字节数 */
+    size_t xLockFailures;   /**< mlock 失败的次数（通常是超出了 RLIMIT_MEMLOCK） */
+} HeapHostedStats_t;
+
+/**
+ * @brief 获取宿主机模式下堆池的提交与驻留统计。
+ */
+void vPortGetHeapHostedStats( HeapHostedStats_t * pxStats );
+
+/* --- 碎片化指标（configHEAP_FRAGMENTATION_METRICS == 1 时可用） --- */
+
+/* 直方图桶数：第 i 个桶统计大小在 [2^i, 2^(i+1)) 之间的空闲块 */
+#define heapFRAGMENTATION_HISTOGRAM_BUCKETS    ( sizeof( size_t ) * 8 )
+
+typedef struct xHEAP_FRAGMENTATION_STATS
+{
+    size_t xFreeBlockHistogram[ heapFRAGMENTATION_HISTOGRAM_BUCKETS ]; /**< 按 log2(块大小) 统计的空闲块个数 */
+    size_t xNumberOfFreeBlocks;            /**< 空闲块总数 */
+    size_t xSizeOfLargestFreeBlockInBytes; /**< 最大空闲块的大小（含 Header），即单次能分配的上限 */
+    size_t xAvailableHeapSpaceInBytes;     /**< 总空闲字节数，与 xPortGetFreeHeapSize 相同 */
+    size_t xFragmentationPerMille;         /**< 外部碎片率：1000 * (1 - 最大空闲块 / 总空闲字节) */
+    size_t xTotalSearchSteps;              /**< 启动以来分配查找经过的空闲块总数 */
+    size_t xNumberOfSearches;              /**< 启动以来分配查找的次数 */
+    size_t xAverageSearchLength;           /**< 平均每次分配经过的空闲块数（取整） */
+} HeapFragmentationStats_t;
+
+/**
+ * @brief 读取碎片化指标。计数在空闲链表变化时增量维护，读取开销与空闲块数无关
+ * （只有最大空闲块刚被分配或合并掉时，才会重新遍历一次空闲链表）。
+ * 监控端可用两次读取的 xTotalSearchSteps / xNumberOfSearches 差值计算区间内的平均查找长度。
+ */
+void vPortGetHeapFragmentationStats( HeapFragmentationStats_t * pxStats );
+
+/* --- 可重定位句柄与堆整理（configHEAP_RELOCATABLE_HANDLES == 1 时可用） --- */
+
+/**
+ * @brief 可重定位对象的句柄，0 表示无效句柄。
+ */
+typedef size_t HeapHandle_t;
+
+/**
+ * @brief 分配一个可重定位对象。对象只能通过句柄访问，使用前必须先钉住。
+ * @return HeapHandle_t 句柄；堆空间或句柄表不足时返回 0
+ */
+HeapHandle_t xPortHandleAlloc( size_t xWantedSize );
+
+/**
+ * @brief 释放可重定位对象。释放时对象不能处于钉住状态。
+ */
+void vPortHandleFree( HeapHandle_t xHandle );
+
+/**
+ * @brief 钉住对象并返回其当前地址。钉住期间整理器不会移动它，可嵌套调用。
+ * @return void* 对象地址，仅在对应的 vPortHandleUnpin 之前有效；句柄无效时返回 NULL
+ */
+void * pvPortHandlePin( HeapHandle_t xHandle );
+
+/**
+ * @brief 解除一次钉住。解除后之前得到的地址随时可能失效。
+ */
+void vPortHandleUnpin( HeapHandle_t xHandle );
+
+/**
+ * @brief 增量整理堆：把未钉住的可重定位对象移向低地址，合并出大的空闲块。
+ * 每次调用最多处理 xMaxSteps 个空闲块（每步至多一次 memmove），适合在空闲任务中反复调用。
+ * 被钉住的对象和普通 pvPortMalloc 分配的对象原地不动，整理会越过它们继续向后。
+ * @return int 1 表示还有可整理的空间，0 表示已整理到最高地址的空闲块
+ */
+int xPortHeapCompactStep( size_t xMaxSteps );
+
+/* --- 堆快照（configHEAP_SNAPSHOT == 1 时可用） --- */
+
+/**
+ * @brief 把整个堆（堆池内容、空闲链表头尾、统计计数、句柄表）保存到文件。
+ * 链接以相对 ucHeap 的偏移形式写出。保存期间持有堆锁。
+ * @param pcPath 文件路径
+ * @param pvRoot 应用状态的根对象（堆内指针，可为 NULL），恢复时原样返回
+ * @return int 成功返回 1，失败返回 0
+ */
+int xPortHeapSnapshotSave( const char * pcPath, void * pvRoot );
+
+/**
+ * @brief 从快照文件恢复堆，必须在第一次分配之前调用。
+ * 静态堆池直接整体读入；宿主机模式下在原地址以私有映射方式映射文件，页面按需读入。
+ * 堆内对象之间的指针保持有效，因此要求恢复地址与保存时相同，否则恢复失败。
+ * @return void* 保存时传入的根对象；恢复失败（或根对象为 NULL）时返回 NULL
+ */
+void * pvPortHeapSnapshotRestore( const char * pcPath );
+
+/* --- 堆完整性检查（configHEAP_INTEGRITY_CHECK == 1 时可用） --- */
+
+/**
+ * @brief 完整检查一遍堆：块大小、已分配位与空闲链表的一致性、链表地址顺序、相邻空闲块已合并、
+ * 空闲字节数与计数一致。发现问题时调用 configHEAP_CORRUPTION_HOOK。
+ * 检查期间持有堆锁，耗时与块总数成正比。
+ * @return int 堆完好返回 1，发现损坏返回 0
+ */
+int xPortHeapCheck( void );
+
+/**
+ * @brief 增量检查：从上次停下的位置继续，最多检查 xMaxBlocks 个块。
+ * 两次调用之间若游标之前的块结构发生变化，会自动从堆头重新开始，所以在分配频繁时
+ * xMaxBlocks 应取得足够大，使一轮检查能够完成（可用 xPortGetHeapCheckPasses 观察）。
+ * @return int 本次检查的块都正常返回 1，发现损坏返回 0
+ */
+int xPortHeapCheckStep( size_t xMaxBlocks );
+
+/**
+ * @brief 获取已完成的完整检查轮数（xPortHeapCheck 与 xPortHeapCheckStep 共用）。
+ */
+size_t xPortGetHeapCheckPasses( void );
+
+/* --- 抽样守护页检测（configHEAP_GUARDED_SAMPLING == 1 时可用） --- */
+
+/**
+ * @brief 安装 SIGSEGV 处理函数：访问守护页或已释放对象时，先向 stderr 输出
+ * 越界 / 释放后使用的报告（含对象地址与大小），再交回原来的处理方式。
+ * 重复释放与非法释放不依赖此函数，总是在释放时报告并终止进程。
+ * @return int 成功返回 1，失败返回 0
+ */
+int xPortGuardedInstallSignalHandler( void );
+
+/* --- 采样式分配剖析（configHEAP_SAMPLING_PROFILER == 1 时可用） --- */
+
+/**
+ * @brief 修改平均采样间隔。
+ * 各线程在下一次抽取采样点时生效。
+ * @param xBytes 平均每分配多少字节采样一次；0 表示暂停采样（已有样本保留）
+ */
+void vPortHeapProfilerSetInterval( size_t xBytes );
+
+/**
+ * @brief 把按调用点汇总的样本写成 gperftools heap_v2 文本格式，附带 /proc/self/maps，
+ * 可直接用 pprof 查看（例如 pprof --text ./app heap.prof）。
+ * @param pcPath 输出文件路径
+ * @param xPeak 0: 输出当前存活字节数；1: 输出各调用点存活字节数的历史峰值
+ * @return int 成功返回 1，失败返回 0
+ */
+int xPortHeapProfileDump( const char * pcPath, int xPeak );
+
+/* --- 操作耗时直方图（configHEAP_LATENCY_HISTOGRAMS == 1 时可用） --- */
+
+/* 每个 2 的幂区间细分的子桶位数：子桶个数为 2^B，相对误差不超过 1/2^B */
+#define heapLATENCY_SUB_BUCKET_BITS    3
+
+/* 桶数：覆盖完整的 64 位取值范围 */
+#define heapLATENCY_BUCKETS            ( ( 64 - heapLATENCY_SUB_BUCKET_BITS + 1 ) << heapLATENCY_SUB_BUCKET_BITS )
+
+typedef struct xHEAP_LATENCY_STATS
+{
+    size_t xMallocCycles[ heapLATENCY_BUCKETS ]; /**< pvPortMalloc 耗时（周期，含等锁时间）的分布 */
+    size_t xMallocNodes[ heapLATENCY_BUCKETS ];  /**< pvPortMalloc 遍历空闲链表节点数的分布 */
+    size_t xFreeCycles[ heapLATENCY_BUCKETS ];   /**< vPortFree 耗时（周期，含等锁时间）的分布 */
+    size_t xFreeNodes[ heapLATENCY_BUCKETS ];    /**< vPortFree 遍历空闲链表节点数的分布 */
+    size_t xNumberOfMallocs;                     /**< 计入统计的 pvPortMalloc 次数 */
+    size_t xNumberOfFrees;                       /**< 计入统计的 vPortFree 次数（不含释放 NULL） */
+    size_t xNumberOfThreads;                     /**< 参与合并的线程记录数（含已退出线程留下的） */
+} HeapLatencyStats_t;
+
+/**
+ * @brief 合并所有线程的直方图。不取锁，可在任意时刻调用，结果是近似的瞬时值。
+ * 周期单位取决于平台：x86 为 TSC 周期，AArch64 为虚拟计数器的计数，其他平台为纳秒。
+ */
+void vPortGetHeapLatencyStats( HeapLatencyStats_t * pxStats );
+
+/**
+ * @brief 返回第 xBucket 个桶所代表取值区间的下界（堆锁竞争统计的直方图同样适用）。
+ */
+uint64_t uxPortHeapLatencyBucketValue( size_t xBucket );
+
+/**
+ * @brief 计算直方图的分位数。
+ * @param pxHistogram HeapLatencyStats_t 中的任意一个直方图
+ * @param xPerMille 千分位，例如 500 为中位数，999 为 p99.9
+ * @return uint64_t 分位数所在桶的下界；直方图为空时返回 0
+ */
+uint64_t uxPortHeapLatencyPercentile( const size_t pxHistogram[ heapLATENCY_BUCKETS ], size_t xPerMille );
+
+/* --- 堆锁竞争统计（configHEAP_LOCK_STATS == 1 时可用） --- */
+
+/**
+ * @brief 获取堆锁的调用路径
+ */
+typedef enum
+{
+    eHeapLockPathMalloc = 0, /**< 分配：pvPortMalloc 及其变体、pvPortRealloc、句柄分配 */
+    eHeapLockPathFree,       /**< 释放：vPortFree 及其变体、句柄释放 */
+    eHeapLockPathStats,      /**< 统计查询：vPortGet*Stats */
+    eHeapLockPathOther,      /**< 其他：整理、完整性检查、快照、回调注册、fork 保护等 */
+    eHeapLockPathCount
+} HeapLockPath_t;
+
+/**
+ * @brief 单个调用路径的堆锁统计。时间单位与 HeapLatencyStats_t 相同（周期计数器的计数）。
+ */
+typedef struct xHEAP_LOCK_PATH_STATS
+{
+    size_t xAcquisitions;                          /**< 获取次数 */
+    size_t xContended;                             /**< 其中 trylock 失败、需要阻塞等待的次数 */
+    uint64_t uxWaitCycles;                         /**< 等锁时间总和 */
+    uint64_t uxHoldCycles;                         /**< 持锁时间总和 */
+    size_t xWaitHistogram[ heapLATENCY_BUCKETS ];  /**< 每次获取的等锁时间分布（无竞争记为 0） */
+    size_t xHoldHistogram[ heapLATENCY_BUCKETS ];  /**< 每次持锁时间的分布 */
+} HeapLockPathStats_t;
+
+typedef struct xHEAP_LOCK_STATS
+{
+    HeapLockPathStats_t xPaths[ eHeapLockPathCount ]; /**< 按 HeapLockPath_t 索引 */
+} HeapLockStats_t;
+
+/**
+ * @brief 获取堆锁统计的快照。在堆锁内整体复制，各路径的计数彼此一致；
+ * 直方图可以直接传给 uxPortHeapLatencyPercentile 计算分位数。
+ */
+void vPortGetHeapLockStats( HeapLockStats_t * pxStats );
+
+/**
+ * @brief 清零堆锁统计，例如在基准测试的两个阶段之间调用。
+ */
+void vPortResetHeapLockStats( void );
+
+/* --- 按所有者的内存配额（configHEAP_OWNER_QUOTAS == 1 时可用） --- */
+
+/**
+ * @brief 单个所有者的内存使用统计
+ */
+typedef struct xHEAP_OWNER_STATS
+{
+    size_t xLiveBytes;          /**< 当前存活块的字节数（含块头） */
+    size_t xPeakBytes;          /**< 历史最高存活字节数 */
+    size_t xSoftLimit;          /**< 软上限，0 表示不限 */
+    size_t xHardLimit;          /**< 硬上限，0 表示不限 */
+    size_t xSoftLimitCrossings; /**< 存活字节数越过软上限的次数 */
+    size_t xHardLimitFailures;  /**< 因硬上限被拒绝的分配次数 */
+} HeapOwnerStats_t;
+
+/**
+ * @brief 设置当前分配者的所有者编号（宿主机模式下只对调用线程生效）。
+ * 之后的分配都记在该所有者名下；释放时按块头中的编号归还，与由谁释放无关。
+ * @param uxOwner 所有者编号，小于 2 的 configHEAP_OWNER_BITS 次方；0 为默认所有者
+ */
+void vPortHeapSetCurrentOwner( size_t uxOwner );
+
+/**
+ * @brief 设置所有者的配额。
+ * @param xSoftLimit 软上限（字节），越过时调用 configHEAP_OWNER_SOFT_LIMIT_HOOK，分配照常进行；0 表示不限
+ * @param xHardLimit 硬上限（字节），会使存活字节数超过它的分配返回 NULL；0 表示不限
+ */
+void vPortHeapSetOwnerLimits( size_t uxOwner, size_t xSoftLimit, size_t xHardLimit );
+
+/**
+ * @brief 获取所有者的内存使用统计。
+ */
+void vPortGetHeapOwnerStats( size_t uxOwner, HeapOwnerStats_t * pxStats );
+
+/* --- 低内存回收回调（configHEAP_RECLAIM_CALLBACKS == 1 时可用） --- */
+
+/**
+ * @brief 回收回调：尽量释放至少 xBytesNeeded 字节（例如清理缓存），在堆锁之外调用。
+ * 可能被多个线程同时调用；其中的分配失败不会再次触发回收。
+ * @param xBytesNeeded 希望释放的字节数
+ * @param pvContext 注册时传入的参数
+ * @return size_t 实际释放的字节数（估计值即可），0 表示没有可释放的内容
+ */
+typedef size_t ( * HeapReclaimCallback_t )( size_t xBytesNeeded, void * pvContext );
+
+/**
+ * @brief 注册回收回调。
+ * 剩余空间跌破 xWatermark 时调用一次（回升到它之上后才会再次触发）；
+ * pvPortMalloc / pvPortMallocAligned 分配失败时，所有回调按优先级依次调用，直到释放出足够的空间，然后重试一次。
+ * @param uxPriority 优先级，越小越先调用，同优先级按注册顺序
+ * @param xWatermark 水位线（字节），0 表示只在分配失败时调用
+ * @return int 成功返回 1；已达到 configHEAP_RECLAIM_MAX_CALLBACKS 个时返回 0
+ */
+int xPortHeapRegisterReclaim( HeapReclaimCallback_t pxCallback, void * pvContext, size_t uxPriority, size_t xWatermark );
+
+/**
+ * @brief 注销回收回调（按回调与参数匹配）。返回时可能仍有一次已开始的调用正在进行。
+ */
+void vPortHeapUnregisterReclaim( HeapReclaimCallback_t pxCallback, void * pvContext );
+
+/* --- 紧急储备区（configHEAP_EMERGENCY_RESERVE_SIZE > 0 时可用） --- */
+
+/**
+ * @brief 紧急储备区的使用统计
+ */
+typedef struct xHEAP_RESERVE_STATS
+{
+    size_t xReserveSize;          /**< 储备区可分配的总字节数 */
+    size_t xFreeBytes;            /**< 当前剩余字节数 */
+    size_t xMinimumEverFreeBytes; /**< 历史最低剩余字节数 */
+    size_t xAllocations;          /**< 由储备区满足的分配次数（主堆失败后的命中） */
+    size_t xFailures;             /**< 主堆与储备区都无法满足的分配次数 */
+} HeapReserveStats_t;
+
+/**
+ * @brief 关键分配：先按 pvPortMalloc 从主堆分配，失败时再从紧急储备区分配。
+ * @return void* 指向分配内存的指针，可用 vPortFree 释放；都失败时返回 NULL
+ */
+void * pvPortMallocCritical( size_t xWantedSize );
+
+/**
+ * @brief 获取紧急储备区的使用统计。
+ */
+void vPortGetHeapReserveStats( HeapReserveStats_t * pxStats );
+
+/* --- 大对象直接映射（configHEAP_LARGE_OBJECT_THRESHOLD > 0 时可用） --- */
+
+/**
+ * @brief 大对象映射统计
+ */
+typedef struct xHEAP_LARGE_OBJECT_STATS
+{
+    size_t xMappedBytes;     /**< 当前所有大对象映射的总字节数（按页取整，含块头） */
+    size_t xPeakMappedBytes; /**< xMappedBytes 的历史最大值 */
+    size_t xAllocations;     /**< 直接映射的分配次数 */
+    size_t xFrees;           /**< 解除映射的次数 */
+    size_t xRemaps;          /**< pvPortRealloc 用 mremap 调整大小的次数 */
+} HeapLargeObjectStats_t;
+
+/**
+ * @brief 获取大对象映射统计。
+ */
+void vPortGetHeapLargeObjectStats( HeapLargeObjectStats_t * pxStats );
+
+/* --- 跨进程共享内存堆（heap_shm.c） --- */
+
+/**
+ * @brief 共享内存堆句柄，即本进程中该共享内存段的映射地址。
+ */
+typedef struct xSHARED_HEAP SharedHeap_t;
+
+/**
+ * @brief 创建或打开一个位于 POSIX 共享内存段中的堆。
+ * 第一个打开的进程创建并初始化段，其余进程等待初始化完成后直接使用。
+ * 等待超过 configSHM_OPEN_TIMEOUT_MS（创建者失败或崩溃、同名段不是本模块创建的）时返回 NULL；
+ * 创建者自身失败时会删除它创建的段。
+ * @param pcName 段名（以 '/' 开头，见 shm_open）
+ * @param xSegmentSize 段大小（创建时生效；打开已有段时以创建者的大小为准）
+ * @return SharedHeap_t* 句柄；失败返回 NULL
+ */
+SharedHeap_t * pxPortSharedHeapOpen( const char * pcName, size_t xSegmentSize );
+
+/**
+ * @brief 解除本进程对段的映射。段本身在 xPortSharedHeapUnlink 之前一直存在。
+ */
+void vPortSharedHeapClose( SharedHeap_t * pxHeap );
+
+/**
+ * @brief 删除共享内存段的名字（已映射的进程不受影响）。
+ * @return int 成功返回 1，失败返回 0
+ */
+int xPortSharedHeapUnlink( const char * pcName );
+
+/**
+ * @brief 从共享堆分配内存。
+ * 持锁进程崩溃时由下一个加锁者校验空闲链表；链表已损坏时堆被标记为不可恢复，之后的分配都返回 0。
+ * @return size_t 用户区相对段起始处的偏移，可直接传给其他进程；失败返回 0
+ */
+size_t xPortSharedMalloc( SharedHeap_t * pxHeap, size_t xWantedSize );
+
+/**
+ * @brief 释放共享堆中的内存，可以由任意一个已打开该段的进程调用。
+ * 堆已不可恢复时不做任何事。
+ * @param xOffset xPortSharedMalloc 返回的偏移
+ */
+void vPortSharedFree( SharedHeap_t * pxHeap, size_t xOffset );
+
+/**
+ * @brief 把偏移换算成本进程中的地址。
+ * @return void* 本地地址；xOffset 为 0 时返回 NULL
+ */
+void * pvPortSharedHeapPointer( SharedHeap_t * pxHeap, size_t xOffset );
+
+/**
+ * @brief 把本进程中的地址换算成偏移。
+ * @return size_t 偏移；pv 为 NULL 时返回 0
+ */
+size_t xPortSharedHeapOffset( SharedHeap_t * pxHeap, const void * pv );
+
+/**
+ * @brief 获取共享堆的剩余空闲字节数与历史最低空闲字节数。
+ */
+size_t xPortSharedHeapGetFreeSize( SharedHeap_t * pxHeap );
+size_t xPortSharedHeapGetMinimumEverFreeSize( SharedHeap_t * pxHeap );
+
+/* --- Arena（区域分配器） --- */
+
+/**
+ * @brief Arena 句柄。内部结构对外不可见，由 pxPortArenaCreate 创建。
+ */
+typedef struct xHEAP_ARENA HeapArena_t;
+
+/**
+ * @brief Arena 检查点。由 xPortArenaMark 记录，交给 vPortArenaRewind 回滚。
+ */
+typedef struct xHEAP_ARENA_MARK
+{
+    void * pvChunk;  /**< 记录时正在使用的内存块 */
+    size_t xOffset;  /**< 记录时该块内已使用的字节数 */
+} HeapArenaMark_t;
+
+/**
+ * @brief 创建一个 Arena：从堆中一次性申请一大块内存，之后的分配只移动指针。
+ * @param xChunkSize 每个内存块的可用字节数，空间不足时按此大小追加新块
+ * @return HeapArena_t* Arena 句柄；若堆空间不足则返回 NULL
+ */
+HeapArena_t * pxPortArenaCreate( size_t xChunkSize );
+
+/**
+ * @brief 从 Arena 中分配内存（指针递增，O(1)）。
+ * 返回的内存不能单独用 vPortFree 释放，只能通过回滚或销毁 Arena 整体回收。
+ * Arena 本身不加锁，同一个 Arena 不应被多个线程同时使用。
+ * @param pxArena Arena 句柄
+ * @param xWantedSize 期望分配的字节数
+ * @return void* 按 portBYTE_ALIGNMENT 对齐的指针；失败返回 NULL
+ */
+void * pvPortArenaAlloc( HeapArena_t * pxArena, size_t xWantedSize );
+
+/**
+ * @brief 记录 Arena 当前的分配位置。
+ * @return HeapArenaMark_t 检查点，可多次嵌套记录
+ */
+HeapArenaMark_t xPortArenaMark( const HeapArena_t * pxArena );
+
+/**
+ * @brief 回滚到检查点，检查点之后的所有分配一次性作废（O(1)）。
+ * 之后追加的内存块不会归还给堆，而是保留在链上供后续分配复用。
+ */
+void vPortArenaRewind( HeapArena_t * pxArena, HeapArenaMark_t xMark );
+
+/**
+ * @brief 回滚到 Arena 创建时的状态，等价于回滚到最初的检查点。
+ */
+void vPortArenaReset( HeapArena_t * pxArena );
+
+/**
+ * @brief 销毁 Arena，把它占用的所有内存块归还给堆。
+ */
+void vPortArenaDestroy( HeapArena_t * pxArena );
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* HEAP_H */
\ No newline at end of file
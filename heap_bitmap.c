@@ -0,0 +1,538 @@
+/*
+ * 基于 heap.c 接口的粒度位图堆
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * 面向大量小对象的场景：heap.c 每个块都带一个 16 字节的块头，往往比对象本身还大。
+ * 本实现把堆池切成固定大小的粒度（granule），不再使用块头，只用两张位图记录状态：
+ * - 分配位图：粒度是否已被占用；
+ * - 起始位图：粒度是否是某个已分配块的第一个粒度。
+ * 每个对象的元数据因此只有每粒度 2 位。分配是在分配位图中按位扫描一段足够长的连续空闲粒度（首次适配），
+ * 释放时从起始粒度向后找到块尾（下一个起始位或空闲粒度）后清位；vPortFreeSized 可以直接按大小计算块尾。
+ * 相邻的已分配块靠起始位区分，空闲粒度天然连成一片，不需要显式合并。
+ *
+ * 提供与 heap.c 相同的基本接口（pvPortMalloc / vPortFree / pvPortCalloc / pvPortRealloc /
+ * pvPortMallocAligned / vPortFreeSized / xPortGetAllocatedSize / 空闲量统计），链接时与 heap.c 二选一。
+ *
+ * 构建：gcc -O2 -c heap_bitmap.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "heap.h"
+
+/**
+ * @brief 堆内存的总大小（字节），与 heap.c 相同。
+ */
+#define configTOTAL_HEAP_SIZE               ( ( size_t ) 40960 )
+
+/**
+ * @brief 粒度大小（字节）：分配的最小单位，也是返回指针的对齐保证。
+ * 必须是 2 的幂且不小于 portBYTE_ALIGNMENT。每个对象最多浪费一个粒度减一字节。
+ */
+#ifndef configHEAP_GRANULE_SIZE
+    #define configHEAP_GRANULE_SIZE         16
+#endif
+
+/**
+ * @brief 是否用 pthread 互斥锁保护位图。
+ * 0: HEAP_LOCK 为空，在多线程/抢占式环境下需在下方填入关中断或获取互斥锁的代码（嵌入式默认）。
+ * 1: 宿主机多线程环境，使用 pthread 互斥锁（链接时加 -lpthread）。
+ */
+#ifndef configHEAP_BITMAP_PTHREAD_LOCK
+    #define configHEAP_BITMAP_PTHREAD_LOCK  0
+#endif
+
+/**
+ * @brief vPortFreeSized 是否用位图校验调用者给出的大小，默认值与 heap.c 相同。
+ * 1: 校验起始位与块尾位置，不一致时触发 configASSERT。
+ * 0: 完全信任调用者给出的大小（定义了 NDEBUG 的发布版默认）。
+ */
+#ifndef configHEAP_CHECK_SIZED_FREE
+    #ifdef NDEBUG
+        #define configHEAP_CHECK_SIZED_FREE     0
+    #else
+        #define configHEAP_CHECK_SIZED_FREE     1
+    #endif
+#endif
+
+/* 与 heap.c 相同的对齐要求；粒度大小不能小于它 */
+#ifndef portBYTE_ALIGNMENT
+    #define portBYTE_ALIGNMENT              8
+#endif
+
+#if ( ( configHEAP_GRANULE_SIZE & ( configHEAP_GRANULE_SIZE - 1 ) ) != 0 ) || ( configHEAP_GRANULE_SIZE < portBYTE_ALIGNMENT )
+    #error "configHEAP_GRANULE_SIZE must be a power of two no smaller than portBYTE_ALIGNMENT"
+#endif
+
+#ifndef NDEBUG
+    #define configASSERT( x )               if( ( x ) == 0 ) { abort(); }
+#else
+    #define configASSERT( x )               if( ( x ) == 0 ) { for( ;; ); }
+#endif
+
+/* 线程安全锁定机制：在多线程/抢占式环境下，需在此填入关中断或获取互斥锁的代码 */
+#if ( configHEAP_BITMAP_PTHREAD_LOCK == 1 )
+    #include <pthread.h>
+
+    static pthread_mutex_t xHeapMutex = PTHREAD_MUTEX_INITIALIZER;
+
+    #define HEAP_LOCK()     pthread_mutex_lock( &xHeapMutex )
+    #define HEAP_UNLOCK()   pthread_mutex_unlock( &xHeapMutex )
+#else
+    #define HEAP_LOCK()
+    #define HEAP_UNLOCK()
+#endif
+
+/* 位图按 64 位字存放，每个字覆盖 64 个粒度 */
+#define heapBITS_PER_WORD                   64U
+#define heapGRANULE_COUNT                   ( configTOTAL_HEAP_SIZE / configHEAP_GRANULE_SIZE )
+#define heapMAP_WORDS                       ( ( heapGRANULE_COUNT + heapBITS_PER_WORD - 1U ) / heapBITS_PER_WORD )
+
+#define heapBIT( xGranule )                 ( ( uint64_t ) 1 << ( ( xGranule ) % heapBITS_PER_WORD ) )
+#define heapTEST( puxMap, xGranule )        ( ( ( puxMap )[ ( xGranule ) / heapBITS_PER_WORD ] & heapBIT( xGranule ) ) != 0U )
+
+/* 粒度编号与地址之间的换算 */
+#define heapGRANULE_ADDRESS( xGranule )     ( ( void * ) ( pucPool + ( ( xGranule ) * configHEAP_GRANULE_SIZE ) ) )
+#define heapADDRESS_GRANULE( pv )           ( ( size_t ) ( ( ( const uint8_t * ) ( pv ) ) - pucPool ) / configHEAP_GRANULE_SIZE )
+
+/* --- 变量定义 --- */
+
+/* 堆池本身，起始地址在初始化时向上对齐到粒度大小 */
+static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+
+static uint64_t uxAllocatedMap[ heapMAP_WORDS ]; /* 1: 粒度已被占用 */
+static uint64_t uxStartMap[ heapMAP_WORDS ];     /* 1: 粒度是已分配块的第一个粒度 */
+
+static uint8_t * pucPool = NULL;         /* 对齐后的堆池起始地址，NULL 表示尚未初始化 */
+static size_t xGranuleCount = 0U;        /* 对齐后可用的粒度数 */
+static size_t xLowestFreeGranule = 0U;   /* 不大于最低空闲粒度的编号，作为查找起点 */
+
+static size_t xFreeBytesRemaining = 0U;              /* 当前可用总字节数 */
+static size_t xMinimumEverFreeBytesRemaining = 0U;   /* 历史最低可用字节数（水位线） */
+static size_t xNumberOfSuccessfulAllocations = 0U;   /* 成功分配次数计数 */
+static size_t xNumberOfSuccessfulFrees = 0U;         /* 成功释放次数计数 */
+
+/* --- 内部函数 --- */
+
+/**
+ * @brief 初始化堆池：起始地址对齐到粒度大小，两张位图清零。
+ */
+static void prvHeapInit( void )
+{
+    uintptr_t uxStart = ( ( uintptr_t ) ucHeap + ( configHEAP_GRANULE_SIZE - 1U ) ) & ~( ( uintptr_t ) configHEAP_GRANULE_SIZE - 1U );
+
+    pucPool = ( uint8_t * ) uxStart;
+    xGranuleCount = ( configTOTAL_HEAP_SIZE - ( size_t ) ( uxStart - ( uintptr_t ) ucHeap ) ) / configHEAP_GRANULE_SIZE;
+    xLowestFreeGranule = 0U;
+
+    ( void ) memset( uxAllocatedMap, 0, sizeof( uxAllocatedMap ) );
+    ( void ) memset( uxStartMap, 0, sizeof( uxStartMap ) );
+
+    xFreeBytesRemaining = xGranuleCount * configHEAP_GRANULE_SIZE;
+    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+}
+
+/**
+ * @brief 把字节数换算成粒度数（向上取整）。
+ * @return size_t 粒度数；xWantedSize 为 0 或超出堆池时返回 0
+ */
+static size_t prvGranulesFor( size_t xWantedSize )
+{
+    size_t xGranules = ( xWantedSize / configHEAP_GRANULE_SIZE ) + ( ( ( xWantedSize % configHEAP_GRANULE_SIZE ) != 0U ) ? 1U : 0U );
+
+    return ( xGranules <= heapGRANULE_COUNT ) ? xGranules : 0U;
+}
+
+/**
+ * @brief 返回 xGranule 及之后第一个空闲粒度的编号，没有时返回 xGranuleCount。
+ */
+static size_t prvNextFree( size_t xGranule )
+{
+    size_t xWord = xGranule / heapBITS_PER_WORD;
+    uint64_t uxFree;
+
+    if( xGranule >= xGranuleCount )
+    {
+        return xGranuleCount;
+    }
+
+    /* 屏蔽掉起点之前的位 */
+    uxFree = ~uxAllocatedMap[ xWord ] & ~( heapBIT( xGranule ) - 1U );
+
+    while( uxFree == 0U )
+    {
+        if( ++xWord >= heapMAP_WORDS )
+        {
+            return xGranuleCount;
+        }
+
+        uxFree = ~uxAllocatedMap[ xWord ];
+    }
+
+    xGranule = ( xWord * heapBITS_PER_WORD ) + ( size_t ) __builtin_ctzll( uxFree );
+
+    return ( xGranule < xGranuleCount ) ? xGranule : xGranuleCount;
+}
+
+/**
+ * @brief 在 [xGranule, xLimit) 中查找第一个满足条件的粒度：已被占用，
+ * 或者（xStopAtStart 非 0 时）是某个块的起始粒度。没有时返回 xLimit。
+ * 用于确认一段粒度是否全部空闲，以及从块的第二个粒度开始寻找块尾。
+ */
+static size_t prvNextBoundary( size_t xGranule, size_t xLimit, int xStopAtStart )
+{
+    size_t xWord = xGranule / heapBITS_PER_WORD;
+    uint64_t uxHit;
+
+    if( xGranule >= xLimit )
+    {
+        return xLimit;
+    }
+
+    /* 块尾条件是"空闲或另一个块的起点"；空闲条件的取反是"已被占用" */
+    uxHit = ( xStopAtStart != 0 ) ? ( ~uxAllocatedMap[ xWord ] | uxStartMap[ xWord ] ) : uxAllocatedMap[ xWord ];
+    uxHit &= ~( heapBIT( xGranule ) - 1U );
+
+    while( uxHit == 0U )
+    {
+        if( ( ++xWord * heapBITS_PER_WORD ) >= xLimit )
+        {
+            return xLimit;
+        }
+
+        uxHit = ( xStopAtStart != 0 ) ? ( ~uxAllocatedMap[ xWord ] | uxStartMap[ xWord ] ) : uxAllocatedMap[ xWord ];
+    }
+
+    xGranule = ( xWord * heapBITS_PER_WORD ) + ( size_t ) __builtin_ctzll( uxHit );
+
+    return ( xGranule < xLimit ) ? xGranule : xLimit;
+}
+
+/**
+ * @brief 已分配块 [xGranule, ...) 的粒度数：从第二个粒度起找到第一个空闲或起始粒度。
+ */
+static size_t prvBlockGranules( size_t xGranule )
+{
+    return prvNextBoundary( xGranule + 1U, xGranuleCount, 1 ) - xGranule;
+}
+
+/**
+ * @brief 把位图 puxMap 中 [xGranule, xGranule + xCount) 的位全部置 1（xSet 非 0）或清 0。
+ */
+static void prvMarkRange( uint64_t * puxMap, size_t xGranule, size_t xCount, int xSet )
+{
+    size_t xWord;
+    size_t xBits;
+    uint64_t uxMask;
+
+    while( xCount > 0U )
+    {
+        xWord = xGranule / heapBITS_PER_WORD;
+        xBits = heapBITS_PER_WORD - ( xGranule % heapBITS_PER_WORD );
+        xBits = ( xBits < xCount ) ? xBits : xCount;
+        uxMask = ( ( xBits == heapBITS_PER_WORD ) ? ~( uint64_t ) 0 : ( heapBIT( xBits ) - 1U ) ) << ( xGranule % heapBITS_PER_WORD );
+
+        if( xSet != 0 )
+        {
+            puxMap[ xWord ] |= uxMask;
+        }
+        else
+        {
+            puxMap[ xWord ] &= ~uxMask;
+        }
+
+        xGranule += xBits;
+        xCount -= xBits;
+    }
+}
+
+/**
+ * @brief 首次适配：查找 xCount 个连续空闲粒度，且第一个粒度的地址按 xAlignment 对齐。
+ * 调用者必须持有 HEAP_LOCK。
+ * @return size_t 起始粒度编号；找不到时返回 xGranuleCount
+ */
+static size_t prvFindFreeRun( size_t xCount, size_t xAlignment )
+{
+    size_t xGranule = xLowestFreeGranule;
+    size_t xEnd;
+    uintptr_t uxAddress;
+
+    for( ; ; )
+    {
+        xGranule = prvNextFree( xGranule );
+
+        if( xAlignment > configHEAP_GRANULE_SIZE )
+        {
+            /* 向后跳到第一个地址满足对齐要求的粒度 */
+            uxAddress = ( ( uintptr_t ) heapGRANULE_ADDRESS( xGranule ) + ( xAlignment - 1U ) ) & ~( ( uintptr_t ) xAlignment - 1U );
+            xGranule = heapADDRESS_GRANULE( uxAddress );
+        }
+
+        if( ( xGranule >= xGranuleCount ) || ( xCount > ( xGranuleCount - xGranule ) ) )
+        {
+            return xGranuleCount;
+        }
+
+        /* 这一段中第一个已占用的粒度；没有则整段都空闲 */
+        xEnd = prvNextBoundary( xGranule, xGranule + xCount, 0 );
+
+        if( xEnd == ( xGranule + xCount ) )
+        {
+            return xGranule;
+        }
+
+        xGranule = xEnd;
+    }
+}
+
+/**
+ * @brief 把 [xGranule, xGranule + xCount) 标记为一个已分配块并更新统计。调用者必须持有 HEAP_LOCK。
+ */
+static void * prvClaimRun( size_t xGranule, size_t xCount )
+{
+    prvMarkRange( uxAllocatedMap, xGranule, xCount, 1 );
+    uxStartMap[ xGranule / heapBITS_PER_WORD ] |= heapBIT( xGranule );
+
+    /* 查找起点之前的粒度都已被占用；新块恰好从起点开始时起点可以跨过它 */
+    if( xGranule == xLowestFreeGranule )
+    {
+        xLowestFreeGranule = xGranule + xCount;
+    }
+
+    xFreeBytesRemaining -= xCount * configHEAP_GRANULE_SIZE;
+
+    if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+    {
+        xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+    }
+
+    xNumberOfSuccessfulAllocations++;
+
+    return heapGRANULE_ADDRESS( xGranule );
+}
+
+/**
+ * @brief 释放 [xGranule, xGranule + xCount) 并更新统计。调用者必须持有 HEAP_LOCK。
+ */
+static void prvReleaseRun( size_t xGranule, size_t xCount )
+{
+    prvMarkRange( uxAllocatedMap, xGranule, xCount, 0 );
+    uxStartMap[ xGranule / heapBITS_PER_WORD ] &= ~heapBIT( xGranule );
+
+    if( xGranule < xLowestFreeGranule )
+    {
+        xLowestFreeGranule = xGranule;
+    }
+
+    xFreeBytesRemaining += xCount * configHEAP_GRANULE_SIZE;
+    xNumberOfSuccessfulFrees++;
+}
+
+/**
+ * @brief 检查 pv 是 pvPortMalloc 返回的、尚未释放的指针，返回其起始粒度编号。
+ */
+static size_t prvGranuleOf( const void * pv )
+{
+    size_t xGranule;
+
+    configASSERT( ( pucPool != NULL ) && ( ( const uint8_t * ) pv >= pucPool ) );
+    configASSERT( ( ( ( uintptr_t ) pv ) & ( configHEAP_GRANULE_SIZE - 1U ) ) == 0U );
+
+    xGranule = heapADDRESS_GRANULE( pv );
+
+    configASSERT( ( xGranule < xGranuleCount ) && heapTEST( uxStartMap, xGranule ) );
+
+    return xGranule;
+}
+
+/* --- 公共 API 实现 --- */
+
+void * pvPortMallocAligned( size_t xWantedSize, size_t xAlignment )
+{
+    void * pvReturn = NULL;
+    size_t xCount = prvGranulesFor( xWantedSize );
+    size_t xGranule;
+
+    configASSERT( ( xAlignment & ( xAlignment - 1 ) ) == 0 );
+
+    /* 不超过粒度大小的对齐天然满足 */
+    if( xCount > 0U )
+    {
+        HEAP_LOCK();
+        {
+            if( pucPool == NULL )
+            {
+                prvHeapInit();
+            }
+
+            xGranule = prvFindFreeRun( xCount, xAlignment );
+
+            if( xGranule < xGranuleCount )
+            {
+                pvReturn = prvClaimRun( xGranule, xCount );
+            }
+        }
+        HEAP_UNLOCK();
+    }
+
+    return pvReturn;
+}
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    return pvPortMallocAligned( xWantedSize, configHEAP_GRANULE_SIZE );
+}
+
+void * pvPortCalloc( size_t xNum, size_t xSize )
+{
+    void * pv = NULL;
+
+    if( ( xSize == 0U ) || ( xNum <= ( ( ( size_t ) -1 ) / xSize ) ) )
+    {
+        pv = pvPortMalloc( xNum * xSize );
+
+        if( pv != NULL )
+        {
+            ( void ) memset( pv, 0, xNum * xSize );
+        }
+    }
+
+    return pv;
+}
+
+void vPortFree( void * pv )
+{
+    size_t xGranule;
+
+    if( pv != NULL )
+    {
+        HEAP_LOCK();
+        {
+            xGranule = prvGranuleOf( pv );
+            prvReleaseRun( xGranule, prvBlockGranules( xGranule ) );
+        }
+        HEAP_UNLOCK();
+    }
+}
+
+void vPortFreeSized( void * pv, size_t xSize )
+{
+    size_t xGranule;
+    size_t xCount = prvGranulesFor( xSize );
+
+    if( pv != NULL )
+    {
+        HEAP_LOCK();
+        {
+            xGranule = prvGranuleOf( pv );
+
+            #if ( configHEAP_CHECK_SIZED_FREE == 1 )
+            {
+                configASSERT( xCount == prvBlockGranules( xGranule ) );
+            }
+            #endif
+
+            /* 块尾由大小直接算出，省去在位图中查找 */
+            prvReleaseRun( xGranule, xCount );
+        }
+        HEAP_UNLOCK();
+    }
+}
+
+size_t xPortGetAllocatedSize( void * pv )
+{
+    size_t xSize = 0U;
+
+    if( pv != NULL )
+    {
+        HEAP_LOCK();
+        {
+            xSize = prvBlockGranules( prvGranuleOf( pv ) ) * configHEAP_GRANULE_SIZE;
+        }
+        HEAP_UNLOCK();
+    }
+
+    return xSize;
+}
+
+void * pvPortRealloc( void * pv, size_t xWantedSize )
+{
+    void * pvReturn = NULL;
+    size_t xGranule;
+    size_t xCount;
+    size_t xNewCount;
+
+    if( pv == NULL )
+    {
+        return pvPortMalloc( xWantedSize );
+    }
+
+    if( xWantedSize == 0U )
+    {
+        vPortFree( pv );
+        return NULL;
+    }
+
+    xNewCount = prvGranulesFor( xWantedSize );
+
+    if( xNewCount == 0U )
+    {
+        return NULL;
+    }
+
+    HEAP_LOCK();
+    {
+        xGranule = prvGranuleOf( pv );
+        xCount = prvBlockGranules( xGranule );
+
+        if( xNewCount <= xCount )
+        {
+            /* 原地缩小：尾部粒度直接清位 */
+            if( xNewCount < xCount )
+            {
+                prvMarkRange( uxAllocatedMap, xGranule + xNewCount, xCount - xNewCount, 0 );
+                xFreeBytesRemaining += ( xCount - xNewCount ) * configHEAP_GRANULE_SIZE;
+
+                if( ( xGranule + xNewCount ) < xLowestFreeGranule )
+                {
+                    xLowestFreeGranule = xGranule + xNewCount;
+                }
+            }
+
+            pvReturn = pv;
+        }
+        else if( ( ( xNewCount - xCount ) <= ( xGranuleCount - xGranule - xCount ) ) &&
+                 ( prvNextBoundary( xGranule + xCount, xGranule + xNewCount, 0 ) == ( xGranule + xNewCount ) ) )
+        {
+            /* 原地扩大：紧随其后的粒度足够且全部空闲 */
+            prvMarkRange( uxAllocatedMap, xGranule + xCount, xNewCount - xCount, 1 );
+            xFreeBytesRemaining -= ( xNewCount - xCount ) * configHEAP_GRANULE_SIZE;
+
+            if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+            {
+                xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+            }
+
+            pvReturn = pv;
+        }
+    }
+    HEAP_UNLOCK();
+
+    if( pvReturn == NULL )
+    {
+        /* 原地无法扩大：分配新块、拷贝、释放旧块；失败时原块保持不变 */
+        pvReturn = pvPortMalloc( xWantedSize );
+
+        if( pvReturn != NULL )
+        {
+            ( void ) memcpy( pvReturn, pv, xCount * configHEAP_GRANULE_SIZE );
+            vPortFree( pv );
+        }
+    }
+
+    return pvReturn;
+}
+
+size_t xPortGetFreeHeapSize( void ) { return xFreeBytesRemaining; }
+size_t xPortGetMinimumEverFreeHeapSize( void ) { return xMinimumEverFreeBytesRemaining; }
@@ -0,0 +1,138 @@
+/*
+ * 基于 heap.c 的全局 operator new/delete 替换
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * 替换全部可替换的全局 operator new/delete（含 nothrow、带大小的 delete 以及 C++17 的
+ * std::align_val_t 版本），让所有 C++ 对象都从 heap.c 的堆中分配。
+ * 带大小的 delete 转到 vPortFreeSized，带对齐的 new 转到 pvPortMallocAligned。
+ * 低于 C++17 时不提供带对齐的版本，普通 new 直接转到 pvPortMalloc。
+ *
+ * 与 heap.c 一起编译链接即可生效，例如：
+ *   gcc -O2 -c heap.c && g++ -std=c++17 -O2 -c heap_new.cpp && g++ main.cpp heap.o heap_new.o
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "heap.h"
+
+/**
+ * @brief 分配失败且没有安装 std::new_handler 时的处理。
+ * 默认：开启异常时抛出 std::bad_alloc；以 -fno-exceptions 编译的固件中调用 abort()。
+ * 可在编译时定义为自己的处理函数（例如记录日志后复位），该函数不应返回。
+ */
+#ifndef configHEAP_NEW_FAILED_HOOK
+    #if defined( __cpp_exceptions ) || defined( __EXCEPTIONS )
+        #define configHEAP_NEW_FAILED_HOOK()    throw std::bad_alloc()
+    #else
+        #define configHEAP_NEW_FAILED_HOOK()    std::abort()
+    #endif
+#endif
+
+/* 普通 new 的对齐要求；0 表示没有 __STDCPP_DEFAULT_NEW_ALIGNMENT__（C++17 之前），使用 pvPortMalloc 的默认对齐 */
+#if defined( __cpp_aligned_new )
+    #define heapNEW_DEFAULT_ALIGNMENT    __STDCPP_DEFAULT_NEW_ALIGNMENT__
+#else
+    #define heapNEW_DEFAULT_ALIGNMENT    0
+#endif
+
+namespace
+{
+    /**
+     * @brief 所有 operator new 的公共实现。
+     * 按标准语义：分配失败时反复调用 std::new_handler，直到成功或没有 handler 为止。
+     * @param xThrow 为 false 时对应 nothrow 版本，失败返回 nullptr 而不调用失败钩子
+     */
+    void * prvNew( std::size_t xSize, std::size_t xAlignment, bool xThrow )
+    {
+        void * pv;
+
+        /* operator new(0) 必须返回一个唯一的非空指针 */
+        if( xSize == 0 )
+        {
+            xSize = 1;
+        }
+
+        while( ( pv = ( xAlignment == 0 ) ? pvPortMalloc( xSize ) : pvPortMallocAligned( xSize, xAlignment ) ) == nullptr )
+        {
+            std::new_handler pxHandler = std::get_new_handler();
+
+            if( pxHandler != nullptr )
+            {
+                pxHandler();
+            }
+            else if( xThrow )
+            {
+                configHEAP_NEW_FAILED_HOOK();
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        return pv;
+    }
+
+    /**
+     * @brief nothrow 版本的公共实现。
+     * std::new_handler 允许抛出 std::bad_alloc，异常不能越过 noexcept 的 nothrow 版本，
+     * 在这里捕获并按标准返回 nullptr。
+     */
+    void * prvNewNothrow( std::size_t xSize, std::size_t xAlignment ) noexcept
+    {
+        #if defined( __cpp_exceptions ) || defined( __EXCEPTIONS )
+            try
+            {
+                return prvNew( xSize, xAlignment, false );
+            }
+            catch( const std::bad_alloc & )
+            {
+                return nullptr;
+            }
+        #else
+            return prvNew( xSize, xAlignment, false );
+        #endif
+    }
+
+    inline void prvDeleteSized( void * pv, std::size_t xSize )
+    {
+        vPortFreeSized( pv, ( xSize == 0 ) ? 1 : xSize );
+    }
+}
+
+/* --- 普通版本 --- */
+
+void * operator new( std::size_t xSize ) { return prvNew( xSize, heapNEW_DEFAULT_ALIGNMENT, true ); }
+void * operator new[]( std::size_t xSize ) { return prvNew( xSize, heapNEW_DEFAULT_ALIGNMENT, true ); }
+void * operator new( std::size_t xSize, const std::nothrow_t & ) noexcept { return prvNewNothrow( xSize, heapNEW_DEFAULT_ALIGNMENT ); }
+void * operator new[]( std::size_t xSize, const std::nothrow_t & ) noexcept { return prvNewNothrow( xSize, heapNEW_DEFAULT_ALIGNMENT ); }
+
+void operator delete( void * pv ) noexcept { vPortFree( pv ); }
+void operator delete[]( void * pv ) noexcept { vPortFree( pv ); }
+void operator delete( void * pv, const std::nothrow_t & ) noexcept { vPortFree( pv ); }
+void operator delete[]( void * pv, const std::nothrow_t & ) noexcept { vPortFree( pv ); }
+
+/* --- 带大小的 delete（C++14） --- */
+
+void operator delete( void * pv, std::size_t xSize ) noexcept { prvDeleteSized( pv, xSize ); }
+void operator delete[]( void * pv, std::size_t xSize ) noexcept { prvDeleteSized( pv, xSize ); }
+
+/* --- 带对齐的版本（C++17） --- */
+
+#if defined( __cpp_aligned_new )
+
+void * operator new( std::size_t xSize, std::align_val_t xAlignment ) { return prvNew( xSize, static_cast< std::size_t >( xAlignment ), true ); }
+void * operator new[]( std::size_t xSize, std::align_val_t xAlignment ) { return prvNew( xSize, static_cast< std::size_t >( xAlignment ), true ); }
+void * operator new( std::size_t xSize, std::align_val_t xAlignment, const std::nothrow_t & ) noexcept { return prvNewNothrow( xSize, static_cast< std::size_t >( xAlignment ) ); }
+void * operator new[]( std::size_t xSize, std::align_val_t xAlignment, const std::nothrow_t & ) noexcept { return prvNewNothrow( xSize, static_cast< std::size_t >( xAlignment ) ); }
+
+void operator delete( void * pv, std::align_val_t ) noexcept { vPortFree( pv ); }
+void operator delete[]( void * pv, std::align_val_t ) noexcept { vPortFree( pv ); }
+void operator delete( void * pv, std::align_val_t, const std::nothrow_t & ) noexcept { vPortFree( pv ); }
+void operator delete[]( void * pv, std::align_val_t, const std::nothrow_t & ) noexcept { vPortFree( pv ); }
+void operator delete( void * pv, std::size_t xSize, std::align_val_t ) noexcept { prvDeleteSized( pv, xSize ); }
+void operator delete[]( void * pv, std::size_t xSize, std::align_val_t ) noexcept { prvDeleteSized( pv, xSize ); }
+
+#endif /* __cpp_aligned_new */
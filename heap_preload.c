@@ -0,0 +1,270 @@
+/*
+ * 基于 heap.c 的 malloc/free 替换层
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * 把标准 C 库的分配函数转发到 pvPortMalloc/vPortFree，编译成共享库后通过 LD_PRELOAD
+ * 注入任意 Linux 程序，便于在真实负载下与 glibc 对比 RSS 和吞吐量。
+ *
+ * 构建（heap.c 必须打开宿主机模式，堆池由 mmap 预留并按需扩展）：
+ *   gcc -O2 -fPIC -shared -DconfigHEAP_HOSTED=1 heap.c heap_preload.c -o libfreeheap.so -lpthread
+ * 使用：
+ *   LD_PRELOAD=./libfreeheap.so ./your_program
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "heap.h"
+
+/**
+ * @brief 引导区大小（字节）。
+ * 堆内部（或挂在堆上的钩子）若在持锁期间间接调用了 malloc，重入的请求由这块静态内存服务，
+ * 避免在同一把锁上自锁。引导区只分配不回收。
+ */
+#define preloadBOOTSTRAP_SIZE               ( ( size_t ) 64 * 1024 )
+
+/* 引导区分配的对齐字节数，与 glibc malloc 的保证一致 */
+#define preloadALIGNMENT                    ( ( size_t ) 16 )
+
+static uint8_t ucBootstrapHeap[ preloadBOOTSTRAP_SIZE ] __attribute__( ( aligned( 16 ) ) );
+static size_t xBootstrapUsed = 0U;
+
+/* 当前线程是否正处于堆函数内部；initial-exec 模型保证访问它本身不会触发分配 */
+static __thread int xInsideHeap __attribute__( ( tls_model( "initial-exec" ) ) ) = 0;
+
+#define preloadIS_BOOTSTRAP( pv )           ( ( ( uint8_t * ) ( pv ) >= ucBootstrapHeap ) && ( ( uint8_t * ) ( pv ) < ( ucBootstrapHeap + preloadBOOTSTRAP_SIZE ) ) )
+
+/**
+ * @brief 从引导区分配。每个对象前面用 preloadALIGNMENT 字节记录请求大小。
+ */
+static void * prvBootstrapAlloc( size_t xSize, size_t xAlignment )
+{
+    size_t xOffset, xTotal;
+    uint8_t * puc = NULL;
+
+    if( xAlignment < preloadALIGNMENT )
+    {
+        xAlignment = preloadALIGNMENT;
+    }
+
+    if( xSize <= preloadBOOTSTRAP_SIZE )
+    {
+        xTotal = ( ( xSize + preloadALIGNMENT - 1 ) & ~( preloadALIGNMENT - 1 ) ) + preloadALIGNMENT + xAlignment;
+        xOffset = __atomic_fetch_add( &xBootstrapUsed, xTotal, __ATOMIC_RELAXED );
+
+        if( ( xOffset + xTotal ) <= preloadBOOTSTRAP_SIZE )
+        {
+            puc = ( uint8_t * ) ( ( ( uintptr_t ) &ucBootstrapHeap[ xOffset + preloadALIGNMENT ] + xAlignment - 1 ) & ~( ( uintptr_t ) xAlignment - 1 ) );
+            *( size_t * ) ( puc - preloadALIGNMENT ) = xSize;
+        }
+    }
+
+    if( puc == NULL )
+    {
+        errno = ENOMEM;
+    }
+
+    return ( void * ) puc;
+}
+
+static size_t prvUsableSize( void * pv )
+{
+    return preloadIS_BOOTSTRAP( pv ) ? *( size_t * ) ( ( ( uint8_t * ) pv ) - preloadALIGNMENT ) : xPortGetAllocatedSize( pv );
+}
+
+/**
+ * @brief 所有带对齐的分配最终都走这里。
+ * glibc 的 malloc(0) 返回一个可释放的唯一指针，这里按 1 字节分配以保持相同语义。
+ */
+static void * prvAllocate( size_t xSize, size_t xAlignment )
+{
+    void * pv;
+
+    if( xInsideHeap != 0 )
+    {
+        pv = prvBootstrapAlloc( xSize, xAlignment );
+    }
+    else
+    {
+        xInsideHeap++;
+        pv = pvPortMallocAligned( ( xSize == 0 ) ? 1 : xSize, xAlignment );
+        xInsideHeap--;
+
+        if( pv == NULL )
+        {
+            errno = ENOMEM;
+        }
+    }
+
+    return pv;
+}
+
+void * malloc( size_t xSize )
+{
+    return prvAllocate( xSize, preloadALIGNMENT );
+}
+
+void free( void * pv )
+{
+    /* 引导区的对象不回收 */
+    if( ( pv != NULL ) && !preloadIS_BOOTSTRAP( pv ) )
+    {
+        xInsideHeap++;
+        vPortFree( pv );
+        xInsideHeap--;
+    }
+}
+
+void * calloc( size_t xNum, size_t xSize )
+{
+    void * pv = NULL;
+
+    if( ( xSize != 0 ) && ( xNum > ( ( ( size_t ) -1 ) / xSize ) ) )
+    {
+        errno = ENOMEM;
+    }
+    else if( xInsideHeap != 0 )
+    {
+        /* 引导区是静态内存且从不复用，天然为零 */
+        pv = prvBootstrapAlloc( xNum * xSize, preloadALIGNMENT );
+    }
+    else
+    {
+        xInsideHeap++;
+        pv = pvPortCalloc( 1, ( xNum * xSize == 0 ) ? 1 : xNum * xSize );
+        xInsideHeap--;
+
+        if( pv == NULL )
+        {
+            errno = ENOMEM;
+        }
+    }
+
+    return pv;
+}
+
+void * realloc( void * pv, size_t xSize )
+{
+    void * pvNew = NULL;
+    size_t xOldSize;
+
+    if( ( pv == NULL ) || preloadIS_BOOTSTRAP( pv ) || ( xInsideHeap != 0 ) )
+    {
+        /* 引导区对象或重入调用：重新分配并复制，旧对象不回收 */
+        pvNew = prvAllocate( xSize, preloadALIGNMENT );
+
+        if( ( pvNew != NULL ) && ( pv != NULL ) )
+        {
+            xOldSize = prvUsableSize( pv );
+            memcpy( pvNew, pv, ( xOldSize < xSize ) ? xOldSize : xSize );
+        }
+    }
+    else if( xSize == 0 )
+    {
+        free( pv );
+    }
+    else
+    {
+        xInsideHeap++;
+        pvNew = pvPortRealloc( pv, xSize );
+        xInsideHeap--;
+
+        if( pvNew == NULL )
+        {
+            errno = ENOMEM;
+        }
+    }
+
+    return pvNew;
+}
+
+void * reallocarray( void * pv, size_t xNum, size_t xSize )
+{
+    void * pvNew = NULL;
+
+    if( ( xSize != 0 ) && ( xNum > ( ( ( size_t ) -1 ) / xSize ) ) )
+    {
+        errno = ENOMEM;
+    }
+    else
+    {
+        pvNew = realloc( pv, xNum * xSize );
+    }
+
+    return pvNew;
+}
+
+int posix_memalign( void ** ppv, size_t xAlignment, size_t xSize )
+{
+    void * pv;
+    int xReturn = EINVAL;
+
+    if( ( xAlignment >= sizeof( void * ) ) && ( ( xAlignment & ( xAlignment - 1 ) ) == 0 ) )
+    {
+        pv = prvAllocate( xSize, xAlignment );
+        xReturn = ( pv != NULL ) ? 0 : ENOMEM;
+
+        if( pv != NULL )
+        {
+            *ppv = pv;
+        }
+    }
+
+    return xReturn;
+}
+
+void * aligned_alloc( size_t xAlignment, size_t xSize )
+{
+    void * pv = NULL;
+
+    if( ( xAlignment != 0 ) && ( ( xAlignment & ( xAlignment - 1 ) ) == 0 ) )
+    {
+        pv = prvAllocate( xSize, xAlignment );
+    }
+    else
+    {
+        errno = EINVAL;
+    }
+
+    return pv;
+}
+
+void * memalign( size_t xAlignment, size_t xSize )
+{
+    return aligned_alloc( xAlignment, xSize );
+}
+
+void * valloc( size_t xSize )
+{
+    return prvAllocate( xSize, ( size_t ) sysconf( _SC_PAGESIZE ) );
+}
+
+void * pvalloc( size_t xSize )
+{
+    size_t xPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+
+    /* 向上取整到页会回绕成 0，而 prvAllocate 会把 0 当作 1 字节分配 */
+    if( xSize > ( ( ( size_t ) -1 ) - ( xPageSize - 1 ) ) )
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    return prvAllocate( ( xSize + xPageSize - 1 ) & ~( xPageSize - 1 ), xPageSize );
+}
+
+size_t malloc_usable_size( void * pv )
+{
+    return ( pv != NULL ) ? prvUsableSize( pv ) : 0;
+}
+
+/**
+ * @brief 注册 fork 保护：fork 期间持有堆锁，父子进程中各自释放。
+ */
+__attribute__( ( constructor ) ) static void prvPreloadInit( void )
+{
+    ( void ) pthread_atfork( vPortHeapForkPrepare, vPortHeapForkRelease, vPortHeapForkRelease );
+}
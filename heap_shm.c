@@ -0,0 +1,492 @@
+/*
+ * 基于 heap.c 的跨进程共享内存堆
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * 与 heap.c 相同的首次适配 + 地址有序空闲链表 + 合并算法，区别在于：
+ * - 堆位于 POSIX 共享内存段中，控制块（链表头、统计计数、锁）放在段的开头；
+ * - 各进程可能把段映射到不同地址，因此链表中存放的是相对段起始处的偏移而不是指针；
+ * - 使用进程间共享的健壮（robust）互斥锁，持锁进程崩溃后由下一个加锁者校验空闲链表，
+ *   完好则继续使用，损坏则让锁永久不可恢复，之后的分配与释放都直接失败。
+ * 进程之间只传递偏移，由各自的 pvPortSharedHeapPointer 换算成本地地址，实现零拷贝。
+ *
+ * 构建：gcc -O2 -c heap_shm.c（链接时加 -lpthread，旧版 glibc 还需 -lrt）
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "heap.h"
+
+/* 与 heap.c 相同的对齐要求 */
+#define portBYTE_ALIGNMENT                  16
+#define portBYTE_ALIGNMENT_MASK             ( portBYTE_ALIGNMENT - 1 )
+
+#define configASSERT( x )                   if( ( x ) == 0 ) { abort(); }
+
+/**
+ * @brief 打开已有段时等待创建者完成初始化的最长时间（毫秒）。
+ * 创建者中途失败或崩溃、或同名段并非由本模块创建时，超时后 pxPortSharedHeapOpen 返回 NULL。
+ */
+#ifndef configSHM_OPEN_TIMEOUT_MS
+    #define configSHM_OPEN_TIMEOUT_MS       1000
+#endif
+
+/* 控制块标识 "FHSM"：用于识别段是否由本模块初始化 */
+#define shmHEAP_MAGIC                       ( ( uint32_t ) 0x4D534846UL )
+
+/* 最小空闲块大小：若分裂后的块小于此值，则不分裂 */
+#define heapMINIMUM_BLOCK_SIZE              ( ( size_t ) ( xSharedStructSize << 1 ) )
+
+/* 状态位：利用 size_t 的最高位标记该块是否已被分配（1:已分配，0:空闲） */
+#define heapBLOCK_ALLOCATED_BITMASK         ( ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * 8 ) - 1 ) )
+#define heapBLOCK_IS_ALLOCATED( pxBlock )   ( ( ( pxBlock->xBlockSize ) & heapBLOCK_ALLOCATED_BITMASK ) != 0 )
+#define heapALLOCATE_BLOCK( pxBlock )       ( ( pxBlock->xBlockSize ) |= heapBLOCK_ALLOCATED_BITMASK )
+#define heapFREE_BLOCK( pxBlock )           ( ( pxBlock->xBlockSize ) &= ~heapBLOCK_ALLOCATED_BITMASK )
+
+/* --- 数据结构 --- */
+
+/* 块头：链接用偏移表示，0 表示没有后继（段开头是控制块，不可能有块位于偏移 0） */
+typedef struct A_SHARED_BLOCK_LINK
+{
+    size_t xNextFreeOffset; /**< 链表中下一个空闲块相对段起始处的偏移 */
+    size_t xBlockSize;      /**< 当前块的大小（包含 Header 本身） */
+} SharedBlockLink_t;
+
+/* 控制块：位于共享内存段开头，所有进程看到的是同一份 */
+struct xSHARED_HEAP
+{
+    uint32_t ulMagic;                        /**< 初始化完成后才写入 shmHEAP_MAGIC */
+    pthread_mutex_t xMutex;                  /**< 进程间共享的健壮互斥锁 */
+    size_t xSegmentSize;                     /**< 段总字节数 */
+    SharedBlockLink_t xStart;                /**< 链表头（地址最低端） */
+    size_t xEndOffset;                       /**< 链表尾标记的偏移（地址最高端） */
+    size_t xFreeBytesRemaining;              /**< 当前可用总字节数 */
+    size_t xMinimumEverFreeBytesRemaining;   /**< 历史最低可用字节数（水位线） */
+    size_t xNumberOfSuccessfulAllocations;   /**< 成功分配次数计数 */
+    size_t xNumberOfSuccessfulFrees;         /**< 成功释放次数计数 */
+    size_t xNumberOfOwnerDeaths;             /**< 持锁进程崩溃后被接管的次数 */
+};
+
+/* 结构体 Header 实际占用的对齐后大小 */
+static const size_t xSharedStructSize = ( sizeof( SharedBlockLink_t ) + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+
+/* 控制块实际占用的对齐后大小，堆区从这里开始 */
+static const size_t xControlSize = ( sizeof( SharedHeap_t ) + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK;
+
+/* 偏移与本进程地址之间的换算 */
+#define shmBLOCK( pxHeap, xOffset )         ( ( SharedBlockLink_t * ) ( ( ( uint8_t * ) ( pxHeap ) ) + ( xOffset ) ) )
+#define shmOFFSET( pxHeap, pv )             ( ( size_t ) ( ( ( uint8_t * ) ( pv ) ) - ( ( uint8_t * ) ( pxHeap ) ) ) )
+
+/* 链表头在控制块中的偏移 */
+#define shmSTART_OFFSET                     offsetof( SharedHeap_t, xStart )
+
+/**
+ * @brief 从 xStart 遍历空闲链表，检查它是否完整。持锁进程崩溃后用来判断能否继续使用这个堆。
+ * 偏移必须严格递增并落在堆区内，空闲块不能带已分配标记、不能与后继相邻（否则应已合并），
+ * 链表必须终止于 xEndOffset，且空闲字节数之和与 xFreeBytesRemaining 一致。
+ * 崩溃发生在分裂或插入中途时，以上至少一项不成立。
+ * @return int 完好返回 1，损坏返回 0
+ */
+static int prvSharedHeapValid( SharedHeap_t * pxHeap )
+{
+    SharedBlockLink_t * pxBlock;
+    size_t xOffset = pxHeap->xStart.xNextFreeOffset;
+    size_t xPreviousEnd = xControlSize;
+    size_t xFreeBytes = 0;
+
+    if( ( pxHeap->xEndOffset <= xControlSize ) || ( pxHeap->xEndOffset > ( pxHeap->xSegmentSize - xSharedStructSize ) ) )
+    {
+        return 0;
+    }
+
+    while( xOffset != pxHeap->xEndOffset )
+    {
+        /* 第一个块可以紧贴控制块；之后的块至少与前一块隔开一个已分配块 */
+        if( ( xOffset < xPreviousEnd ) || ( ( xOffset == xPreviousEnd ) && ( xFreeBytes != 0 ) ) || ( xOffset > pxHeap->xEndOffset ) ||
+            ( ( xOffset & portBYTE_ALIGNMENT_MASK ) != 0 ) )
+        {
+            return 0;
+        }
+
+        pxBlock = shmBLOCK( pxHeap, xOffset );
+
+        if( heapBLOCK_IS_ALLOCATED( pxBlock ) || ( pxBlock->xBlockSize < xSharedStructSize ) ||
+            ( pxBlock->xBlockSize > ( pxHeap->xEndOffset - xOffset ) ) )
+        {
+            return 0;
+        }
+
+        xFreeBytes += pxBlock->xBlockSize;
+        xPreviousEnd = xOffset + pxBlock->xBlockSize;
+        xOffset = pxBlock->xNextFreeOffset;
+    }
+
+    return ( xPreviousEnd <= pxHeap->xEndOffset ) && ( shmBLOCK( pxHeap, pxHeap->xEndOffset )->xBlockSize == 0 ) &&
+           ( xFreeBytes == pxHeap->xFreeBytesRemaining );
+}
+
+/**
+ * @brief 获取进程间锁。上一个持锁进程崩溃时锁会以 EOWNERDEAD 交给我们：
+ * 空闲链表完好则把锁标记为一致并继续使用；损坏则不标记直接解锁，锁从此不可恢复，
+ * 之后所有加锁者都会得到 ENOTRECOVERABLE，而不是在损坏的链表上继续分配。
+ * @return int 成功持锁返回 1；堆已不可用时返回 0（此时未持锁）
+ */
+static int prvSharedLock( SharedHeap_t * pxHeap )
+{
+    int xResult = pthread_mutex_lock( &pxHeap->xMutex );
+
+    if( xResult == EOWNERDEAD )
+    {
+        if( prvSharedHeapValid( pxHeap ) != 0 )
+        {
+            ( void ) pthread_mutex_consistent( &pxHeap->xMutex );
+            pxHeap->xNumberOfOwnerDeaths++;
+            xResult = 0;
+        }
+        else
+        {
+            ( void ) pthread_mutex_unlock( &pxHeap->xMutex );
+            xResult = ENOTRECOVERABLE;
+        }
+    }
+
+    configASSERT( ( xResult == 0 ) || ( xResult == ENOTRECOVERABLE ) );
+
+    return ( xResult == 0 );
+}
+
+static void prvSharedUnlock( SharedHeap_t * pxHeap )
+{
+    ( void ) pthread_mutex_unlock( &pxHeap->xMutex );
+}
+
+/**
+ * @brief 将一个空闲块插入空闲链表。
+ * 链表按偏移从小到大排序，插入后会自动检查并合并前后相邻的空闲空间。
+ */
+static void prvInsertBlockIntoFreeList( SharedHeap_t * pxHeap, SharedBlockLink_t * pxBlockToInsert )
+{
+    SharedBlockLink_t * pxIterator;
+    size_t xInsertOffset = shmOFFSET( pxHeap, pxBlockToInsert );
+    size_t xIteratorOffset;
+
+    /* 寻找插入位置 */
+    for( pxIterator = &pxHeap->xStart; pxIterator->xNextFreeOffset < xInsertOffset; pxIterator = shmBLOCK( pxHeap, pxIterator->xNextFreeOffset ) ) {}
+
+    /* 检查是否能与前面的块合并 */
+    xIteratorOffset = shmOFFSET( pxHeap, pxIterator );
+    if( ( xIteratorOffset + pxIterator->xBlockSize ) == xInsertOffset )
+    {
+        pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+        pxBlockToInsert = pxIterator;
+        xInsertOffset = xIteratorOffset;
+    }
+
+    /* 检查是否能与后面的块合并 */
+    if( ( xInsertOffset + pxBlockToInsert->xBlockSize ) == pxIterator->xNextFreeOffset )
+    {
+        if( pxIterator->xNextFreeOffset != pxHeap->xEndOffset )
+        {
+            pxBlockToInsert->xBlockSize += shmBLOCK( pxHeap, pxIterator->xNextFreeOffset )->xBlockSize;
+            pxBlockToInsert->xNextFreeOffset = shmBLOCK( pxHeap, pxIterator->xNextFreeOffset )->xNextFreeOffset;
+        }
+        else
+        {
+            pxBlockToInsert->xNextFreeOffset = pxHeap->xEndOffset;
+        }
+    }
+    else
+    {
+        pxBlockToInsert->xNextFreeOffset = pxIterator->xNextFreeOffset;
+    }
+
+    if( pxIterator != pxBlockToInsert )
+    {
+        pxIterator->xNextFreeOffset = xInsertOffset;
+    }
+}
+
+/**
+ * @brief 初始化新建的段：建立控制块、锁和覆盖整个堆区的第一个空闲块。
+ */
+static void prvSharedHeapInit( SharedHeap_t * pxHeap, size_t xSegmentSize )
+{
+    SharedBlockLink_t * pxFirstFreeBlock, * pxEnd;
+    pthread_mutexattr_t xAttr;
+    size_t xEndOffset;
+
+    configASSERT( pthread_mutexattr_init( &xAttr ) == 0 );
+    configASSERT( pthread_mutexattr_setpshared( &xAttr, PTHREAD_PROCESS_SHARED ) == 0 );
+    configASSERT( pthread_mutexattr_setrobust( &xAttr, PTHREAD_MUTEX_ROBUST ) == 0 );
+    configASSERT( pthread_mutex_init( &pxHeap->xMutex, &xAttr ) == 0 );
+    ( void ) pthread_mutexattr_destroy( &xAttr );
+
+    xEndOffset = ( xSegmentSize - xSharedStructSize ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+    pxEnd = shmBLOCK( pxHeap, xEndOffset );
+    pxEnd->xBlockSize = 0;
+    pxEnd->xNextFreeOffset = 0;
+
+    pxFirstFreeBlock = shmBLOCK( pxHeap, xControlSize );
+    pxFirstFreeBlock->xBlockSize = xEndOffset - xControlSize;
+    pxFirstFreeBlock->xNextFreeOffset = xEndOffset;
+
+    pxHeap->xSegmentSize = xSegmentSize;
+    pxHeap->xStart.xNextFreeOffset = xControlSize;
+    pxHeap->xStart.xBlockSize = 0;
+    pxHeap->xEndOffset = xEndOffset;
+    pxHeap->xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+    pxHeap->xMinimumEverFreeBytesRemaining = pxHeap->xFreeBytesRemaining;
+    pxHeap->xNumberOfSuccessfulAllocations = 0;
+    pxHeap->xNumberOfSuccessfulFrees = 0;
+    pxHeap->xNumberOfOwnerDeaths = 0;
+
+    /* 最后发布标识，其他进程看到它才会开始使用这个段 */
+    __atomic_store_n( &pxHeap->ulMagic, shmHEAP_MAGIC, __ATOMIC_RELEASE );
+}
+
+/**
+ * @brief 等待创建者时的一次轮询：短暂休眠后检查是否已超过 configSHM_OPEN_TIMEOUT_MS。
+ * @param puxDeadline 截止时刻（单调时钟，纳秒），首次调用前置 0，由本函数设置
+ * @return int 仍可继续等待返回 1，已超时返回 0
+ */
+static int prvWaitForCreator( uint64_t * puxDeadline )
+{
+    const struct timespec xPause = { 0, 100000 };
+    struct timespec xNow;
+    uint64_t uxNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+    uxNow = ( ( uint64_t ) xNow.tv_sec * 1000000000U ) + ( uint64_t ) xNow.tv_nsec;
+
+    if( *puxDeadline == 0U )
+    {
+        *puxDeadline = uxNow + ( ( uint64_t ) configSHM_OPEN_TIMEOUT_MS * 1000000U );
+    }
+
+    if( uxNow >= *puxDeadline )
+    {
+        return 0;
+    }
+
+    ( void ) nanosleep( &xPause, NULL );
+
+    return 1;
+}
+
+/* --- 公共接口实现 --- */
+
+SharedHeap_t * pxPortSharedHeapOpen( const char * pcName, size_t xSegmentSize )
+{
+    SharedHeap_t * pxHeap = NULL;
+    struct stat xStat;
+    void * pvSegment;
+    uint64_t uxDeadline = 0U;
+    int xCreated = 1;
+    int xFd;
+
+    xSegmentSize = ( xSegmentSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+    /* 抢先创建的进程负责初始化，其余进程只是打开；段大小不足以建堆时只尝试打开已有段 */
+    if( xSegmentSize > ( xControlSize + ( 2 * xSharedStructSize ) + heapMINIMUM_BLOCK_SIZE ) )
+    {
+        xFd = shm_open( pcName, O_RDWR | O_CREAT | O_EXCL, 0600 );
+    }
+    else
+    {
+        xFd = -1;
+        errno = EEXIST;
+    }
+
+    if( ( xFd < 0 ) && ( errno == EEXIST ) )
+    {
+        xCreated = 0;
+        xFd = shm_open( pcName, O_RDWR, 0600 );
+    }
+
+    if( xFd >= 0 )
+    {
+        if( xCreated != 0 )
+        {
+            if( ftruncate( xFd, ( off_t ) xSegmentSize ) != 0 )
+            {
+                xSegmentSize = 0;
+            }
+        }
+        else
+        {
+            /* 等待创建者设置好段大小，之后以创建者的大小为准；超时视为创建失败 */
+            for( ; ; )
+            {
+                if( fstat( xFd, &xStat ) != 0 )
+                {
+                    xStat.st_size = 0;
+                    break;
+                }
+
+                if( ( xStat.st_size != 0 ) || ( prvWaitForCreator( &uxDeadline ) == 0 ) )
+                {
+                    break;
+                }
+            }
+
+            xSegmentSize = ( xStat.st_size > ( off_t ) xControlSize ) ? ( size_t ) xStat.st_size : 0;
+        }
+
+        if( xSegmentSize != 0 )
+        {
+            pvSegment = mmap( NULL, xSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, xFd, 0 );
+
+            if( pvSegment != MAP_FAILED )
+            {
+                pxHeap = ( SharedHeap_t * ) pvSegment;
+
+                if( xCreated != 0 )
+                {
+                    prvSharedHeapInit( pxHeap, xSegmentSize );
+                }
+                else
+                {
+                    while( ( __atomic_load_n( &pxHeap->ulMagic, __ATOMIC_ACQUIRE ) != shmHEAP_MAGIC ) &&
+                           ( prvWaitForCreator( &uxDeadline ) != 0 ) )
+                    {
+                    }
+
+                    /* 标识始终未出现（创建者崩溃或段不是本模块创建的），或记录的大小与段不符 */
+                    if( ( __atomic_load_n( &pxHeap->ulMagic, __ATOMIC_ACQUIRE ) != shmHEAP_MAGIC ) ||
+                        ( pxHeap->xSegmentSize != xSegmentSize ) )
+                    {
+                        ( void ) munmap( pvSegment, xSegmentSize );
+                        pxHeap = NULL;
+                    }
+                }
+            }
+        }
+
+        ( void ) close( xFd );
+
+        /* 创建者失败时删除自己创建的空段，否则之后的打开者会一直等待一个不会完成的初始化 */
+        if( ( xCreated != 0 ) && ( pxHeap == NULL ) )
+        {
+            ( void ) shm_unlink( pcName );
+        }
+    }
+
+    return pxHeap;
+}
+
+void vPortSharedHeapClose( SharedHeap_t * pxHeap )
+{
+    if( pxHeap != NULL )
+    {
+        ( void ) munmap( pxHeap, pxHeap->xSegmentSize );
+    }
+}
+
+int xPortSharedHeapUnlink( const char * pcName )
+{
+    return ( shm_unlink( pcName ) == 0 );
+}
+
+size_t xPortSharedMalloc( SharedHeap_t * pxHeap, size_t xWantedSize )
+{
+    SharedBlockLink_t * pxBlock, * pxPreviousBlock, * pxNewBlockLink;
+    size_t xReturn = 0;
+
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= ( ( ( size_t ) -1 ) >> 1 ) ) )
+    {
+        /* 加上 Header 的开销并进行对齐 */
+        xWantedSize = ( xWantedSize + xSharedStructSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+        if( prvSharedLock( pxHeap ) != 0 )
+        {
+            if( xWantedSize <= pxHeap->xFreeBytesRemaining )
+            {
+                pxPreviousBlock = &pxHeap->xStart;
+                pxBlock = shmBLOCK( pxHeap, pxHeap->xStart.xNextFreeOffset );
+
+                /* 寻找第一个足够大的空闲块（First Fit） */
+                while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->xNextFreeOffset != 0 ) )
+                {
+                    pxPreviousBlock = pxBlock;
+                    pxBlock = shmBLOCK( pxHeap, pxBlock->xNextFreeOffset );
+                }
+
+                if( shmOFFSET( pxHeap, pxBlock ) != pxHeap->xEndOffset )
+                {
+                    xReturn = pxPreviousBlock->xNextFreeOffset + xSharedStructSize;
+                    pxPreviousBlock->xNextFreeOffset = pxBlock->xNextFreeOffset;
+
+                    /* 如果剩余空间足够大，则分裂该块 */
+                    if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+                    {
+                        pxNewBlockLink = ( SharedBlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+                        pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+                        pxBlock->xBlockSize = xWantedSize;
+                        prvInsertBlockIntoFreeList( pxHeap, pxNewBlockLink );
+                    }
+
+                    pxHeap->xFreeBytesRemaining -= pxBlock->xBlockSize;
+                    if( pxHeap->xFreeBytesRemaining < pxHeap->xMinimumEverFreeBytesRemaining )
+                    {
+                        pxHeap->xMinimumEverFreeBytesRemaining = pxHeap->xFreeBytesRemaining;
+                    }
+
+                    heapALLOCATE_BLOCK( pxBlock ); /* 标记为已分配 */
+                    pxBlock->xNextFreeOffset = 0;
+                    pxHeap->xNumberOfSuccessfulAllocations++;
+                }
+            }
+
+            prvSharedUnlock( pxHeap );
+        }
+    }
+
+    return xReturn;
+}
+
+void vPortSharedFree( SharedHeap_t * pxHeap, size_t xOffset )
+{
+    SharedBlockLink_t * pxLink;
+
+    if( xOffset != 0 )
+    {
+        configASSERT( ( xOffset >= ( xControlSize + xSharedStructSize ) ) && ( xOffset < pxHeap->xEndOffset ) );
+
+        pxLink = shmBLOCK( pxHeap, xOffset - xSharedStructSize );
+
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+        configASSERT( pxLink->xNextFreeOffset == 0 );
+
+        /* 堆已不可恢复时块保持已分配状态，不再碰链表 */
+        if( ( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 ) && ( prvSharedLock( pxHeap ) != 0 ) )
+        {
+            heapFREE_BLOCK( pxLink );
+            pxHeap->xFreeBytesRemaining += pxLink->xBlockSize;
+            prvInsertBlockIntoFreeList( pxHeap, pxLink );
+            pxHeap->xNumberOfSuccessfulFrees++;
+
+            prvSharedUnlock( pxHeap );
+        }
+    }
+}
+
+void * pvPortSharedHeapPointer( SharedHeap_t * pxHeap, size_t xOffset )
+{
+    return ( xOffset != 0 ) ? ( void * ) ( ( ( uint8_t * ) pxHeap ) + xOffset ) : NULL;
+}
+
+size_t xPortSharedHeapOffset( SharedHeap_t * pxHeap, const void * pv )
+{
+    return ( pv != NULL ) ? shmOFFSET( pxHeap, pv ) : 0;
+}
+
+size_t xPortSharedHeapGetFreeSize( SharedHeap_t * pxHeap ) { return pxHeap->xFreeBytesRemaining; }
+size_t xPortSharedHeapGetMinimumEverFreeSize( SharedHeap_t * pxHeap ) { return pxHeap->xMinimumEverFreeBytesRemaining; }
@@ -0,0 +1,264 @@
+/*
+ * heap_bitmap.c 行为测试：无块头的紧密排列、块尾识别、对齐、原地 realloc 与首次适配
+ *
+ * 需要核对位图与粒度数，因此把 heap_bitmap.c 一起包含进来编译：
+ *   gcc -O2 test_bitmap.c -o test_bitmap && ./test_bitmap
+ */
+
+#include <stdio.h>
+#include "heap_bitmap.c"
+
+static int failures = 0;
+
+#define CHECK( cond )                                                              \
+    do {                                                                           \
+        if( !( cond ) )                                                            \
+        {                                                                          \
+            printf( "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond );             \
+            failures++;                                                            \
+        }                                                                          \
+    } while( 0 )
+
+#define GRANULE           configHEAP_GRANULE_SIZE
+#define ROUND_UP( x )     ( ( ( ( x ) + GRANULE - 1 ) / GRANULE ) * GRANULE )
+
+/* 一段测试结束后堆已完全复原：空闲字节数回到起点，位图全空，整个堆池能一次分配出来 */
+static void check_restored( const char * tag, size_t baseline )
+{
+    size_t i;
+    int clear = 1;
+    void * p;
+
+    CHECK( xPortGetFreeHeapSize() == baseline );
+
+    for( i = 0; i < heapMAP_WORDS; i++ )
+    {
+        clear &= ( uxAllocatedMap[ i ] == 0U ) && ( uxStartMap[ i ] == 0U );
+    }
+
+    CHECK( clear );
+
+    p = pvPortMalloc( baseline );
+    CHECK( p != NULL );
+    vPortFree( p );
+
+    CHECK( xPortGetFreeHeapSize() == baseline );
+    printf( "[%s] free %zu bytes\n", tag, xPortGetFreeHeapSize() );
+}
+
+// 1. 相邻分配之间没有块头，释放只清掉自己的粒度
+static void test_basic( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    uint8_t * a = pvPortMalloc( 1 );
+    uint8_t * b = pvPortMalloc( GRANULE );
+    uint8_t * c = pvPortMalloc( GRANULE + 1 );
+    uint8_t * d = pvPortMalloc( 8 );
+
+    CHECK( ( a != NULL ) && ( b != NULL ) && ( c != NULL ) && ( d != NULL ) );
+    CHECK( ( ( uintptr_t ) a % GRANULE ) == 0 );
+    CHECK( ( b == a + GRANULE ) && ( c == b + GRANULE ) && ( d == c + 2 * GRANULE ) );
+    CHECK( xPortGetFreeHeapSize() == baseline - 5 * GRANULE );
+
+    CHECK( pvPortMalloc( 0 ) == NULL );
+    CHECK( pvPortMalloc( baseline + 1 ) == NULL );
+    CHECK( pvPortCalloc( ( size_t ) -1 / 2, 4 ) == NULL );
+
+    /* 相邻的已分配块靠起始位区分 */
+    CHECK( xPortGetAllocatedSize( b ) == GRANULE );
+    CHECK( xPortGetAllocatedSize( c ) == 2 * GRANULE );
+
+    vPortFree( b );
+    CHECK( xPortGetAllocatedSize( a ) == GRANULE );
+    CHECK( xPortGetAllocatedSize( c ) == 2 * GRANULE );
+    CHECK( xPortGetFreeHeapSize() == baseline - 4 * GRANULE );
+
+    /* 空出的粒度最先被复用 */
+    b = pvPortMalloc( GRANULE );
+    CHECK( b == a + GRANULE );
+
+    vPortFree( c );
+    vPortFree( a );
+    vPortFree( d );
+    vPortFree( b );
+    vPortFree( NULL );
+
+    CHECK( xPortGetMinimumEverFreeHeapSize() <= baseline - 5 * GRANULE );
+    check_restored( "BASIC", baseline );
+}
+
+// 2. vPortFreeSized 按大小算出块尾，结果与 vPortFree 相同
+static void test_sized_free( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    void * a = pvPortMalloc( 100 );
+    void * b = pvPortMalloc( 40 );
+    uint8_t * c = pvPortCalloc( 10, 10 );
+    size_t i;
+    int zero = 1;
+
+    CHECK( ( a != NULL ) && ( b != NULL ) && ( c != NULL ) );
+
+    for( i = 0; i < 100; i++ )
+    {
+        zero &= ( c[ i ] == 0 );
+    }
+
+    CHECK( zero );
+
+    vPortFreeSized( a, 100 );
+    CHECK( xPortGetAllocatedSize( b ) == ROUND_UP( 40 ) );
+    vPortFreeSized( b, 40 );
+    vPortFreeSized( c, 100 );
+
+    check_restored( "SIZED_FREE", baseline );
+}
+
+// 3. 大于粒度的对齐要求跳过不满足对齐的空闲粒度
+static void test_aligned( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    void * a = pvPortMalloc( 8 );
+    void * b = pvPortMallocAligned( 100, 256 );
+    void * c = pvPortMallocAligned( 10, 1024 );
+    void * d = pvPortMalloc( 8 );
+
+    CHECK( ( a != NULL ) && ( b != NULL ) && ( c != NULL ) && ( d != NULL ) );
+    CHECK( ( ( uintptr_t ) b % 256 ) == 0 );
+    CHECK( ( ( uintptr_t ) c % 1024 ) == 0 );
+    CHECK( xPortGetAllocatedSize( b ) == ROUND_UP( 100 ) );
+
+    /* 对齐留下的空隙仍可供普通分配使用 */
+    CHECK( ( uint8_t * ) d == ( uint8_t * ) a + GRANULE );
+
+    vPortFree( a );
+    vPortFree( b );
+    vPortFree( c );
+    vPortFree( d );
+
+    check_restored( "ALIGNED", baseline );
+}
+
+static int is_pattern( const uint8_t * p, size_t size )
+{
+    size_t i;
+
+    for( i = 0; i < size; i++ )
+    {
+        if( p[ i ] != ( uint8_t ) i )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// 4. realloc：原地缩小、后面空闲时原地扩大、被挡住时搬移并保留内容
+static void test_realloc( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    uint8_t * a = pvPortMalloc( 64 );
+    uint8_t * b;
+    uint8_t * p;
+    size_t i;
+
+    for( i = 0; i < 64; i++ )
+    {
+        a[ i ] = ( uint8_t ) i;
+    }
+
+    p = pvPortRealloc( a, 32 );
+    CHECK( p == a );
+    CHECK( xPortGetAllocatedSize( a ) == 32 );
+    CHECK( xPortGetFreeHeapSize() == baseline - 32 );
+
+    p = pvPortRealloc( a, 128 );
+    CHECK( p == a );
+    CHECK( is_pattern( a, 32 ) );
+    CHECK( xPortGetFreeHeapSize() == baseline - 128 );
+
+    /* 后面紧挨着另一个块时只能搬移 */
+    b = pvPortMalloc( 16 );
+    CHECK( b == a + 128 );
+
+    p = pvPortRealloc( a, 200 );
+    CHECK( ( p != NULL ) && ( p != a ) );
+    CHECK( is_pattern( p, 32 ) );
+    CHECK( xPortGetAllocatedSize( p ) == ROUND_UP( 200 ) );
+
+    /* 失败时原块保持不变 */
+    CHECK( pvPortRealloc( p, baseline ) == NULL );
+    CHECK( xPortGetAllocatedSize( p ) == ROUND_UP( 200 ) );
+
+    CHECK( pvPortRealloc( p, 0 ) == NULL );
+    vPortFree( b );
+
+    p = pvPortRealloc( NULL, 16 );
+    CHECK( p != NULL );
+    vPortFree( p );
+
+    check_restored( "REALLOC", baseline );
+}
+
+// 5. 碎片化时的首次适配：返回地址最低的足够长的连续空闲段
+static void test_first_fit( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    static uint8_t * blocks[ 200 ];
+    uint8_t * p;
+    size_t i;
+
+    for( i = 0; i < 200; i++ )
+    {
+        blocks[ i ] = pvPortMalloc( GRANULE );
+    }
+
+    CHECK( blocks[ 199 ] == blocks[ 0 ] + 199 * GRANULE );
+
+    /* 释放奇数块，留下 100 个单粒度空洞；再释放第 120 块，第 119 到 121 块连成唯一的三粒度空洞 */
+    for( i = 1; i < 200; i += 2 )
+    {
+        vPortFree( blocks[ i ] );
+    }
+
+    vPortFree( blocks[ 120 ] );
+
+    p = pvPortMalloc( 3 * GRANULE );
+    CHECK( p == blocks[ 119 ] );
+
+    /* 两粒度的请求跨过所有单粒度空洞，落在与堆尾空闲区相连的第 199 块 */
+    blocks[ 199 ] = pvPortMalloc( 2 * GRANULE );
+    CHECK( blocks[ 199 ] == blocks[ 0 ] + 199 * GRANULE );
+    vPortFree( blocks[ 199 ] );
+
+    vPortFree( p );
+
+    for( i = 0; i < 200; i += 2 )
+    {
+        if( i != 120 )
+        {
+            vPortFree( blocks[ i ] );
+        }
+    }
+
+    check_restored( "FIRST_FIT", baseline );
+}
+
+int main( void )
+{
+    printf( "--- heap_bitmap.c behaviour tests ---\n\n" );
+
+    /* 先完成堆的初始化，各段以进入时的空闲量为基准 */
+    vPortFree( pvPortMalloc( 1 ) );
+
+    test_basic();
+    test_sized_free();
+    test_aligned();
+    test_realloc();
+    test_first_fit();
+
+    printf( "\n%s (%d failure%s)\n", ( failures == 0 ) ? "PASS" : "FAIL", failures, ( failures == 1 ) ? "" : "s" );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,1065 @@
+/*
+ * heap.c 行为测试：每个会改变堆结构的接口各有一段可判定的检查，失败时打印位置并以非 0 退出
+ *
+ * stress.c 只演示基本用法。可选功能的测试段随编译开关一起启用，开关必须同时传给两个文件，例如：
+ *   gcc -O2 test_heap.c heap.c -o test_heap && ./test_heap
+ *   gcc -O2 -DconfigHEAP_INTEGRITY_CHECK=1 -DconfigHEAP_RELOCATABLE_HANDLES=1 test_heap.c heap.c -o test_heap
+ * 宿主机模式（-DconfigHEAP_HOSTED=1）链接时加 -lpthread。
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "heap.h"
+
+#if defined( configHEAP_SNAPSHOT ) && ( configHEAP_SNAPSHOT == 1 )
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+/* 与 heap.c 相同的默认值，测试据此决定要检查的行为 */
+#ifndef configHEAP_HOSTED
+    #define configHEAP_HOSTED                   0
+#endif
+
+#ifndef configHEAP_CLEAR_MEMORY_ON_FREE
+    #define configHEAP_CLEAR_MEMORY_ON_FREE     1
+#endif
+
+static int failures = 0;
+
+#define CHECK( cond )                                                              \
+    do {                                                                           \
+        if( !( cond ) )                                                            \
+        {                                                                          \
+            printf( "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond );             \
+            failures++;                                                            \
+        }                                                                          \
+    } while( 0 )
+
+/* 堆结构是否完好：启用完整性检查时做完整遍历，否则只能相信计数 */
+static int heap_consistent( void )
+{
+#if defined( configHEAP_INTEGRITY_CHECK ) && ( configHEAP_INTEGRITY_CHECK == 1 )
+    return xPortHeapCheck();
+#else
+    return 1;
+#endif
+}
+
+/* 延迟清零模式下释放的块先进入待清零队列，需要排空后才回到空闲链表 */
+static void drain_pending( void )
+{
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 4 )
+    xPortHeapClearPending( ( size_t ) -1 );
+#endif
+}
+
+/*
+ * 检查一段测试结束后堆已完全复原：空闲字节数回到起点，结构完好，
+ * 并且能一次分配出几乎全部空闲空间（说明相邻空闲块确实合并了）。
+ */
+static void check_restored( const char * tag, size_t baseline )
+{
+    void * p;
+
+    drain_pending();
+    CHECK( xPortGetFreeHeapSize() == baseline );
+    CHECK( heap_consistent() );
+
+    p = pvPortMalloc( baseline - 64 );
+    CHECK( p != NULL );
+    vPortFree( p );
+    drain_pending();
+
+    CHECK( xPortGetFreeHeapSize() == baseline );
+    printf( "[%s] free %zu bytes\n", tag, xPortGetFreeHeapSize() );
+}
+
+static int is_filled( const void * p, int value, size_t size )
+{
+    const uint8_t * bytes = p;
+    size_t i;
+
+    for( i = 0; i < size; i++ )
+    {
+        if( bytes[ i ] != ( uint8_t ) value )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// 基本分配、释放顺序与合并
+static void test_basic( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    void * a = pvPortMalloc( 100 );
+    void * b = pvPortMalloc( 200 );
+    void * c = pvPortMalloc( 300 );
+
+    CHECK( ( a != NULL ) && ( b != NULL ) && ( c != NULL ) );
+    CHECK( ( ( uintptr_t ) a % 8 == 0 ) && ( ( uintptr_t ) b % 8 == 0 ) && ( ( uintptr_t ) c % 8 == 0 ) );
+
+    /* 先释放中间块，再释放两侧：三块应合并回一个空闲块 */
+    vPortFree( b );
+    CHECK( heap_consistent() );
+    vPortFree( a );
+    vPortFree( c );
+    vPortFree( NULL );
+
+    CHECK( pvPortMalloc( 0 ) == NULL );
+    CHECK( pvPortMalloc( ( size_t ) -1 ) == NULL );
+
+    check_restored( "BASIC", baseline );
+}
+
+// user-026: Arena 的递增分配、检查点回滚与销毁
+static void test_arena( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    size_t after_grow;
+    HeapArena_t * arena = pxPortArenaCreate( 256 );
+    HeapArenaMark_t mark;
+    uint8_t * first;
+    uint8_t * p;
+    uint8_t * q;
+    int i;
+
+    CHECK( arena != NULL );
+
+    first = pvPortArenaAlloc( arena, 10 );
+    p = pvPortArenaAlloc( arena, 10 );
+    CHECK( ( first != NULL ) && ( ( uintptr_t ) first % 8 == 0 ) );
+    CHECK( p == first + 16 );
+    CHECK( pvPortArenaAlloc( arena, 0 ) == NULL );
+
+    /* 超出当前块时追加新块，超过块大小的请求单独成块 */
+    mark = xPortArenaMark( arena );
+    memset( p, 0x5A, 10 );
+
+    for( i = 0; i < 20; i++ )
+    {
+        CHECK( pvPortArenaAlloc( arena, 48 ) != NULL );
+    }
+
+    q = pvPortArenaAlloc( arena, 1000 );
+    CHECK( q != NULL );
+    CHECK( is_filled( p, 0x5A, 10 ) );
+    after_grow = xPortGetFreeHeapSize();
+    CHECK( after_grow < baseline );
+
+    /* 回滚后从检查点处继续分配，追加的块留在链上复用，不再向堆申请 */
+    vPortArenaRewind( arena, mark );
+    CHECK( pvPortArenaAlloc( arena, 10 ) == p + 16 );
+
+    for( i = 0; i < 20; i++ )
+    {
+        CHECK( pvPortArenaAlloc( arena, 48 ) != NULL );
+    }
+
+    CHECK( xPortGetFreeHeapSize() == after_grow );
+
+    vPortArenaReset( arena );
+    CHECK( pvPortArenaAlloc( arena, 10 ) == first );
+    CHECK( heap_consistent() );
+
+    vPortArenaDestroy( arena );
+    vPortArenaDestroy( NULL );
+
+    check_restored( "ARENA", baseline );
+}
+
+// user-027: 批量分配与批量释放
+static void test_batch( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    void * blocks[ 24 ];
+    void * loose = pvPortMalloc( 40 );
+    size_t i, j;
+
+    CHECK( pvPortMallocBatch( 48, 20, blocks ) == blocks[ 0 ] );
+
+    for( i = 0; i < 20; i++ )
+    {
+        CHECK( blocks[ i ] != NULL );
+        memset( blocks[ i ], ( int ) i, 48 );
+
+        for( j = 0; j < i; j++ )
+        {
+            CHECK( blocks[ i ] != blocks[ j ] );
+        }
+    }
+
+    for( i = 0; i < 20; i++ )
+    {
+        CHECK( is_filled( blocks[ i ], ( int ) i, 48 ) );
+    }
+
+    /* 打乱顺序并混入 NULL 与单独分配的块 */
+    for( i = 0; i < 20; i += 3 )
+    {
+        void * t = blocks[ i ];
+        blocks[ i ] = blocks[ 19 - i ];
+        blocks[ 19 - i ] = t;
+    }
+
+    blocks[ 20 ] = NULL;
+    blocks[ 21 ] = loose;
+    blocks[ 22 ] = NULL;
+    vPortFreeBatch( blocks, 23 );
+    CHECK( heap_consistent() );
+
+    /* 放不下时整批失败，不留下已分配的块 */
+    CHECK( pvPortMallocBatch( ( size_t ) -1 / 8, 4, blocks ) == NULL );
+    CHECK( ( blocks[ 0 ] == NULL ) && ( blocks[ 3 ] == NULL ) );
+    CHECK( pvPortMallocBatch( 48, 0, blocks ) == NULL );
+
+    check_restored( "BATCH", baseline );
+}
+
+// user-028: 带大小的释放：整个块的可用空间都要清零
+static void test_sized_free( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    uint8_t * keep = pvPortMalloc( 16 );
+    uint8_t * p = pvPortMalloc( 100 );
+    uint8_t * q;
+    size_t usable;
+
+    memset( p, 0xAB, 100 );
+    vPortFreeSized( p, 100 );
+
+    /* 缩小得太少不值得分裂，块保持原大小，尾部仍留有旧数据，释放时同样要清掉 */
+    q = pvPortMalloc( 200 );
+    memset( q, 0xCD, 200 );
+    p = pvPortRealloc( q, 196 );
+    usable = xPortGetAllocatedSize( p );
+    CHECK( ( p == q ) && ( usable >= 200 ) );
+    vPortFreeSized( p, 196 );
+
+#if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 ) || ( configHEAP_CLEAR_MEMORY_ON_FREE == 2 )
+    CHECK( is_filled( p, 0, usable ) );
+#endif
+
+    vPortFreeSized( keep, 16 );
+    vPortFreeSized( NULL, 0 );
+
+    check_restored( "SIZED_FREE", baseline );
+}
+
+// user-029: realloc 原地扩大、原地缩小、搬移，内容保持不变
+static void test_realloc( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    uint8_t * p = pvPortRealloc( NULL, 64 );
+    uint8_t * q;
+    void * blocker;
+
+    CHECK( p != NULL );
+    CHECK( xPortGetAllocatedSize( p ) >= 64 );
+    memset( p, 0x11, 64 );
+
+    /* 后面是空闲空间：原地扩大 */
+    q = pvPortRealloc( p, 256 );
+    CHECK( q == p );
+    CHECK( is_filled( q, 0x11, 64 ) );
+    p = q;
+
+    /* 原地缩小 */
+    q = pvPortRealloc( p, 32 );
+    CHECK( q == p );
+    CHECK( is_filled( q, 0x11, 32 ) );
+    p = q;
+
+    /* 后面被占用：必须搬移 */
+    blocker = pvPortMalloc( 16 );
+    q = pvPortRealloc( p, 1024 );
+    CHECK( ( q != NULL ) && ( q != p ) );
+    CHECK( is_filled( q, 0x11, 32 ) );
+    p = q;
+
+    /* 失败时原内存保持不变 */
+    CHECK( pvPortRealloc( p, ( size_t ) -1 / 2 ) == NULL );
+    CHECK( is_filled( p, 0x11, 32 ) );
+
+    CHECK( pvPortRealloc( p, 0 ) == NULL );
+    vPortFree( blocker );
+
+    /* calloc 清零并检查乘法溢出 */
+    p = pvPortCalloc( 10, 10 );
+    CHECK( ( p != NULL ) && is_filled( p, 0, 100 ) );
+    vPortFree( p );
+    CHECK( pvPortCalloc( ( size_t ) -1, 16 ) == NULL );
+
+    check_restored( "REALLOC", baseline );
+}
+
+// user-029: 对齐分配
+static void test_aligned( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    void * p[ 7 ];
+    size_t alignment, i = 0;
+
+    for( alignment = 16; alignment <= 1024; alignment <<= 1 )
+    {
+        p[ i ] = pvPortMallocAligned( 40, alignment );
+        CHECK( ( p[ i ] != NULL ) && ( ( uintptr_t ) p[ i ] % alignment == 0 ) );
+        CHECK( xPortGetAllocatedSize( p[ i ] ) >= 40 );
+        i++;
+    }
+
+    CHECK( heap_consistent() );
+
+    while( i > 0 )
+    {
+        vPortFree( p[ --i ] );
+    }
+
+    check_restored( "ALIGNED", baseline );
+}
+
+#if defined( configHEAP_FRAGMENTATION_METRICS ) && ( configHEAP_FRAGMENTATION_METRICS == 1 )
+
+/* 直方图各桶之和应等于空闲块总数 */
+static size_t histogram_total( const HeapFragmentationStats_t * stats )
+{
+    size_t i, total = 0;
+
+    for( i = 0; i < heapFRAGMENTATION_HISTOGRAM_BUCKETS; i++ )
+    {
+        total += stats->xFreeBlockHistogram[ i ];
+    }
+
+    return total;
+}
+
+// user-031: 增量维护的碎片化指标与实际空闲链表一致
+static void test_fragmentation( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    HeapFragmentationStats_t before, holed, after;
+    void * blocks[ 10 ];
+    void * p;
+    size_t i;
+
+    vPortGetHeapFragmentationStats( &before );
+    CHECK( before.xAvailableHeapSpaceInBytes == baseline );
+    CHECK( histogram_total( &before ) == before.xNumberOfFreeBlocks );
+
+    for( i = 0; i < 10; i++ )
+    {
+        blocks[ i ] = pvPortMalloc( 64 );
+    }
+
+    /* 隔一个释放一个：多出 5 个互不相邻的小空闲块 */
+    for( i = 0; i < 10; i += 2 )
+    {
+        vPortFree( blocks[ i ] );
+    }
+
+    drain_pending();
+    vPortGetHeapFragmentationStats( &holed );
+    CHECK( holed.xNumberOfFreeBlocks == before.xNumberOfFreeBlocks + 5 );
+    CHECK( histogram_total( &holed ) == holed.xNumberOfFreeBlocks );
+    CHECK( holed.xAvailableHeapSpaceInBytes == xPortGetFreeHeapSize() );
+    CHECK( holed.xFragmentationPerMille > before.xFragmentationPerMille );
+    CHECK( holed.xNumberOfSearches > before.xNumberOfSearches );
+
+    /* 最大空闲块确实能一次分配出来 */
+    p = pvPortMalloc( holed.xSizeOfLargestFreeBlockInBytes - 64 );
+    CHECK( p != NULL );
+    vPortFree( p );
+
+    for( i = 1; i < 10; i += 2 )
+    {
+        vPortFree( blocks[ i ] );
+    }
+
+    drain_pending();
+    vPortGetHeapFragmentationStats( &after );
+    CHECK( after.xNumberOfFreeBlocks == before.xNumberOfFreeBlocks );
+    CHECK( after.xSizeOfLargestFreeBlockInBytes == before.xSizeOfLargestFreeBlockInBytes );
+    CHECK( after.xFragmentationPerMille == before.xFragmentationPerMille );
+
+    check_restored( "FRAGMENTATION", baseline );
+}
+
+#endif
+
+#if defined( configHEAP_RELOCATABLE_HANDLES ) && ( configHEAP_RELOCATABLE_HANDLES == 1 )
+
+// user-032: 可重定位句柄与整理：对象被移动后内容不变，空洞被合并
+static void test_handles( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    HeapHandle_t handles[ 8 ];
+    void * holes[ 8 ];
+    void * pinned_at;
+    uint8_t * first_at;
+    size_t i;
+    int steps = 0;
+
+    for( i = 0; i < 8; i++ )
+    {
+        holes[ i ] = pvPortMalloc( 256 );
+        handles[ i ] = xPortHandleAlloc( 128 );
+        CHECK( handles[ i ] != 0 );
+        memset( pvPortHandlePin( handles[ i ] ), ( int ) ( 0x40 + i ), 128 );
+        vPortHandleUnpin( handles[ i ] );
+    }
+
+    for( i = 0; i < 8; i++ )
+    {
+        vPortFree( holes[ i ] );
+    }
+
+    drain_pending();
+
+    first_at = pvPortHandlePin( handles[ 0 ] );
+    vPortHandleUnpin( handles[ 0 ] );
+
+    /* 钉住的对象不能移动 */
+    pinned_at = pvPortHandlePin( handles[ 5 ] );
+
+    while( ( xPortHeapCompactStep( 4 ) != 0 ) && ( steps < 1000 ) )
+    {
+        steps++;
+    }
+
+    CHECK( steps < 1000 );
+    CHECK( pvPortHandlePin( handles[ 5 ] ) == pinned_at );
+    vPortHandleUnpin( handles[ 5 ] );
+    vPortHandleUnpin( handles[ 5 ] );
+    CHECK( heap_consistent() );
+
+    for( i = 0; i < 8; i++ )
+    {
+        CHECK( is_filled( pvPortHandlePin( handles[ i ] ), ( int ) ( 0x40 + i ), 128 ) );
+        vPortHandleUnpin( handles[ i ] );
+    }
+
+    /* 第一个对象前面原本隔着一个空洞，整理后应向低地址移动 */
+    CHECK( ( uint8_t * ) pvPortHandlePin( handles[ 0 ] ) < first_at );
+    vPortHandleUnpin( handles[ 0 ] );
+
+    for( i = 0; i < 8; i++ )
+    {
+        vPortHandleFree( handles[ i ] );
+    }
+
+    CHECK( pvPortHandlePin( 0 ) == NULL );
+
+    check_restored( "HANDLES", baseline );
+}
+
+#endif
+
+#if defined( configHEAP_SNAPSHOT ) && ( configHEAP_SNAPSHOT == 1 )
+
+typedef struct node
+{
+    struct node * next;
+    int value;
+} node_t;
+
+static const char snapshot_path[] = "test_heap.snapshot";
+static int snapshot_pipe[ 2 ];
+static pid_t snapshot_child;
+
+/*
+ * 恢复必须发生在堆第一次使用之前，并且地址与保存时相同：在任何分配之前 fork 出子进程，
+ * 子进程等父进程保存完快照后再恢复并校验。
+ */
+static void snapshot_fork_restorer( void )
+{
+    char go;
+    node_t * root;
+    node_t * next;
+    int count = 0, sum = 0;
+
+    if( ( pipe( snapshot_pipe ) != 0 ) || ( ( snapshot_child = fork() ) < 0 ) )
+    {
+        snapshot_child = -1;
+        return;
+    }
+
+    if( snapshot_child != 0 )
+    {
+        close( snapshot_pipe[ 0 ] );
+        return;
+    }
+
+    close( snapshot_pipe[ 1 ] );
+
+    if( read( snapshot_pipe[ 0 ], &go, 1 ) != 1 )
+    {
+        _exit( 2 );
+    }
+
+    root = pvPortHeapSnapshotRestore( snapshot_path );
+
+    for( ; root != NULL; root = next )
+    {
+        next = root->next;
+        count++;
+        sum += root->value;
+        vPortFree( root );
+    }
+
+    _exit( ( ( count == 50 ) && ( sum == 49 * 50 / 2 ) && heap_consistent() ) ? 0 : 1 );
+}
+
+// user-033: 快照保存与恢复：恢复后链表完整，节点可以正常释放
+static void test_snapshot( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    node_t * head = NULL;
+    node_t * node;
+    void * junk[ 50 ];
+    int i, status = -1;
+
+    CHECK( snapshot_child > 0 );
+
+    for( i = 0; i < 50; i++ )
+    {
+        node = pvPortMalloc( sizeof( node_t ) );
+        node->value = i;
+        node->next = head;
+        head = node;
+        junk[ i ] = pvPortMalloc( 24 + ( size_t ) i );
+    }
+
+    /* 空闲链表中留下空洞，保存时要把链接转换为偏移 */
+    for( i = 0; i < 50; i += 2 )
+    {
+        vPortFree( junk[ i ] );
+    }
+
+    CHECK( xPortHeapSnapshotSave( snapshot_path, head ) == 1 );
+    CHECK( heap_consistent() );
+
+    if( snapshot_child > 0 )
+    {
+        CHECK( write( snapshot_pipe[ 1 ], "g", 1 ) == 1 );
+        CHECK( waitpid( snapshot_child, &status, 0 ) == snapshot_child );
+        CHECK( WIFEXITED( status ) && ( WEXITSTATUS( status ) == 0 ) );
+    }
+
+    unlink( snapshot_path );
+
+    for( i = 1; i < 50; i += 2 )
+    {
+        vPortFree( junk[ i ] );
+    }
+
+    while( head != NULL )
+    {
+        node = head->next;
+        vPortFree( head );
+        head = node;
+    }
+
+    check_restored( "SNAPSHOT", baseline );
+}
+
+#endif
+
+#if defined( configHEAP_INTEGRITY_CHECK ) && ( configHEAP_INTEGRITY_CHECK == 1 )
+
+// user-037: 完整检查与增量检查都能发现被改写的块头，恢复后重新通过
+static void test_integrity( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    void * blocks[ 30 ];
+    size_t * size_field;
+    size_t saved, passes;
+    size_t i;
+    int steps, found;
+
+    for( i = 0; i < 30; i++ )
+    {
+        blocks[ i ] = pvPortMalloc( 32 + i );
+    }
+
+    for( i = 0; i < 30; i += 3 )
+    {
+        vPortFree( blocks[ i ] );
+        blocks[ i ] = NULL;
+    }
+
+    /* 增量检查每次只走 4 个块，反复调用直到完成一整轮 */
+    passes = xPortGetHeapCheckPasses();
+
+    for( steps = 0; ( xPortGetHeapCheckPasses() == passes ) && ( steps < 1000 ); steps++ )
+    {
+        CHECK( xPortHeapCheckStep( 4 ) == 1 );
+    }
+
+    CHECK( xPortGetHeapCheckPasses() > passes );
+    CHECK( steps > 1 );
+
+    /* 块头最后一个字段是块大小：改写为一个不对齐、也没有已分配标记的值 */
+    size_field = ( size_t * ) blocks[ 10 ] - 1;
+    saved = *size_field;
+    *size_field = 0x1235;
+
+    CHECK( xPortHeapCheck() == 0 );
+
+    for( steps = 0, found = 0; ( steps < 1000 ) && ( found == 0 ); steps++ )
+    {
+        found = ( xPortHeapCheckStep( 4 ) == 0 );
+    }
+
+    CHECK( found );
+
+    *size_field = saved;
+    CHECK( xPortHeapCheck() == 1 );
+
+    for( i = 0; i < 30; i++ )
+    {
+        vPortFree( blocks[ i ] );
+    }
+
+    check_restored( "INTEGRITY", baseline );
+}
+
+#endif
+
+// user-040: 带生命周期提示的分配：长期对象放在高端，短期对象放在低端
+static void test_hinted( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    void * short_lived = pvPortMallocHinted( 64, eHeapShortLived );
+    void * long_lived = pvPortMallocHinted( 64, eHeapLongLived );
+    void * plain = pvPortMalloc( 64 );
+
+    CHECK( ( short_lived != NULL ) && ( long_lived != NULL ) && ( plain != NULL ) );
+    CHECK( ( uintptr_t ) long_lived > ( uintptr_t ) short_lived );
+    CHECK( ( uintptr_t ) long_lived > ( uintptr_t ) plain );
+    CHECK( xPortGetAllocatedSize( long_lived ) >= 64 );
+    CHECK( heap_consistent() );
+
+    /* 长期对象从高端切下，释放后要与前面的空闲空间重新合并 */
+    vPortFree( long_lived );
+    vPortFree( plain );
+    vPortFree( short_lived );
+
+    check_restored( "HINTED", baseline );
+}
+
+#if defined( configHEAP_OWNER_QUOTAS ) && ( configHEAP_OWNER_QUOTAS == 1 )
+
+// user-041: 所有者配额：硬上限拒绝分配，释放按块头中的所有者归还，与当前所有者无关
+static void test_quotas( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    HeapOwnerStats_t stats;
+    void * a;
+    void * b;
+    void * batch[ 4 ];
+
+    vPortHeapSetOwnerLimits( 1, 0, 1000 );
+    vPortHeapSetCurrentOwner( 1 );
+
+    a = pvPortMalloc( 600 );
+    b = pvPortMalloc( 600 );
+    CHECK( a != NULL );
+    CHECK( b == NULL );
+
+    /* 其他分配入口同样受上限约束 */
+    CHECK( pvPortMallocAligned( 600, 64 ) == NULL );
+    CHECK( pvPortMallocBatch( 200, 4, batch ) == NULL );
+
+    vPortHeapSetCurrentOwner( 0 );
+    b = pvPortMalloc( 600 );
+    CHECK( b != NULL );
+
+    vPortGetHeapOwnerStats( 1, &stats );
+    CHECK( stats.xLiveBytes >= 600 );
+    CHECK( stats.xHardLimitFailures == 3 );
+
+    vPortFree( a );
+    vPortGetHeapOwnerStats( 1, &stats );
+    CHECK( stats.xLiveBytes == 0 );
+    CHECK( stats.xPeakBytes >= 600 );
+
+    vPortFree( b );
+    vPortHeapSetOwnerLimits( 1, 0, 0 );
+
+    check_restored( "QUOTAS", baseline );
+}
+
+#endif
+
+#if defined( configHEAP_RECLAIM_CALLBACKS ) && ( configHEAP_RECLAIM_CALLBACKS == 1 )
+
+typedef struct
+{
+    void * cache;
+    size_t cache_size;
+    int calls;
+} ReclaimState_t;
+
+/* 回收回调：记录调用次数，有缓存时释放它 */
+static size_t reclaim_cb( size_t needed, void * context )
+{
+    ReclaimState_t * state = context;
+    size_t released = state->cache_size;
+
+    ( void ) needed;
+    state->calls++;
+
+    vPortFree( state->cache );
+    state->cache = NULL;
+    state->cache_size = 0;
+
+    return released;
+}
+
+// user-042: 水位线回调跌破时只触发一次，回升后重新生效；分配失败时回收并重试
+static void test_reclaim( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    ReclaimState_t mark = { NULL, 0, 0 };
+    void * a;
+    void * b;
+    void * c;
+
+    CHECK( xPortHeapRegisterReclaim( reclaim_cb, &mark, 0, baseline - 4096 ) );
+
+    a = pvPortMalloc( 2000 );
+    CHECK( mark.calls == 0 );
+
+    b = pvPortMalloc( 3000 );
+    CHECK( mark.calls == 1 );
+
+    /* 仍在水位线之下，不再重复触发 */
+    c = pvPortMalloc( 100 );
+    CHECK( mark.calls == 1 );
+    vPortFree( c );
+
+    /* 回升到水位线之上后的下一次分配让回调重新生效 */
+    vPortFree( b );
+    drain_pending();
+    c = pvPortMalloc( 100 );
+    CHECK( mark.calls == 1 );
+
+    b = pvPortMalloc( 3000 );
+    CHECK( mark.calls == 2 );
+
+    vPortFree( a );
+    vPortFree( b );
+    vPortFree( c );
+    vPortHeapUnregisterReclaim( reclaim_cb, &mark );
+
+#if ( configHEAP_HOSTED == 0 )
+    {
+        ReclaimState_t cache = { NULL, 0, 0 };
+
+        /* 水位线为 0 的回调只在分配失败时调用，释放缓存后重试成功 */
+        drain_pending();
+        cache.cache_size = xPortGetFreeHeapSize() / 2;
+        cache.cache = pvPortMalloc( cache.cache_size );
+        CHECK( cache.cache != NULL );
+        CHECK( xPortHeapRegisterReclaim( reclaim_cb, &cache, 0, 0 ) );
+
+        a = pvPortMalloc( baseline * 3 / 4 );
+        CHECK( a != NULL );
+        CHECK( cache.calls == 1 );
+        CHECK( cache.cache == NULL );
+
+        vPortFree( a );
+        vPortHeapUnregisterReclaim( reclaim_cb, &cache );
+    }
+#endif
+
+    check_restored( "RECLAIM", baseline );
+}
+
+#endif
+
+#if defined( configHEAP_EMERGENCY_RESERVE_SIZE ) && ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 ) && ( configHEAP_HOSTED == 0 )
+
+// user-043: 紧急储备区：主堆耗尽后关键分配仍能成功，释放后归还储备区
+static void test_reserve( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    static void * fill[ 1024 ];
+    HeapReserveStats_t before, after;
+    void * critical;
+    size_t count = 0;
+
+    vPortGetHeapReserveStats( &before );
+
+    while( ( count < 1024 ) && ( ( fill[ count ] = pvPortMalloc( 64 ) ) != NULL ) )
+    {
+        count++;
+    }
+
+    CHECK( pvPortMalloc( 64 ) == NULL );
+
+    critical = pvPortMallocCritical( 64 );
+    CHECK( critical != NULL );
+
+    vPortGetHeapReserveStats( &after );
+    CHECK( after.xAllocations == before.xAllocations + 1 );
+    CHECK( after.xFreeBytes < before.xFreeBytes );
+
+    vPortFree( critical );
+    vPortGetHeapReserveStats( &after );
+    CHECK( after.xFreeBytes == before.xFreeBytes );
+
+    while( count > 0 )
+    {
+        vPortFree( fill[ --count ] );
+    }
+
+    check_restored( "RESERVE", baseline );
+}
+
+#endif
+
+// user-044: 碎片化时的首次适配：必须返回地址最低的合适空闲块（启用空闲块索引时走索引路径）
+static void test_first_fit( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    static void * blocks[ 200 ];
+    void * hole;
+    void * p;
+    size_t i;
+
+    for( i = 0; i < 200; i++ )
+    {
+        blocks[ i ] = pvPortMalloc( 64 );
+        CHECK( blocks[ i ] != NULL );
+    }
+
+    /* 释放奇数块，留下约 100 个放不下 100 字节的小空洞 */
+    for( i = 1; i < 200; i += 2 )
+    {
+        vPortFree( blocks[ i ] );
+    }
+
+    /* 再释放第 120 块，与两侧空洞合并成唯一能放下 150 字节的空洞，起点是原第 119 块 */
+    hole = blocks[ 119 ];
+    vPortFree( blocks[ 120 ] );
+    blocks[ 120 ] = NULL;
+    drain_pending();
+
+    p = pvPortMalloc( 150 );
+    CHECK( p == hole );
+
+    for( i = 1; i < 200; i += 2 )
+    {
+        blocks[ i ] = NULL;
+    }
+    CHECK( heap_consistent() );
+
+    /* 小请求落在最低的空洞（第 1 块的位置） */
+    blocks[ 1 ] = pvPortMalloc( 32 );
+    CHECK( ( uint8_t * ) blocks[ 1 ] < ( uint8_t * ) blocks[ 2 ] );
+    CHECK( ( uint8_t * ) blocks[ 1 ] > ( uint8_t * ) blocks[ 0 ] );
+
+    vPortFree( p );
+
+    for( i = 0; i < 200; i++ )
+    {
+        vPortFree( blocks[ i ] );
+    }
+
+    check_restored( "FIRST_FIT", baseline );
+}
+
+#if defined( configHEAP_LARGE_OBJECT_THRESHOLD ) && ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+
+#define LARGE    ( ( size_t ) configHEAP_LARGE_OBJECT_THRESHOLD )
+
+#if defined( configHEAP_SAMPLING_PROFILER ) && ( configHEAP_SAMPLING_PROFILER == 1 )
+
+static const char profile_path[] = "test_heap.prof";
+
+/* 从剖析输出的首行读出存活样本的个数与字节数 */
+static int profile_live( size_t * count, size_t * bytes )
+{
+    FILE * f;
+    int ok;
+
+    if( !xPortHeapProfileDump( profile_path, 0 ) || ( ( f = fopen( profile_path, "r" ) ) == NULL ) )
+    {
+        return 0;
+    }
+
+    ok = ( fscanf( f, "heap profile: %zu: %zu", count, bytes ) == 2 );
+    fclose( f );
+    remove( profile_path );
+
+    return ok;
+}
+
+#endif
+
+// user-047: 大对象直接映射：mremap 调整大小保留内容，缩到阈值以下移回堆池，批量分配同样走映射
+static void test_large( void )
+{
+    size_t baseline = xPortGetFreeHeapSize();
+    HeapLargeObjectStats_t before, after;
+    void * batch[ 3 ];
+    uint8_t * p;
+    size_t i;
+
+    vPortGetHeapLargeObjectStats( &before );
+
+    p = pvPortMalloc( LARGE * 2 );
+    CHECK( p != NULL );
+    CHECK( xPortGetFreeHeapSize() == baseline );
+
+    for( i = 0; i < 64; i++ )
+    {
+        p[ i ] = ( uint8_t ) i;
+    }
+
+    vPortGetHeapLargeObjectStats( &after );
+    CHECK( after.xAllocations == before.xAllocations + 1 );
+    CHECK( after.xMappedBytes >= before.xMappedBytes + LARGE * 2 );
+
+    p = pvPortRealloc( p, LARGE * 8 );
+    CHECK( p != NULL );
+    p = pvPortRealloc( p, LARGE );
+    CHECK( p != NULL );
+    vPortGetHeapLargeObjectStats( &after );
+    CHECK( after.xRemaps == before.xRemaps + 2 );
+    CHECK( after.xPeakMappedBytes >= before.xMappedBytes + LARGE * 8 );
+
+    /* 缩到阈值以下：复制到堆池并解除映射 */
+    p = pvPortRealloc( p, 100 );
+    CHECK( p != NULL );
+    vPortGetHeapLargeObjectStats( &after );
+    CHECK( after.xFrees == before.xFrees + 1 );
+    CHECK( after.xMappedBytes == before.xMappedBytes );
+
+    for( i = 0; i < 64; i++ )
+    {
+        CHECK( p[ i ] == ( uint8_t ) i );
+    }
+
+    vPortFree( p );
+
+    CHECK( pvPortMallocBatch( LARGE, 3, batch ) == batch[ 0 ] );
+    CHECK( ( batch[ 0 ] != NULL ) && ( batch[ 1 ] != NULL ) && ( batch[ 2 ] != NULL ) );
+    vPortGetHeapLargeObjectStats( &after );
+    CHECK( after.xAllocations == before.xAllocations + 4 );
+
+    for( i = 0; i < 3; i++ )
+    {
+        vPortFree( batch[ i ] );
+    }
+
+    vPortGetHeapLargeObjectStats( &after );
+    CHECK( after.xFrees == before.xFrees + 4 );
+    CHECK( after.xMappedBytes == before.xMappedBytes );
+
+#if defined( configHEAP_SAMPLING_PROFILER ) && ( configHEAP_SAMPLING_PROFILER == 1 )
+    {
+        size_t count0, bytes0, count, bytes;
+
+        /* 反复分配同样大小的块，直到其中一个被采样 */
+        CHECK( profile_live( &count0, &bytes0 ) );
+        p = NULL;
+
+        for( i = 0; ( i < 1000 ) && ( p == NULL ); i++ )
+        {
+            p = pvPortMalloc( LARGE );
+            CHECK( profile_live( &count, &bytes ) );
+
+            if( count == count0 )
+            {
+                vPortFree( p );
+                p = NULL;
+            }
+        }
+
+        CHECK( p != NULL );
+        count0 = count;
+        bytes0 = bytes;
+
+        /* 样本跟随 mremap 改到新地址与新大小，释放时注销 */
+        p = pvPortRealloc( p, LARGE * 16 );
+        CHECK( profile_live( &count, &bytes ) );
+        CHECK( ( count == count0 ) && ( bytes == bytes0 - LARGE + LARGE * 16 ) );
+
+        p = pvPortRealloc( p, LARGE * 2 );
+        CHECK( profile_live( &count, &bytes ) );
+        CHECK( ( count == count0 ) && ( bytes == bytes0 - LARGE + LARGE * 2 ) );
+
+        vPortFree( p );
+        CHECK( profile_live( &count, &bytes ) );
+        CHECK( ( count == count0 - 1 ) && ( bytes == bytes0 - LARGE ) );
+    }
+#endif
+
+    check_restored( "LARGE", baseline );
+}
+
+#endif
+
+int main( void )
+{
+    printf( "--- heap.c behaviour tests ---\n\n" );
+
+#if defined( configHEAP_SNAPSHOT ) && ( configHEAP_SNAPSHOT == 1 )
+    snapshot_fork_restorer();
+#endif
+
+    /* 先完成堆的初始化，各段以进入时的空闲量为基准（宿主机模式下堆会增长） */
+    vPortFree( pvPortMalloc( 1 ) );
+    drain_pending();
+
+    test_basic();
+    test_arena();
+    test_batch();
+    test_sized_free();
+    test_realloc();
+    test_aligned();
+    test_hinted();
+    test_first_fit();
+
+#if defined( configHEAP_FRAGMENTATION_METRICS ) && ( configHEAP_FRAGMENTATION_METRICS == 1 )
+    test_fragmentation();
+#endif
+
+#if defined( configHEAP_RELOCATABLE_HANDLES ) && ( configHEAP_RELOCATABLE_HANDLES == 1 )
+    test_handles();
+#endif
+
+#if defined( configHEAP_SNAPSHOT ) && ( configHEAP_SNAPSHOT == 1 )
+    test_snapshot();
+#endif
+
+#if defined( configHEAP_INTEGRITY_CHECK ) && ( configHEAP_INTEGRITY_CHECK == 1 )
+    test_integrity();
+#endif
+
+#if defined( configHEAP_OWNER_QUOTAS ) && ( configHEAP_OWNER_QUOTAS == 1 )
+    test_quotas();
+#endif
+
+#if defined( configHEAP_RECLAIM_CALLBACKS ) && ( configHEAP_RECLAIM_CALLBACKS == 1 )
+    test_reclaim();
+#endif
+
+#if defined( configHEAP_EMERGENCY_RESERVE_SIZE ) && ( configHEAP_EMERGENCY_RESERVE_SIZE > 0 ) && ( configHEAP_HOSTED == 0 )
+    test_reserve();
+#endif
+
+#if defined( configHEAP_LARGE_OBJECT_THRESHOLD ) && ( configHEAP_LARGE_OBJECT_THRESHOLD > 0 )
+    test_large();
+#endif
+
+    printf( "\n%s (%d failure%s)\n", ( failures == 0 ) ? "PASS" : "FAIL", failures, ( failures == 1 ) ? "" : "s" );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+/*
+ * heap_shm.c 行为测试：跨进程分配与释放、打开失败、持锁进程崩溃后的接管
+ *
+ * 需要直接操作控制块里的锁来模拟崩溃，因此把 heap_shm.c 一起包含进来编译：
+ *   gcc -O2 -DconfigSHM_OPEN_TIMEOUT_MS=100 test_shm.c -o test_shm -lpthread && ./test_shm
+ */
+
+#include <stdio.h>
+#include <sys/wait.h>
+#include "heap_shm.c"
+
+static int failures = 0;
+
+#define CHECK( cond )                                                              \
+    do {                                                                           \
+        if( !( cond ) )                                                            \
+        {                                                                          \
+            printf( "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond );             \
+            failures++;                                                            \
+        }                                                                          \
+    } while( 0 )
+
+static char name[ 64 ];
+
+/* 在子进程中运行 fn，返回其退出码 */
+static int run_child( int ( * fn )( void ) )
+{
+    int status = -1;
+    pid_t pid = fork();
+
+    if( pid == 0 )
+    {
+        _exit( fn() );
+    }
+
+    if( ( pid < 0 ) || ( waitpid( pid, &status, 0 ) != pid ) || !WIFEXITED( status ) )
+    {
+        return -1;
+    }
+
+    return WEXITSTATUS( status );
+}
+
+static size_t child_offset;
+
+/* 子进程：另行打开同一个段，分配一块写入内容，把偏移留在段里交给父进程 */
+static int child_alloc( void )
+{
+    SharedHeap_t * heap = pxPortSharedHeapOpen( name, 0 );
+    size_t offset, * slot;
+
+    if( heap == NULL )
+    {
+        return 1;
+    }
+
+    offset = xPortSharedMalloc( heap, 100 );
+
+    if( offset == 0 )
+    {
+        return 2;
+    }
+
+    memset( pvPortSharedHeapPointer( heap, offset ), 0x77, 100 );
+    slot = pvPortSharedHeapPointer( heap, child_offset );
+    *slot = offset;
+    vPortSharedHeapClose( heap );
+
+    return 0;
+}
+
+// 1. 基本分配、合并，以及跨进程传递偏移
+static void test_shared_alloc( void )
+{
+    SharedHeap_t * heap = pxPortSharedHeapOpen( name, 64 * 1024 );
+    size_t baseline, a, b, c, * slot;
+    uint8_t * p;
+    int i, ok = 1;
+
+    CHECK( heap != NULL );
+    if( heap == NULL )
+    {
+        return;
+    }
+
+    baseline = xPortSharedHeapGetFreeSize( heap );
+
+    a = xPortSharedMalloc( heap, 100 );
+    b = xPortSharedMalloc( heap, 200 );
+    c = xPortSharedMalloc( heap, 300 );
+    CHECK( ( a != 0 ) && ( b != 0 ) && ( c != 0 ) );
+    CHECK( ( a % 16 == 0 ) && ( b > a ) && ( c > b ) );
+    CHECK( xPortSharedHeapOffset( heap, pvPortSharedHeapPointer( heap, b ) ) == b );
+    CHECK( xPortSharedMalloc( heap, 0 ) == 0 );
+    CHECK( xPortSharedMalloc( heap, 1024 * 1024 ) == 0 );
+
+    vPortSharedFree( heap, b );
+    vPortSharedFree( heap, a );
+    vPortSharedFree( heap, c );
+    vPortSharedFree( heap, 0 );
+    CHECK( xPortSharedHeapGetFreeSize( heap ) == baseline );
+    CHECK( prvSharedHeapValid( heap ) );
+
+    /* 子进程映射地址可能不同，只通过偏移交换数据 */
+    child_offset = xPortSharedMalloc( heap, sizeof( size_t ) );
+    CHECK( run_child( child_alloc ) == 0 );
+
+    slot = pvPortSharedHeapPointer( heap, child_offset );
+    p = pvPortSharedHeapPointer( heap, *slot );
+
+    for( i = 0; i < 100; i++ )
+    {
+        ok &= ( p[ i ] == 0x77 );
+    }
+
+    CHECK( ok );
+    vPortSharedFree( heap, *slot );
+    vPortSharedFree( heap, child_offset );
+
+    CHECK( xPortSharedHeapGetFreeSize( heap ) == baseline );
+    CHECK( xPortSharedHeapGetMinimumEverFreeSize( heap ) < baseline );
+    CHECK( xPortSharedMalloc( heap, baseline - 64 ) != 0 );
+
+    vPortSharedHeapClose( heap );
+    printf( "[SHARED_ALLOC] done\n" );
+}
+
+// 2. 同名段不是本模块创建的：等待超时后返回 NULL
+static void test_open_foreign( void )
+{
+    int fd;
+
+    CHECK( xPortSharedHeapUnlink( name ) );
+
+    fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+    CHECK( ( fd >= 0 ) && ( ftruncate( fd, 64 * 1024 ) == 0 ) );
+    close( fd );
+
+    CHECK( pxPortSharedHeapOpen( name, 64 * 1024 ) == NULL );
+    CHECK( xPortSharedHeapUnlink( name ) );
+
+    printf( "[OPEN_FOREIGN] done\n" );
+}
+
+static SharedHeap_t * crash_heap;
+
+/* 子进程：持锁时直接退出，链表保持完好 */
+static int child_die_holding_lock( void )
+{
+    pthread_mutex_lock( &crash_heap->xMutex );
+    return 0;
+}
+
+/* 子进程：模拟在分裂中途崩溃：块已从链表摘下，但空闲计数还没有更新 */
+static int child_die_mid_split( void )
+{
+    SharedBlockLink_t * pxFirst;
+
+    pthread_mutex_lock( &crash_heap->xMutex );
+    pxFirst = shmBLOCK( crash_heap, crash_heap->xStart.xNextFreeOffset );
+    crash_heap->xStart.xNextFreeOffset = pxFirst->xNextFreeOffset;
+    return 0;
+}
+
+// 3. 持锁进程崩溃：链表完好时接管继续使用，损坏时堆不可恢复
+static void test_owner_death( void )
+{
+    size_t a, b;
+
+    crash_heap = pxPortSharedHeapOpen( name, 64 * 1024 );
+    CHECK( crash_heap != NULL );
+    if( crash_heap == NULL )
+    {
+        return;
+    }
+
+    CHECK( run_child( child_die_holding_lock ) == 0 );
+    a = xPortSharedMalloc( crash_heap, 64 );
+    CHECK( a != 0 );
+    CHECK( crash_heap->xNumberOfOwnerDeaths == 1 );
+    vPortSharedFree( crash_heap, a );
+
+    b = xPortSharedMalloc( crash_heap, 64 );
+    CHECK( run_child( child_die_mid_split ) == 0 );
+    CHECK( xPortSharedMalloc( crash_heap, 64 ) == 0 );
+    CHECK( crash_heap->xNumberOfOwnerDeaths == 1 );
+    CHECK( pthread_mutex_lock( &crash_heap->xMutex ) == ENOTRECOVERABLE );
+
+    /* 之后的分配和释放都直接失败，不再碰链表 */
+    CHECK( xPortSharedMalloc( crash_heap, 64 ) == 0 );
+    vPortSharedFree( crash_heap, b );
+
+    vPortSharedHeapClose( crash_heap );
+    CHECK( xPortSharedHeapUnlink( name ) );
+
+    printf( "[OWNER_DEATH] done\n" );
+}
+
+int main( void )
+{
+    printf( "--- heap_shm.c behaviour tests ---\n\n" );
+
+    snprintf( name, sizeof( name ), "/test_shm_%d", ( int ) getpid() );
+    ( void ) shm_unlink( name );
+
+    test_shared_alloc();
+    test_open_foreign();
+    test_owner_death();
+
+    printf( "\n%s (%d failure%s)\n", ( failures == 0 ) ? "PASS" : "FAIL", failures, ( failures == 1 ) ? "" : "s" );
+
+    return ( failures == 0 ) ? 0 : 1;
+}